@@ -0,0 +1,62 @@
+/*
+ * alloc_count.h contains:
+ *   - A counting operator new, for benchmarks of heap allocations
+ *   - A timed run of a program that counts the allocations it makes
+ *
+ * Include it from one benchmark only: it replaces the global operator
+ * new and delete of the program it is linked into
+ */
+
+#ifndef QI_BENCH_ALLOC_COUNT_H
+#define QI_BENCH_ALLOC_COUNT_H
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+#include "heap.h"
+#include "interpreter.h"
+#include "null_buffer.h"
+
+// objects come from the object heap, and the rest from operator new
+static std::size_t allocations = 0;
+
+void *operator new(std::size_t size) {
+    ++allocations;
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept {
+    std::free(p);
+}
+
+/// the run time of a program and the heap allocations it made
+struct counted_run {
+    double seconds;
+    std::size_t allocations;
+};
+
+/// runs a program with its output discarded, and counts the objects
+/// and other heap allocations it makes
+/// \param runtime: the program
+/// \return the run time and allocation count of the run
+static counted_run run_counted(interpreter &runtime) {
+    null_buffer discard;
+    std::streambuf *out = std::cout.rdbuf(&discard);
+    std::size_t before = allocations + heap::total;
+    auto start = std::chrono::high_resolution_clock::now();
+    runtime.execute();
+    double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+    std::size_t count = allocations + heap::total - before;
+    std::cout.rdbuf(out);
+    return {seconds, count};
+}
+
+#endif //QI_BENCH_ALLOC_COUNT_H
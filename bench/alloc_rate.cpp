@@ -0,0 +1,40 @@
+/*
+ * alloc_rate.cpp contains:
+ *   - Allocation benchmark, in heap allocations per second and in all,
+ *     and the run time of a program on an engine
+ *   - Given how many calls or loop passes the program makes, their rate
+ *     and the heap allocations of each
+ */
+
+#include <iostream>
+#include <string>
+
+#include "alloc_count.h"
+#include "fstream.h"
+#include "interpreter.h"
+#include "lexer.h"
+#include "options.h"
+#include "token.h"
+
+int main(int argc, char *argv[]) {
+    if (argc != 4 && argc != 6)
+        err("usage: alloc_rate <file.qi> <label> <tree|vm|jit> [<count> <call|pass>]");
+    std::string engine = argv[3];
+    options::jobs = 1;
+    // the jit compiles every function on its first call
+    options::engine = engine == "jit" ? "tree" : engine;
+    options::jit = engine == "jit" ? "on" : "off";
+    interpreter runtime(lexer(fstream(argv[1])).tokenize());
+
+    counted_run run = run_counted(runtime);
+    std::cout << argv[2] << " (" << engine << "): " << run.seconds * 1000 << " ms, " << run.allocations
+              << " allocations, " << (double) run.allocations / run.seconds / 1e6 << " M allocations/s";
+    if (argc == 6) {
+        double count = std::stod(argv[4]);
+        std::string unit = argv[5];
+        std::cout << ", " << count / run.seconds / 1e6 << " M " << (unit == "pass" ? "passes" : unit + "s")
+                  << "/s, " << (double) run.allocations / count << " allocations per " << unit;
+    }
+    std::cout << std::endl;
+    return 0;
+}
@@ -0,0 +1,111 @@
+/*
+ * ast_walk.cpp contains:
+ *   - Memory and walk time benchmark for the parsed and flat syntax
+ *     trees of a program
+ */
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ast.h"
+#include "ast_node.h"
+#include "fstream.h"
+#include "lexer.h"
+#include "token.h"
+
+/// counts the heap memory of a parsed tree: every node lives in the
+/// children buffer of its parent, and every buffer is one allocation
+/// \param u: the root of the tree
+/// \return the memory held by the children of u, in bytes
+std::size_t tree_bytes(const ast_node &u) {
+    std::size_t bytes = u.children.capacity() * sizeof(ast_node);
+    if (u.children.capacity())
+        bytes += 16;
+    for (const ast_node &v : u.children)
+        bytes += tree_bytes(v);
+    return bytes;
+}
+
+/// walks a parsed tree in DFS order
+/// \param u: the root of the tree
+/// \return the sum of the visited symbol ids
+std::uint64_t walk_tree(const ast_node &u) {
+    std::uint64_t sum = u.val.val;
+    for (const ast_node &v : u.children)
+        sum += walk_tree(v);
+    return sum;
+}
+
+/// walks a flat tree in DFS order, following the sibling links
+/// \param tree: the flat tree
+/// \param u: the index of the root
+/// \return the sum of the visited symbol ids
+std::uint64_t walk_flat(const ast &tree, std::uint32_t u) {
+    std::uint64_t sum = tree[u].val;
+    for (std::uint32_t v = u + 1; v < tree[u].end; v = tree[v].end)
+        sum += walk_flat(tree, v);
+    return sum;
+}
+
+/// times repeated walks over every function
+/// \param walk: walks one function and returns its checksum
+/// \param functions: the number of functions
+/// \param repeats: the number of walks over all functions
+/// \return nanoseconds per walk over all functions
+template<typename F>
+double time_walks(F walk, std::size_t functions, int repeats) {
+    std::uint64_t sum = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int r = 0; r < repeats; ++r)
+        for (std::size_t i = 0; i < functions; ++i)
+            sum += walk(i);
+    auto stop = std::chrono::high_resolution_clock::now();
+    if (sum == 0)
+        std::cout << "";
+    return std::chrono::duration<double, std::nano>(stop - start).count() / repeats;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 2)
+        err("usage: ast_walk <file.qi>");
+    std::string file_name = argv[1];
+
+    token_buffer buffer(lexer(fstream(file_name)).tokenize());
+    token_span tokens = buffer.span();
+
+    // parse every function body into both representations
+    std::vector <std::unique_ptr<ast_node>> trees;
+    std::vector <std::unique_ptr<ast>> flats;
+    for (const std::pair<int, int> &block : ast_node::gen_blocks(tokens, false)) {
+        int start = block.first;
+        while (start < block.second && tokens[start].val != s_start)
+            ++start;
+        if (tokens[block.first].val != s_fn)
+            continue;
+        trees.push_back(std::make_unique<ast_node>(tokens.sub(start + 2, block.second - 1)));
+        flats.push_back(std::make_unique<ast>(*trees.back()));
+    }
+
+    std::size_t nodes = 0, t_bytes = 0, f_bytes = 0;
+    for (std::size_t i = 0; i < trees.size(); ++i) {
+        nodes += flats[i]->nodes.size();
+        t_bytes += sizeof(ast_node) + tree_bytes(*trees[i]);
+        f_bytes += flats[i]->bytes();
+    }
+
+    // repeat small programs so every measurement walks ~10^7 nodes
+    int repeats = (int) std::max<std::size_t>(1, 10000000 / std::max<std::size_t>(nodes, 1));
+    double t_ns = time_walks([&](std::size_t i) { return walk_tree(*trees[i]); }, trees.size(), repeats);
+    double f_ns = time_walks([&](std::size_t i) { return walk_flat(*flats[i], 0); }, flats.size(), repeats);
+
+    double mb = 1 << 20;
+    std::string name = file_name.substr(file_name.find_last_of('/') + 1);
+    std::cout << name << ": " << nodes << " nodes | tree " << t_bytes << " B, " << (std::size_t) (nodes / (t_bytes / mb))
+              << " nodes/MB, " << t_ns / nodes << " ns/node | flat " << f_bytes << " B, "
+              << (std::size_t) (nodes / (f_bytes / mb)) << " nodes/MB, " << f_ns / nodes << " ns/node" << std::endl;
+    return 0;
+}
@@ -0,0 +1,296 @@
+#!/usr/bin/bash
+
+
+BLUE="\033[0;34m"
+NC="\033[0m"
+BENCH_FOLDER_NAME="bench"
+BIN="../build/bench"
+QI="../build/qi"
+DATA="../build/bench/data"
+
+cd "$BENCH_FOLDER_NAME" || exit 1
+mkdir -p "$DATA"
+
+# source loading: legacy linked list vs. mapped source buffer
+echo -e "$BLUE[info]$NC source load (multi-megabyte program)"
+./gen.sh functions 40000 > "$DATA/functions.qi"
+echo "file size: $(wc -c < "$DATA/functions.qi") bytes"
+$BIN/source_load legacy "$DATA/functions.qi"
+$BIN/source_load mmap "$DATA/functions.qi"
+
+# lexing: table-driven lexer vs. the regex reference lexer
+echo -e "$BLUE[info]$NC lexer throughput"
+./gen.sh functions 50 > "$DATA/functions_small.qi"
+$BIN/lexer_throughput regex "$DATA/functions_small.qi" 1
+$BIN/lexer_throughput dfa "$DATA/functions.qi" 5
+
+# keyword classification: compile-time perfect hash vs. legacy tables
+echo -e "$BLUE[info]$NC keyword classification"
+$BIN/keyword_lookup "$DATA/functions_small.qi" 2000
+
+# parsing: span-based parsers vs. the legacy token-copying parser
+echo -e "$BLUE[info]$NC parse time by program size (nesting depth 16)"
+for LINES in 12500 25000 50000 100000; do
+    ./gen.sh nested $LINES 16 > "$DATA/nested.qi"
+    echo "$LINES lines:"
+    $BIN/parse_time legacy "$DATA/nested.qi"
+    $BIN/parse_time pratt "$DATA/nested.qi"
+done
+echo -e "$BLUE[info]$NC parse time by nesting depth (100000 lines)"
+for DEPTH in 4 16 64 256; do
+    ./gen.sh nested 100000 $DEPTH > "$DATA/nested.qi"
+    echo "depth $DEPTH:"
+    $BIN/parse_time legacy "$DATA/nested.qi"
+    $BIN/parse_time pratt "$DATA/nested.qi"
+done
+echo -e "$BLUE[info]$NC parse time by expression length (100000 terms)"
+for TERMS in 250 1000 4000 16000; do
+    ./gen.sh expr $(( 100000 / $TERMS )) $TERMS > "$DATA/expr.qi"
+    echo "$TERMS terms:"
+    $BIN/parse_time scan "$DATA/expr.qi"
+    $BIN/parse_time pratt "$DATA/expr.qi"
+done
+
+# syntax trees: flat node array vs. the parsed tree of child vectors
+echo -e "$BLUE[info]$NC syntax tree memory and walk time"
+for program in ../examples/*.qi; do
+    $BIN/ast_walk "$program"
+done
+./gen.sh nested 100000 16 > "$DATA/nested.qi"
+$BIN/ast_walk "$DATA/nested.qi"
+
+# startup: function bodies parsed on a growing thread pool
+echo -e "$BLUE[info]$NC startup time by parser threads (100000 lines)"
+./gen.sh nested 100000 16 > "$DATA/nested.qi"
+$BIN/startup "$DATA/nested.qi" 1 2 4 8 16
+
+# lazy parsing: bodies parsed on first call vs. all at startup
+echo -e "$BLUE[info]$NC startup time and memory, eager vs. lazy (10% of functions called)"
+./gen.sh library 2000 16 > "$DATA/library.qi"
+$BIN/lazy_parse eager "$DATA/library.qi"
+$BIN/lazy_parse lazy "$DATA/library.qi"
+
+# program cache: lexing and parsing vs. loading a .qic file
+echo -e "$BLUE[info]$NC cold vs. warm start with the program cache (100000 lines)"
+./gen.sh nested 100000 16 > "$DATA/nested.qi"
+rm -rf "$DATA/qic"
+$BIN/cache_start "$DATA/nested.qi" "$DATA/qic" 5
+echo "source: $(wc -c < "$DATA/nested.qi") bytes, cache: $(cat "$DATA"/qic/*.qic | wc -c) bytes"
+
+# execution: tree walker vs. bytecode VM on the examples
+echo -e "$BLUE[info]$NC run time of the examples, tree walker vs. bytecode VM"
+run_engines() {
+    local times=()
+    for ENGINE in tree vm; do
+        local start=$(date +%s%N)
+        $QI --engine=$ENGINE "../examples/$1.qi" < "$2" > /dev/null
+        times+=($(( ($(date +%s%N) - start) / 1000000 )))
+    done
+    printf "%-28s %-14s %8s ms %8s ms %6s x\n" "$1" "$3" "${times[0]}" "${times[1]}" \
+        "$(awk -v t="${times[0]}" -v v="${times[1]}" 'BEGIN { printf "%.2f", t / v }')"
+}
+printf "%-28s %-14s %11s %11s %8s\n" "example" "input" "tree" "vm" "speedup"
+echo 100000 > "$DATA/sieve.in"
+run_engines 106a_sieve_of_eratosthenes "$DATA/sieve.in" "n = 100000"
+printf "201\n100\n" > "$DATA/magic.in"
+run_engines 106c_magic_square "$DATA/magic.in" "201 x 201"
+./gen.sh numbers 600 > "$DATA/numbers.in"
+for SORT in 202_insertion_sort 203_selection_sort 204_bubble_sort; do
+    run_engines $SORT "$DATA/numbers.in" "600 numbers"
+done
+
+# type checking: num operators on the checked fast path vs. the
+# dynamically typed object methods
+echo -e "$BLUE[info]$NC run time of num arithmetic, dynamic vs. static types (100000 iterations)"
+./gen.sh arith 100000 > "$DATA/arith.qi"
+printf "%-8s %11s %11s %8s\n" "engine" "dynamic" "static" "speedup"
+for ENGINE in tree vm; do
+    times=()
+    for TYPES in dynamic static; do
+        start=$(date +%s%N)
+        $QI --engine=$ENGINE --types=$TYPES "$DATA/arith.qi" > /dev/null
+        times+=($(( ($(date +%s%N) - start) / 1000000 )))
+    done
+    printf "%-8s %8s ms %8s ms %6s x\n" "$ENGINE" "${times[0]}" "${times[1]}" \
+        "$(awk -v d="${times[0]}" -v s="${times[1]}" 'BEGIN { printf "%.2f", d / s }')"
+done
+
+# quickening: tree walker nodes rewritten to the operand types they
+# see vs. generic nodes, with the checker's fast paths and without
+echo -e "$BLUE[info]$NC run time of the examples, generic vs. quickened nodes (tree walker)"
+run_quicken() {
+    local times=()
+    for QUICKEN in off on; do
+        local start=$(date +%s%N)
+        $QI --engine=tree --types=$3 --quicken=$QUICKEN --quicken-stats "../examples/$1.qi" < "$2" > /dev/null \
+            2> "$DATA/quicken.stats"
+        times+=($(( ($(date +%s%N) - start) / 1000000 )))
+    done
+    printf "%-22s %-8s %8s ms %8s ms %6s x   %s\n" "$1" "$3" "${times[0]}" "${times[1]}" \
+        "$(awk -v g="${times[0]}" -v q="${times[1]}" 'BEGIN { printf "%.2f", g / q }')" \
+        "$(cut -d ' ' -f 2- "$DATA/quicken.stats")"
+}
+printf "%-22s %-8s %11s %11s %8s\n" "example" "types" "generic" "quickened" "speedup"
+./gen.sh numbers 600 > "$DATA/numbers.in"
+{ echo 20000; echo 777; ./gen.sh numbers 20000 | tail -n +2; } > "$DATA/search.in"
+for TYPES in dynamic static; do
+    for SORT in 202_insertion_sort 203_selection_sort 204_bubble_sort; do
+        run_quicken $SORT "$DATA/numbers.in" $TYPES
+    done
+    run_quicken 201_binary_search "$DATA/search.in" $TYPES
+done
+
+# ahead-of-time compilation: the interpreter vs. programs translated
+# to C++ with --emit-cpp and compiled against the runtime library
+echo -e "$BLUE[info]$NC run time, interpreted (vm) vs. compiled to C++"
+run_aot() {
+    $QI --emit-cpp "$1" > "$DATA/aot.cpp"
+    ${CXX:-g++} -std=c++17 -O2 -I../src "$DATA/aot.cpp" ../build/libqi_runtime.a -o "$DATA/aot"
+    local times=()
+    local start=$(date +%s%N)
+    $QI --engine=vm "$1" < "$2" > "$DATA/aot.expected"
+    times+=($(( ($(date +%s%N) - start) / 1000000 )))
+    start=$(date +%s%N)
+    "$DATA/aot" < "$2" > "$DATA/aot.actual"
+    times+=($(( ($(date +%s%N) - start) / 1000000 )))
+    cmp -s "$DATA/aot.expected" "$DATA/aot.actual" || echo "output of $1 differs"
+    printf "%-28s %-14s %8s ms %8s ms %6s x\n" "$(basename "$1" .qi)" "$3" "${times[0]}" "${times[1]}" \
+        "$(awk -v i="${times[0]}" -v c="${times[1]}" 'BEGIN { printf "%.2f", i / (c > 0 ? c : 1) }')"
+}
+printf "%-28s %-14s %11s %11s %8s\n" "program" "input" "vm" "c++" "speedup"
+echo 100000 > "$DATA/sieve.in"
+run_aot ../examples/106a_sieve_of_eratosthenes.qi "$DATA/sieve.in" "n = 100000"
+./gen.sh numbers 600 > "$DATA/numbers.in"
+for SORT in 202_insertion_sort 203_selection_sort 204_bubble_sort; do
+    run_aot ../examples/$SORT.qi "$DATA/numbers.in" "600 numbers"
+done
+./gen.sh arith 100000 > "$DATA/arith.qi"
+run_aot "$DATA/arith.qi" /dev/null "100000 iter."
+
+# calls: the tree walker recursing on the native stack vs. the VM
+# pushing frames on its own frame stack, on call-heavy programs
+echo -e "$BLUE[info]$NC run time of call-heavy programs, tree walker vs. vm"
+printf "%-22s %11s %11s %8s\n" "program" "tree" "vm" "speedup"
+run_calls() {
+    local times=()
+    for ENGINE in tree vm; do
+        local start=$(date +%s%N)
+        $QI --engine=$ENGINE "$1" < "${3:-/dev/null}" > /dev/null
+        times+=($(( ($(date +%s%N) - start) / 1000000 )))
+    done
+    printf "%-22s %8s ms %8s ms %6s x\n" "$2" "${times[0]}" "${times[1]}" \
+        "$(awk -v t="${times[0]}" -v v="${times[1]}" 'BEGIN { printf "%.2f", t / (v > 0 ? v : 1) }')"
+}
+./gen.sh fib 25 > "$DATA/fib.qi"
+run_calls "$DATA/fib.qi" "fibonacci 25"
+for DEPTH in 10000 100000 1000000; do
+    ./gen.sh depth $DEPTH > "$DATA/depth.qi"
+    run_calls "$DATA/depth.qi" "depth $DEPTH"
+done
+
+# jit: numeric functions on the tree walker and the VM vs. compiled to
+# native code on their first call
+echo -e "$BLUE[info]$NC run time, tree walker vs. vm vs. jit"
+run_jit() {
+    local times=()
+    for ARGS in "--engine=tree" "--engine=vm" "--jit=on"; do
+        local start=$(date +%s%N)
+        $QI $ARGS "$1" > /dev/null
+        times+=($(( ($(date +%s%N) - start) / 1000000 )))
+    done
+    printf "%-22s %8s ms %8s ms %8s ms %6s x\n" "$2" "${times[0]}" "${times[1]}" "${times[2]}" \
+        "$(awk -v t="${times[0]}" -v j="${times[2]}" 'BEGIN { printf "%.2f", t / (j > 0 ? j : 1) }')"
+}
+printf "%-22s %11s %11s %11s %8s\n" "program" "tree" "vm" "jit" "speedup"
+./gen.sh gcd 100000 > "$DATA/gcd.qi"
+run_jit "$DATA/gcd.qi" "gcd, 100000 pairs"
+./gen.sh fib 25 > "$DATA/fib.qi"
+run_jit "$DATA/fib.qi" "fibonacci 25"
+./gen.sh sieve 1000000 > "$DATA/sieve.qi"
+run_jit "$DATA/sieve.qi" "sieve, n = 1000000"
+./gen.sh arith 100000 > "$DATA/arith.qi"
+run_jit "$DATA/arith.qi" "arith, 100000 iter."
+
+# memoization: recursive pure functions with and without --memo, which
+# keeps the values of their calls
+echo -e "$BLUE[info]$NC run time, without vs. with --memo"
+printf "%-22s %11s %11s %8s\n" "program" "off" "memo" "speedup"
+run_memo() {
+    local times=()
+    for ARGS in "" "--memo"; do
+        local start=$(date +%s%N)
+        $QI $ARGS "$1" > /dev/null
+        times+=($(( ($(date +%s%N) - start) / 1000000 )))
+    done
+    printf "%-22s %8s ms %8s ms %6s x\n" "$2" "${times[0]}" "${times[1]}" \
+        "$(awk -v o="${times[0]}" -v m="${times[1]}" 'BEGIN { printf "%.2f", o / (m > 0 ? m : 1) }')"
+}
+./gen.sh fib 25 > "$DATA/fib.qi"
+run_memo "$DATA/fib.qi" "fibonacci 25"
+./gen.sh gcd 100000 > "$DATA/gcd.qi"
+run_memo "$DATA/gcd.qi" "gcd, 100000 pairs"
+
+# call rate: calls per second of a two-argument num function, and the
+# heap allocations of each call and its loop pass, on every engine
+echo -e "$BLUE[info]$NC call rate (1000000 calls of add(num, num))"
+./gen.sh add 1000000 > "$DATA/add.qi"
+for ENGINE in tree vm jit; do
+    $BIN/alloc_rate "$DATA/add.qi" "add, 1000000 calls" $ENGINE 1000000 call
+done
+
+# for loops: passes per second and heap allocations of a loop over a
+# range, whose variable and bounds are unboxed, and run time of the
+# loops of the sieve and the sorts
+echo -e "$BLUE[info]$NC for loops (100000000 passes of an empty loop)"
+./gen.sh loop 100000000 > "$DATA/loop.qi"
+for ENGINE in tree vm; do
+    $BIN/alloc_rate "$DATA/loop.qi" "loop, 100000000 passes" $ENGINE 100000000 pass
+done
+echo -e "$BLUE[info]$NC run time of programs with for loops, tree walker vs. vm"
+printf "%-22s %11s %11s %8s\n" "program" "tree" "vm" "speedup"
+./gen.sh sieve 1000000 > "$DATA/sieve.qi"
+run_calls "$DATA/sieve.qi" "sieve, n = 1000000"
+./gen.sh numbers 2000 > "$DATA/numbers.in"
+for SORT in 202_insertion_sort 203_selection_sort 204_bubble_sort; do
+    run_calls "../examples/$SORT.qi" "$SORT" "$DATA/numbers.in"
+done
+
+# allocations: heap allocations of arithmetic-heavy programs, whose
+# nums and bools the tree walker keeps in values instead of objects
+echo -e "$BLUE[info]$NC heap allocations of arithmetic-heavy programs"
+./gen.sh arith 100000 > "$DATA/arith.qi"
+./gen.sh gcd 100000 > "$DATA/gcd.qi"
+./gen.sh fib 25 > "$DATA/fib.qi"
+./gen.sh sieve 1000000 > "$DATA/sieve.qi"
+for ENGINE in tree vm; do
+    $BIN/alloc_rate "$DATA/arith.qi" "arith, 100000 iter." $ENGINE
+    $BIN/alloc_rate "$DATA/gcd.qi" "gcd, 100000 pairs" $ENGINE
+    $BIN/alloc_rate "$DATA/fib.qi" "fibonacci 25" $ENGINE
+    $BIN/alloc_rate "$DATA/sieve.qi" "sieve, n = 1000000" $ENGINE
+done
+
+# object layout: the sizes of an object and of its parts, and the heap
+# bytes per element of an arr of nums, on its own and filled by a program
+echo -e "$BLUE[info]$NC object layout and arr memory (1000000 nums)"
+./gen.sh arr 1000000 > "$DATA/arr.qi"
+$BIN/object_size "$DATA/arr.qi" 1000000 tree
+
+# garbage collection: a loop that creates about 10^8 temporary objects,
+# which the collector keeps to a bounded heap; collections, pauses and
+# peak heap and process size
+echo -e "$BLUE[info]$NC garbage collection (10000000 passes over temporaries)"
+./gen.sh temps 10000000 > "$DATA/temps.qi"
+for ENGINE in tree vm; do
+    $BIN/gc_heap "$DATA/temps.qi" "temps, 10000000 passes" $ENGINE
+done
+
+# dispatch: nodes per second of the tree walker on large sorts, over
+# the first seconds of each run
+echo -e "$BLUE[info]$NC tree walker throughput (100000 numbers)"
+./gen.sh numbers 100000 > "$DATA/numbers.in"
+for SORT in 202_insertion_sort 203_selection_sort 204_bubble_sort; do
+    $BIN/dispatch "../examples/$SORT.qi" "$DATA/numbers.in" 2
+done
+
+cd ".."
+echo -e "$BLUE[info]$NC ran all benchmarks"
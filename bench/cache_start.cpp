@@ -0,0 +1,54 @@
+/*
+ * cache_start.cpp contains:
+ *   - Cold vs. warm start benchmark for the compiled program cache
+ */
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "cache.h"
+#include "fstream.h"
+#include "interpreter.h"
+#include "lexer.h"
+#include "memory.h"
+#include "options.h"
+#include "token.h"
+
+/// starts a program the way `qi --cache` does, without running it
+/// \param warm: whether the cache is expected to be valid
+/// \return the time to start, in ms
+double start(bool warm) {
+    // every start declares the same program again
+    memory::clear();
+    auto start = std::chrono::high_resolution_clock::now();
+    fstream stream(options::file_name);
+    std::uint64_t key = program_cache::hash(stream.view());
+    std::unique_ptr <interpreter> runtime = program_cache::load(key, stream.view().size());
+    if (!runtime) {
+        if (warm)
+            err("cache miss on a warm start");
+        runtime = std::make_unique<interpreter>(lexer(stream).tokenize());
+        program_cache::save(*runtime, key, stream.view().size());
+    }
+    auto stop = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(stop - start).count();
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 4)
+        err("usage: cache_start <file.qi> <empty cache dir> <warm runs>");
+    options::file_name = argv[1];
+    options::cache = true;
+    options::cache_dir = argv[2];
+    options::jobs = 1;
+
+    double cold = start(false), warm = 1e18;
+    for (int i = 0; i < std::stoi(argv[3]); ++i)
+        warm = std::min(warm, start(true));
+    std::cout << "cold start (lex, parse, write cache): " << cold << " ms" << std::endl;
+    std::cout << "warm start (load cache): " << warm << " ms, speedup " << cold / warm << "x" << std::endl;
+    return 0;
+}
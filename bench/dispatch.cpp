@@ -0,0 +1,69 @@
+/*
+ * dispatch.cpp contains:
+ *   - Tree walker throughput benchmark, in syntax tree nodes visited
+ *     per second
+ */
+
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "executor.h"
+#include "fstream.h"
+#include "interpreter.h"
+#include "lexer.h"
+#include "null_buffer.h"
+#include "options.h"
+#include "token.h"
+
+static std::chrono::high_resolution_clock::time_point start;
+static const char *name;
+
+/// prints the nodes visited so far and their rate; the alarm can
+/// interrupt malloc, so nothing here allocates
+static void report() {
+    double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+    char line[256];
+    int size = std::snprintf(line, sizeof(line), "%s: %llu nodes in %.2f s, %.1f M nodes/s\n", name,
+                             (unsigned long long) executor::visits, seconds,
+                             (double) executor::visits / seconds / 1e6);
+    if (write(STDOUT_FILENO, line, (std::size_t) size) < 0)
+        std::_Exit(1);
+}
+
+/// stops a run that is still going when its time is up; sorts of large
+/// inputs run for hours, and no object is ever freed, but their rate
+/// settles within a second or two
+static void on_alarm(int) {
+    report();
+    std::_Exit(0);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 4)
+        err("usage: dispatch <file.qi> <input> <seconds>");
+    if (!std::freopen(argv[2], "r", stdin))
+        err("cannot open input");
+    name = argv[1];
+    options::jobs = 1;
+    options::engine = "tree";
+    interpreter runtime(lexer(fstream(argv[1])).tokenize());
+
+    null_buffer discard;
+    std::streambuf *out = std::cout.rdbuf(&discard);
+    std::signal(SIGALRM, on_alarm);
+    start = std::chrono::high_resolution_clock::now();
+    alarm((unsigned) std::stoi(argv[3]));
+    runtime.execute();
+    alarm(0);
+    std::cout.rdbuf(out);
+    report();
+    return 0;
+}
@@ -0,0 +1,47 @@
+/*
+ * gc_heap.cpp contains:
+ *   - Garbage collection benchmark, in objects allocated, collections,
+ *     pause times and peak heap and process size, of a program on an
+ *     engine
+ */
+
+#include <chrono>
+#include <iostream>
+#include <streambuf>
+#include <string>
+
+#include <sys/resource.h>
+
+#include "fstream.h"
+#include "gc.h"
+#include "heap.h"
+#include "interpreter.h"
+#include "lexer.h"
+#include "null_buffer.h"
+#include "options.h"
+#include "token.h"
+
+int main(int argc, char *argv[]) {
+    if (argc != 4)
+        err("usage: gc_heap <file.qi> <label> <tree|vm>");
+    options::jobs = 1;
+    options::engine = argv[3];
+    interpreter runtime(lexer(fstream(argv[1])).tokenize());
+
+    null_buffer discard;
+    std::streambuf *out = std::cout.rdbuf(&discard);
+    std::uint64_t before = heap::total;
+    auto start = std::chrono::high_resolution_clock::now();
+    runtime.execute();
+    double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+    std::uint64_t count = heap::total - before;
+    std::cout.rdbuf(out);
+
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    std::cout << argv[2] << " (" << options::engine << "): " << seconds * 1000 << " ms, " << count
+              << " objects allocated, " << gc::collections << " collections" << std::endl;
+    std::cout << "    pauses: " << gc::total_ms << " ms in all, " << gc::max_ms << " ms longest; peak heap "
+              << heap::peak << " objects, peak RSS " << usage.ru_maxrss / 1024 << " MB" << std::endl;
+    return 0;
+}
@@ -0,0 +1,264 @@
+#!/usr/bin/bash
+# Usage:
+#  - gen.sh functions N		program with N small numeric functions
+#  - gen.sh nested N DEPTH	program of about N lines whose functions nest
+#				DEPTH if blocks around long expressions
+#  - gen.sh expr N TERMS		program with N expressions of TERMS terms each
+#  - gen.sh library N DEPTH	N nested functions of which main calls every
+#				tenth
+#  - gen.sh numbers N		input of a count N and N pseudo-random numbers
+#  - gen.sh arith N		program whose main loops N times over num
+#				arithmetic
+#  - gen.sh gcd N		program that sums the recursive gcd of N pairs
+#  - gen.sh fib N		program that computes fibonacci N recursively
+#  - gen.sh sieve N		program that counts the primes below N with a
+#				sieve in a function
+#  - gen.sh depth N		program that recurses to a depth of N
+#  - gen.sh add N		program that calls a two-argument num function
+#				N times
+#  - gen.sh loop N		program whose main loops N times over a range
+#				with a body that only reads the loop variable
+#  - gen.sh arr N		program that pushes the nums 0 to N - 1 onto
+#				an arr
+#  - gen.sh temps N		program whose main loops N times over str
+#				concatenations and an arr it refills, which
+#				create 9 to 13 temporary objects per pass
+
+KIND=$1
+SIZE=$2
+DEPTH=${3:-16}
+
+case "$KIND" in
+    functions)
+        awk -v n="$SIZE" 'BEGIN {
+            for (i = 0; i < n; ++i) {
+                printf "fn f%d num (num x, num y) start\n", i
+                printf "    $ scaled input\n"
+                printf "    num a\n"
+                printf "    a = x * %d + y\n", i
+                printf "    if a > 100 start\n"
+                printf "        a = a %% 100\n"
+                printf "    end\n"
+                printf "    return a\n"
+                printf "end\n\n"
+            }
+            printf "fn main none () start\n"
+            printf "    outl f0(1, 2)\n"
+            printf "end\n"
+        }'
+        ;;
+    nested)
+        awk -v n="$SIZE" -v depth="$DEPTH" 'BEGIN {
+            for (f = 0; lines < n; ++f) {
+                printf "fn g%d num (num x) start\n", f
+                printf "    num a\n"
+                printf "    a = x\n"
+                lines += 3
+                for (d = 0; d < depth; ++d) {
+                    indent = sprintf("%*s", 4 * d + 4, "")
+                    printf "%sif a > %d start\n", indent, d
+                    printf "%s    a = (a + %d) * 2 - a %% 7 + x * (x - %d) // 3 + 1 + 2 + 3 + 4 + 5 + 6 + 7 + 8\n", indent, d, d
+                    lines += 2
+                }
+                for (d = depth - 1; d >= 0; --d) {
+                    printf "%*send\n", 4 * d + 4, ""
+                    ++lines
+                }
+                printf "    return a\n"
+                printf "end\n\n"
+                lines += 3
+            }
+            printf "fn main none () start\n"
+            printf "    outl g0(1)\n"
+            printf "end\n"
+        }'
+        ;;
+    expr)
+        awk -v n="$SIZE" -v terms="$DEPTH" 'BEGIN {
+            split("+ - * // % + - *", ops, " ")
+            printf "fn main none () start\n"
+            printf "    num a\n"
+            for (i = 0; i < n; ++i) {
+                printf "    a = (a + %d)", i
+                for (t = 1; t < terms; ++t)
+                    printf " %s %d", ops[t % 8 + 1], t
+                printf "\n"
+            }
+            printf "    outl a\n"
+            printf "end\n"
+        }'
+        ;;
+    library)
+        awk -v n="$SIZE" -v depth="$DEPTH" 'BEGIN {
+            for (f = 0; f < n; ++f) {
+                printf "fn g%d num (num x) start\n", f
+                printf "    num a\n"
+                printf "    a = x\n"
+                for (d = 0; d < depth; ++d) {
+                    indent = sprintf("%*s", 4 * d + 4, "")
+                    printf "%sif a > %d start\n", indent, d
+                    printf "%s    a = (a + %d) * 2 - a %% 7 + x * (x - %d) // 3 + 1 + 2 + 3 + 4 + 5 + 6 + 7 + 8\n", indent, d, d
+                }
+                for (d = depth - 1; d >= 0; --d)
+                    printf "%*send\n", 4 * d + 4, ""
+                printf "    return a\n"
+                printf "end\n\n"
+            }
+            printf "fn main none () start\n"
+            printf "    num a\n"
+            for (f = 0; f < n; f += 10)
+                printf "    a = g%d(1)\n", f
+            printf "end\n"
+        }'
+        ;;
+    numbers)
+        awk -v n="$SIZE" 'BEGIN {
+            srand(1)
+            print n
+            for (i = 0; i < n; ++i)
+                print int(rand() * 100000)
+        }'
+        ;;
+    arith)
+        awk -v n="$SIZE" 'BEGIN {
+            printf "fn step num (num x, num i) start\n"
+            printf "    return (x * 31 + i * 7) %% 10007 - i // 3 + (i - x) / 5\n"
+            printf "end\n\n"
+            printf "fn main none () start\n"
+            printf "    num i\n"
+            printf "    num x\n"
+            printf "    num sum\n"
+            printf "    while i < %d start\n", n
+            printf "        x = step(x, i) %% 1000\n"
+            printf "        sum += x * x - i %% 13 * 2\n"
+            printf "        i += 1\n"
+            printf "    end\n"
+            printf "    outl sum\n"
+            printf "end\n"
+        }'
+        ;;
+    gcd)
+        awk -v n="$SIZE" 'BEGIN {
+            printf "fn gcd num (num x, num y) start\n"
+            printf "    if y == 0 start\n"
+            printf "        return x\n"
+            printf "    end\n"
+            printf "    return gcd(y, x %% y)\n"
+            printf "end\n\n"
+            printf "fn main none () start\n"
+            printf "    num sum\n"
+            printf "    for i of range(1, %d) start\n", n
+            printf "        sum += gcd(i * 7919, %d - i)\n", n
+            printf "    end\n"
+            printf "    outl sum\n"
+            printf "end\n"
+        }'
+        ;;
+    fib)
+        awk -v n="$SIZE" 'BEGIN {
+            printf "fn fib num (num n) start\n"
+            printf "    if n < 2 start\n"
+            printf "        return n\n"
+            printf "    end\n"
+            printf "    return fib(n - 1) + fib(n - 2)\n"
+            printf "end\n\n"
+            printf "fn main none () start\n"
+            printf "    outl fib(%d)\n", n
+            printf "end\n"
+        }'
+        ;;
+    sieve)
+        awk -v n="$SIZE" 'BEGIN {
+            printf "fn count num (num n) start\n"
+            printf "    arr composite\n"
+            printf "    for i of range(n) start\n"
+            printf "        composite.push(0)\n"
+            printf "    end\n"
+            printf "    num primes\n"
+            printf "    num j\n"
+            printf "    for i of range(2, n) start\n"
+            printf "        if composite.at(i) == 0 start\n"
+            printf "            primes += 1\n"
+            printf "            j = i * i\n"
+            printf "            while j < n start\n"
+            printf "                composite.at(j) = 1\n"
+            printf "                j += i\n"
+            printf "            end\n"
+            printf "        end\n"
+            printf "    end\n"
+            printf "    return primes\n"
+            printf "end\n\n"
+            printf "fn main none () start\n"
+            printf "    outl count(%d)\n", n
+            printf "end\n"
+        }'
+        ;;
+    depth)
+        awk -v n="$SIZE" 'BEGIN {
+            printf "fn depth num (num n) start\n"
+            printf "    if n == 0 start\n"
+            printf "        return 0\n"
+            printf "    end\n"
+            printf "    return depth(n - 1) + 1\n"
+            printf "end\n\n"
+            printf "fn main none () start\n"
+            printf "    outl depth(%d)\n", n
+            printf "end\n"
+        }'
+        ;;
+    add)
+        awk -v n="$SIZE" 'BEGIN {
+            printf "fn add num (num a, num b) start\n"
+            printf "    return a + b\n"
+            printf "end\n\n"
+            printf "fn main none () start\n"
+            printf "    num sum\n"
+            printf "    for i of range(%d) start\n", n
+            printf "        sum = add(sum, i)\n"
+            printf "    end\n"
+            printf "    outl sum\n"
+            printf "end\n"
+        }'
+        ;;
+    loop)
+        awk -v n="$SIZE" 'BEGIN {
+            printf "fn main none () start\n"
+            printf "    for i of range(%d) start\n", n
+            printf "        i\n"
+            printf "    end\n"
+            printf "end\n"
+        }'
+        ;;
+    arr)
+        awk -v n="$SIZE" 'BEGIN {
+            printf "fn main none () start\n"
+            printf "    arr a\n"
+            printf "    for i of range(%d) start\n", n
+            printf "        a.push(i)\n"
+            printf "    end\n"
+            printf "    outl a.len()\n"
+            printf "end\n"
+        }'
+        ;;
+    temps)
+        awk -v n="$SIZE" 'BEGIN {
+            printf "fn main none () start\n"
+            printf "    str s\n"
+            printf "    arr a\n"
+            printf "    num total\n"
+            printf "    total = 0\n"
+            printf "    for i of range(%d) start\n", n
+            printf "        s = \"ab\" + \"cd\" + \"ef\"\n"
+            printf "        a.clear()\n"
+            printf "        a.push(s)\n"
+            printf "        total += a.len() + s.len()\n"
+            printf "    end\n"
+            printf "    outl total\n"
+            printf "end\n"
+        }'
+        ;;
+    *)
+        echo "unknown program kind: $KIND" >&2
+        exit 1
+        ;;
+esac
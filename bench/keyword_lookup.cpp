@@ -0,0 +1,91 @@
+/*
+ * keyword_lookup.cpp contains:
+ *   - The legacy runtime-initialized keyword tables, kept as the
+ *     baseline
+ *   - Keyword classification throughput benchmark
+ */
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "fstream.h"
+#include "keywords.h"
+#include "lexer.h"
+#include "token.h"
+
+/// the tables `token::init()` used to fill at startup
+class legacy_tables {
+public:
+    std::unordered_map <std::string, std::pair<int, int>> builtins;
+    std::unordered_set <std::string> control, vars, methods;
+
+    legacy_tables() {
+        for (const keyword &k : keywords) {
+            std::string name(k.name);
+            if (k.category & k_builtin)
+                builtins.insert({name, {k.ops, k.pre}});
+            if (k.category & k_control)
+                control.insert(name);
+            if (k.category & k_var)
+                vars.insert(name);
+            if (k.category & k_method)
+                methods.insert(name);
+        }
+    }
+
+    /// classifies a word the way the lexer and memory::valid did
+    /// \return a checksum of the word's properties
+    int classify(const std::string &word) {
+        auto it = builtins.find(word);
+        if (it != builtins.end())
+            return it->second.first + it->second.second;
+        return (vars.find(word) != vars.end()) + (control.find(word) != control.end()) +
+               (methods.find(word) != methods.end());
+    }
+};
+
+/// classifies a word through the compile-time keyword table
+/// \return a checksum of the word's properties
+int classify(std::string_view word) {
+    std::uint32_t id = keyword_table.find(word);
+    if (token::is_builtin(id))
+        return token::arity(id) + token::precedence(id);
+    return token::is_var(id) + token::is_control(id) + token::is_method(id);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 3)
+        err("usage: keyword_lookup <file.qi> <repeats>");
+    int repeats = std::stoi(argv[2]);
+
+    // classify every word and operator of a real program
+    std::vector <std::string> words;
+    for (const token &t : lexer(fstream(argv[1])).tokenize())
+        if (t.type == t_builtin || t.type == t_symbol)
+            words.push_back(symbol::str(t.val));
+
+    legacy_tables legacy;
+    long long checksum = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < repeats; ++i)
+        for (const std::string &word : words)
+            checksum += legacy.classify(word);
+    auto mid = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < repeats; ++i)
+        for (const std::string &word : words)
+            checksum -= classify(word);
+    auto stop = std::chrono::high_resolution_clock::now();
+
+    if (checksum != 0)
+        err("keyword tables disagree");
+    double lookups = (double) words.size() * repeats / 1e6;
+    std::cout << "legacy tables: " << lookups / std::chrono::duration<double>(mid - start).count()
+              << " M lookups/s" << std::endl;
+    std::cout << "perfect hash: " << lookups / std::chrono::duration<double>(stop - mid).count()
+              << " M lookups/s" << std::endl;
+    return 0;
+}
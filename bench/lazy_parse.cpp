@@ -0,0 +1,52 @@
+/*
+ * lazy_parse.cpp contains:
+ *   - Startup time and memory benchmark for eager vs. lazy parsing of
+ *     function bodies
+ */
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+
+#include "fstream.h"
+#include "interpreter.h"
+#include "lexer.h"
+#include "memory.h"
+#include "options.h"
+#include "token.h"
+
+int main(int argc, char *argv[]) {
+    if (argc != 3 || (std::string(argv[1]) != "eager" && std::string(argv[1]) != "lazy"))
+        err("usage: lazy_parse <eager|lazy> <file.qi>");
+    options::lazy = std::string(argv[1]) == "lazy";
+    options::jobs = 1;
+    std::vector <token> tokens = lexer(fstream(argv[2])).tokenize();
+
+    auto start = std::chrono::high_resolution_clock::now();
+    interpreter runtime(std::move(tokens));
+    auto mid = std::chrono::high_resolution_clock::now();
+    runtime.execute();
+    auto stop = std::chrono::high_resolution_clock::now();
+
+    // only bodies that were parsed hold a syntax tree
+    std::size_t fns = 0, parsed = 0, bytes = 0;
+    for (object *obj : memory::globals) {
+        if (obj->type != o_fn)
+            continue;
+        ++fns;
+        if (obj->def->body) {
+            ++parsed;
+            bytes += obj->def->body->bytes();
+        }
+    }
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    std::cout << argv[1] << ": startup " << std::chrono::duration<double, std::milli>(mid - start).count()
+              << " ms, run " << std::chrono::duration<double, std::milli>(stop - mid).count() << " ms, "
+              << parsed << "/" << fns << " bodies parsed, " << bytes / 1024 << " KiB of syntax trees, peak rss "
+              << usage.ru_maxrss / 1024 << " MiB" << std::endl;
+    return 0;
+}
@@ -0,0 +1,35 @@
+/*
+ * lexer_throughput.cpp contains:
+ *   - Tokenizing throughput benchmark for the lexers
+ */
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "fstream.h"
+#include "lexer.h"
+#include "regex_lexer.h"
+#include "token.h"
+
+int main(int argc, char *argv[]) {
+    if (argc != 4)
+        err("usage: lexer_throughput <dfa|regex> <file.qi> <repeats>");
+    std::string mode = argv[1], file_name = argv[2];
+    int repeats = std::stoi(argv[3]);
+
+    fstream stream(file_name);
+    std::size_t count = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < repeats; ++i) {
+        std::vector <token> tokens = mode == "regex" ? regex_lexer(stream).tokenize() : lexer(stream).tokenize();
+        count = tokens.size();
+    }
+    auto stop = std::chrono::high_resolution_clock::now();
+
+    double seconds = std::chrono::duration<double>(stop - start).count();
+    double megabytes = (double) stream.view().size() * repeats / (1 << 20);
+    std::cout << mode << ": " << count << " tokens, " << megabytes / seconds << " MB/s" << std::endl;
+    return 0;
+}
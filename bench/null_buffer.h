@@ -0,0 +1,19 @@
+/*
+ * null_buffer.h contains:
+ *   - A stream buffer that discards the output of a benchmarked program
+ */
+
+#ifndef QI_BENCH_NULL_BUFFER_H
+#define QI_BENCH_NULL_BUFFER_H
+
+#include <streambuf>
+
+/// discards the output of the program
+class null_buffer : public std::streambuf {
+protected:
+    int overflow(int c) override {
+        return c;
+    }
+};
+
+#endif //QI_BENCH_NULL_BUFFER_H
@@ -0,0 +1,91 @@
+/*
+ * object_size.cpp contains:
+ *   - Object layout report, the sizes of an object, its store and a
+ *     function definition
+ *   - Memory benchmark, in live heap bytes per element, of an arr of
+ *     nums on its own and of a program that fills one
+ */
+
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <streambuf>
+#include <string>
+
+#include <malloc.h>
+
+#include "fstream.h"
+#include "heap.h"
+#include "interpreter.h"
+#include "lexer.h"
+#include "null_buffer.h"
+#include "object.h"
+#include "options.h"
+#include "runtime.h"
+#include "token.h"
+
+// the bytes of every malloc block; objects take a slot of the object
+// heap each, which heap_bytes adds
+static std::size_t live = 0;
+
+void *operator new(std::size_t size) {
+    if (void *p = std::malloc(size ? size : 1)) {
+        live += malloc_usable_size(p);
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept {
+    live -= malloc_usable_size(p);
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept {
+    live -= malloc_usable_size(p);
+    std::free(p);
+}
+
+/// \return the live bytes of malloc blocks and of object slots
+static std::size_t heap_bytes() {
+    return live + heap::live * sizeof(object);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 4)
+        err("usage: object_size <file.qi> <elements> <tree|vm>");
+    std::cout << "sizeof(object) = " << sizeof(object) << ", sizeof(object_store) = " << sizeof(object_store)
+              << ", sizeof(function) = " << sizeof(function) << std::endl;
+
+    // the arr on its own: the pushed num and the none push returns are
+    // freed, which leaves the element and its slot
+    std::size_t count = std::stoul(argv[2]);
+    object *target = runtime::make(s_arr);
+    std::size_t start = heap_bytes();
+    for (std::size_t i = 0; i < count; ++i) {
+        object *val = runtime::num((double) i);
+        delete target->push(val);
+        delete val;
+    }
+    std::size_t own = heap_bytes() - start;
+    std::cout << "arr of " << count << " nums: " << (double) own / count << " heap bytes per element" << std::endl;
+    // nothing roots the arr, which a collection in the program would free
+    for (object *item : target->as_arr())
+        delete item;
+    delete target;
+
+    double elements = (double) count;
+    options::jobs = 1;
+    options::engine = argv[3];
+    interpreter runtime(lexer(fstream(argv[1])).tokenize());
+
+    null_buffer discard;
+    std::streambuf *out = std::cout.rdbuf(&discard);
+    std::size_t before = heap_bytes();
+    runtime.execute();
+    std::size_t bytes = heap_bytes() - before;
+    std::cout.rdbuf(out);
+    std::cout << "program (" << options::engine << "): " << bytes / elements << " heap bytes per element, "
+              << bytes << " in all" << std::endl;
+    return 0;
+}
@@ -0,0 +1,155 @@
+/*
+ * parse_time.cpp contains:
+ *   - The legacy token-copying parser, kept as the baseline
+ *   - Parse time benchmark for the function bodies of a program, with
+ *     the legacy parser, the reference scan parser and the pratt parser
+ */
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ast_node.h"
+#include "fstream.h"
+#include "lexer.h"
+#include "options.h"
+#include "token.h"
+
+/// returns a copy of tokens[start:end + 1], as the legacy parser did
+/// for every child
+/// \param tokens: the base tokens array
+/// \param start: the start index
+/// \param end: the end index
+/// \return tokens[start:end + 1]
+std::vector <token> legacy_subarray(const std::vector <token> &tokens, int start, int end) {
+    return std::vector<token>(tokens.begin() + start, tokens.begin() + end + 1);
+}
+
+/// the legacy block splitter, which scans for the end of every block
+/// \param tokens: the sequence of tokens
+/// \return a list of start and end indices of the blocks
+std::vector <std::pair<int, int>> legacy_blocks(const std::vector <token> &tokens) {
+    std::vector <std::pair<int, int>> blocks;
+    int count = (int) tokens.size(), curr = 0, start, depth;
+    while (curr < count) {
+        start = curr;
+        while (curr < count &&
+               !(tokens[curr].type == t_eof || tokens[curr].type == t_lb || tokens[curr].val == s_start))
+            ++curr;
+        if (curr == count || tokens[curr].type == t_eof || tokens[curr].type == t_lb) {
+            blocks.emplace_back(start, curr - 1);
+            ++curr;
+            continue;
+        }
+        depth = 1, ++curr;
+        while (curr < count && tokens[curr].type != t_eof && !(depth == 1 && tokens[curr].val == s_end)) {
+            if (tokens[curr].val == s_start) ++depth;
+            if (tokens[curr].val == s_end) --depth;
+            ++curr;
+        }
+        if (curr == count || tokens[curr].type == t_eof)
+            err("unclosed block", tokens[curr - 1].line);
+        blocks.emplace_back(start, curr);
+        curr += 2;
+    }
+    if (!blocks.empty() && blocks.back().first > blocks.back().second)
+        blocks.pop_back();
+    return blocks;
+}
+
+/// the AST node before the span-based parser: every child owns a copy
+/// of its tokens, and brackets are matched by rescanning
+class legacy_node {
+public:
+    token val;
+    std::vector <legacy_node> children;
+
+    explicit legacy_node(std::vector <token> tokens) {
+        std::vector <std::pair<int, int>> blocks = legacy_blocks(tokens);
+        if (blocks.empty())
+            err("parsing error");
+        else if (blocks.size() >= 2) {
+            val = token(s_group, tokens[0].line, t_group, (int) blocks.size());
+            for (const std::pair<int, int> &block : blocks)
+                children.emplace_back(legacy_subarray(tokens, block.first, block.second));
+            return;
+        }
+        tokens = legacy_subarray(tokens, blocks[0].first, blocks[0].second);
+        val = tokens[0];
+        if (tokens.back().val == s_end) {
+            int start = 1;
+            while (start < tokens.size() - 1 && tokens[start].val != s_start)
+                ++start;
+            if (tokens.front().val != s_else)
+                children.emplace_back(legacy_subarray(tokens, 1, start - 1));
+            children.emplace_back(legacy_subarray(tokens, start + 2, (int) tokens.size() - 2));
+        } else if (tokens.size() > 1) {
+            while (tokens.front().val == s_lparen && tokens.back().val == s_rparen) {
+                int count = 0, i = 1;
+                for (; i < tokens.size() - 1 && count >= 0; ++i)
+                    count += tokens[i].val == s_lparen ? 1 : (tokens[i].val == s_rparen ? -1 : 0);
+                if (count < 0)
+                    break;
+                tokens = legacy_subarray(tokens, 1, (int) tokens.size() - 2);
+            }
+            int pre = token::pre_none + 1, lowest_pre = 0;
+            for (int i = 0, depth; i < tokens.size(); ++i) {
+                if (tokens[i].val == s_lparen)
+                    for (depth = 0; !(depth == 1 && tokens[i].val == s_rparen); ++i)
+                        depth += tokens[i].val == s_lparen ? 1 : (tokens[i].val == s_rparen ? -1 : 0);
+                if (tokens[i].type == t_builtin && token::precedence(tokens[i].val) <= pre)
+                    pre = token::precedence(tokens[i].val), lowest_pre = i;
+            }
+            val = tokens[lowest_pre];
+            if (val.ops == 1) {
+                children.emplace_back(legacy_subarray(tokens, 1, (int) tokens.size() - 1));
+            } else if (val.ops == 2) {
+                children.emplace_back(legacy_subarray(tokens, 0, lowest_pre - 1));
+                children.emplace_back(legacy_subarray(tokens, lowest_pre + 1, (int) tokens.size() - 1));
+            }
+        }
+    }
+};
+
+/// finds the token range of every function body in the program
+/// \param tokens: the program tokens
+/// \return the start and end indices of the bodies
+std::vector <std::pair<int, int>> fn_bodies(token_span tokens) {
+    std::vector <std::pair<int, int>> bodies;
+    for (const std::pair<int, int> &block : ast_node::gen_blocks(tokens, false)) {
+        int start = block.first;
+        while (tokens[start].val != s_start)
+            ++start;
+        bodies.emplace_back(start + 2, block.second - 1);
+    }
+    return bodies;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 3)
+        err("usage: parse_time <legacy|scan|pratt> <file.qi>");
+    std::string mode = argv[1], file_name = argv[2];
+    options::parser = mode;
+
+    token_buffer buffer(lexer(fstream(file_name)).tokenize());
+    token_span tokens = buffer.span();
+    std::vector <std::pair<int, int>> bodies = fn_bodies(tokens);
+    std::vector <token> copy(&tokens[0], &tokens[0] + tokens.size());
+
+    std::size_t nodes = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (const std::pair<int, int> &body : bodies) {
+        if (mode == "legacy")
+            nodes += legacy_node(legacy_subarray(copy, body.first, body.second)).children.size();
+        else
+            nodes += ast_node(tokens.sub(body.first, body.second)).children.size();
+    }
+    auto stop = std::chrono::high_resolution_clock::now();
+
+    double ms = std::chrono::duration<double, std::milli>(stop - start).count();
+    std::cout << mode << ": " << tokens.size() << " tokens, " << bodies.size() << " functions, " << ms << " ms"
+              << std::endl;
+    return nodes == 0;
+}
@@ -0,0 +1,78 @@
+/*
+ * source_load.cpp contains:
+ *   - The legacy linked-list file stream, kept as the baseline
+ *   - Load time and peak RSS benchmark for the file stream
+ */
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include <sys/resource.h>
+
+#include "fstream.h"
+
+/// the file stream before the source buffer: one heap node per char
+class legacy_node {
+public:
+    char val;
+    legacy_node *next;
+
+    explicit legacy_node(char _val = 0) {
+        val = _val;
+        next = nullptr;
+    }
+};
+
+/// loads the file the way the legacy file stream did and walks it
+/// \param file_name: the source file
+/// \return the number of chars walked
+std::size_t load_legacy(const std::string &file_name) {
+    std::ifstream f(file_name);
+    if (!f.good())
+        err("file does not exist");
+    legacy_node *file = new legacy_node(), *dummy = file;
+    while (f.good()) {
+        dummy->next = new legacy_node((char) f.get());
+        dummy = dummy->next;
+    }
+    std::size_t count = 0;
+    while (file->next) {
+        legacy_node *prev = file;
+        file = file->next;
+        delete prev;
+        ++count;
+    }
+    return count;
+}
+
+/// loads the file into the source buffer and walks it
+/// \param file_name: the source file
+/// \return the number of chars walked
+std::size_t load_mmap(const std::string &file_name) {
+    fstream stream(file_name);
+    std::size_t count = 0;
+    while (stream.next()) {
+        stream.move();
+        ++count;
+    }
+    return count;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 3)
+        err("usage: source_load <legacy|mmap> <file.qi>");
+    std::string mode = argv[1], file_name = argv[2];
+
+    auto start = std::chrono::high_resolution_clock::now();
+    std::size_t count = mode == "legacy" ? load_legacy(file_name) : load_mmap(file_name);
+    auto stop = std::chrono::high_resolution_clock::now();
+
+    struct rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
+    std::cout << mode << ": " << count << " chars, " << duration.count() / 1000.0 << " ms, peak rss "
+              << usage.ru_maxrss << " KB" << std::endl;
+    return 0;
+}
@@ -0,0 +1,46 @@
+/*
+ * startup.cpp contains:
+ *   - Startup time benchmark for the front end with a growing number
+ *     of parser threads
+ */
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "fstream.h"
+#include "interpreter.h"
+#include "lexer.h"
+#include "memory.h"
+#include "options.h"
+#include "token.h"
+
+int main(int argc, char *argv[]) {
+    if (argc < 3)
+        err("usage: startup <file.qi> <jobs>...");
+    std::string file_name = argv[1];
+
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector <token> tokens = lexer(fstream(file_name)).tokenize();
+    auto stop = std::chrono::high_resolution_clock::now();
+    std::cout << "lex: " << std::chrono::duration<double, std::milli>(stop - start).count() << " ms, "
+              << std::thread::hardware_concurrency() << " hardware threads" << std::endl;
+
+    double base = 0;
+    for (int i = 2; i < argc; ++i) {
+        options::jobs = std::stoi(argv[i]);
+        // every run declares the same functions again
+        memory::clear();
+        start = std::chrono::high_resolution_clock::now();
+        interpreter runtime(tokens);
+        stop = std::chrono::high_resolution_clock::now();
+        double ms = std::chrono::duration<double, std::milli>(stop - start).count();
+        if (i == 2)
+            base = ms;
+        std::cout << "parse, " << options::jobs << " jobs: " << ms << " ms, speedup " << base / ms << "x"
+                  << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,173 @@
+/*
+ * ast.cpp contains:
+ *   - Definitions for the flat Abstract Syntax Tree
+ */
+
+#include "ast.h"
+#include "memory.h"
+#include "options.h"
+#include "runtime.h"
+
+static_assert(s_sort - s_push == n_sort - n_push, "methods must keep their symbol order");
+
+/// flattens a parsed syntax tree
+/// \param root: the root of the parsed tree
+ast::ast(const ast_node &root) : frame(0), bound(false) {
+    add(root);
+    nodes.shrink_to_fit();
+    lines.shrink_to_fit();
+    resolve();
+}
+
+/// restores a flattened tree, e.g. from a cache
+/// \param _nodes: the nodes in DFS order
+/// \param _lines: the line number of every node
+ast::ast(std::vector <node> _nodes, std::vector<int> _lines) : nodes(std::move(_nodes)), lines(std::move(_lines)),
+                                                               frame(0), bound(false) {
+    resolve();
+}
+
+/// appends a node and its subtree in DFS order
+/// \param u: the parsed node
+void ast::add(const ast_node &u) {
+    std::uint32_t i = (std::uint32_t) nodes.size();
+    nodes.push_back({u.val.val, 0, (std::uint32_t) u.children.size(), no_slot, u.val.ops, u.val.type});
+    lines.push_back(u.val.line);
+    for (const ast_node &v : u.children)
+        add(v);
+    nodes[i].end = (std::uint32_t) nodes.size();
+}
+
+/// tags every node with what the tree walker does at it, testing the
+/// node in the order the walker always has: declarations, groups,
+/// control structures, builtins, then symbols and literals
+void ast::resolve() {
+    for (std::uint32_t u = 0; u < nodes.size(); ++u) {
+        node &n = nodes[u];
+        if (token::is_var(n.val))
+            n.op = n_declare;
+        else if (n.type == t_group)
+            n.op = n_group;
+        else if (token::is_control(n.val)) {
+            if (n.val == s_if || n.val == s_elsif)
+                n.op = n_if;
+            else if (n.val == s_else)
+                n.op = n_else;
+            else if (n.val == s_while)
+                n.op = n_while;
+            else if (n.val == s_for)
+                n.op = n_for;
+            else
+                n.op = n_control;
+        } else if (n.type == t_builtin) {
+            if (n.ops != n.count)
+                n.op = n_arity;
+            else if (n.val == s_dot) {
+                std::uint32_t method = nodes[nodes[u + 1].end].val;
+                n.op = method >= s_push && method <= s_sort ? (n_op) (n_push + (method - s_push)) : n_method;
+            } else if (n.val == s_in)
+                n.op = n_in;
+            else if (n.val == s_continue)
+                n.op = n_continue;
+            else if (n.val == s_break)
+                n.op = n_break;
+            else if (n.val == s_out)
+                n.op = n_out;
+            else if (n.val == s_outl)
+                n.op = n_outl;
+            else if (n.val < s_count && runtime::operators[n.val])
+                n.op = n_binary;
+            else if (n.val == s_not)
+                n.op = n_not;
+            else if (n.val == s_return)
+                n.op = n_return;
+            else
+                n.op = n_operator;
+        } else if (n.type == t_symbol) {
+            if (n.val == s_floor)
+                n.op = n_floor;
+            else if (n.val == s_ceil)
+                n.op = n_ceil;
+            else if (n.val == s_round)
+                n.op = n_round;
+            else if (n.val == s_rand)
+                n.op = n_rand;
+            else
+                n.op = n_symbol;
+        } else if (n.type == t_num)
+            n.op = n_num;
+        else if (n.type == t_str)
+            n.op = n_str;
+        else
+            n.op = n_none;
+    }
+    // a `return` of a symbol in the place of a statement may return a
+    // call in tail position; whether the symbol is a function is only
+    // known at run time. A `return` inside an expression runs where it
+    // is, before the rest of the expression
+    tail(0);
+    for (std::uint32_t u = 0; u < nodes.size(); ++u) {
+        const node &n = nodes[u];
+        if (n.op == n_group)
+            for (std::uint32_t v = u + 1; v < n.end; v = nodes[v].end)
+                tail(v);
+        else if ((n.op == n_if || n.op == n_while || n.op == n_for) && n.count == 2)
+            tail(nodes[u + 1].end);
+        else if (n.op == n_else && n.count == 1)
+            tail(u + 1);
+    }
+}
+
+/// marks a statement that returns a symbol as a call in tail position
+/// \param u: the node index of the statement
+void ast::tail(std::uint32_t u) {
+    if (nodes[u].op == n_return && nodes[u].count == 1 && nodes[u + 1].op == n_symbol)
+        nodes[u].op = n_tail_call;
+}
+
+/// binds every symbol of the tree to the slot of its object, once all
+/// globals are declared: a global to its global slot, and the
+/// parameters, variables and loop variables of the function to local
+/// slots, in order. A function has a single scope, so a symbol has one
+/// slot in the whole body, and a global hides a local of its name.
+/// Every node starts with no heat, unless quickening is off
+/// \param fn: the function of the body
+void ast::bind(const object *fn) {
+    std::unordered_map<std::uint32_t, std::uint32_t> locals;
+    for (const f_param &param : fn->def->params)
+        locals.emplace(param.symbol, (std::uint32_t) locals.size());
+    for (std::uint32_t u = 0; u < nodes.size(); ++u) {
+        // `num x` declares x, and `for x of ...` declares x
+        std::uint32_t var = nodes[u].op == n_declare ? u + 1 : nodes[u].op == n_for ? u + 2 : u;
+        if (var != u && var < nodes[u].end && nodes[var].type == t_symbol)
+            locals.emplace(nodes[var].val, (std::uint32_t) locals.size());
+    }
+    for (node &n : nodes) {
+        n.slot = n.type == t_symbol ? memory::slot(n.val) : no_slot;
+        auto it = locals.find(n.val);
+        if (n.type == t_symbol && n.slot == no_slot && it != locals.end())
+            n.slot = it->second;
+    }
+    frame = (std::uint32_t) locals.size();
+    heat.assign(nodes.size(), options::quicken ? 0 : cold);
+}
+
+/// \param u: a node index
+/// \return the token the node was parsed from
+token ast::val(std::uint32_t u) const {
+    return token(nodes[u].val, lines[u], nodes[u].type, nodes[u].ops);
+}
+
+/// \return the memory held by the tree, in bytes
+std::size_t ast::bytes() const {
+    return sizeof(ast) + nodes.capacity() * sizeof(node) + lines.capacity() * sizeof(int);
+}
+
+/// prints a node and its subtree, one node per line
+/// \param u: the node index
+/// \param depth: the indentation level of the node
+void ast::print(std::uint32_t u, int depth) const {
+    std::cout << std::string(2 * depth, ' ') << val(u).str() << "\n";
+    for (std::uint32_t v = u + 1; v < nodes[u].end; v = nodes[v].end)
+        print(v, depth + 1);
+}
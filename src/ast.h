@@ -0,0 +1,153 @@
+/*
+ * ast.h contains:
+ *   - Declarations for the flat Abstract Syntax Tree
+ */
+
+#ifndef QI_INTERPRETER_AST_H
+#define QI_INTERPRETER_AST_H
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ast_node.h"
+#include "token.h"
+
+class object;
+
+/// what the tree walker does at a node; resolved once when a tree is
+/// built, so that the walker dispatches on a single switch instead of
+/// testing the symbol of every node against each keyword in turn
+enum n_op : std::uint8_t {
+    n_none,           // evaluates to none, e.g. a stray bracket
+    n_declare,        // declares a variable
+    n_group,          // runs a block of statements
+    n_if,             // `if` or `elsif`
+    n_else,
+    n_while,
+    n_for,
+    n_control,        // an unsupported control structure
+    n_arity,          // a builtin with the wrong number of operands
+    n_push,           // `.push(x)`; the methods follow in this order
+    n_pop,
+    n_len,
+    n_empty,
+    n_find,
+    n_reverse,
+    n_fill,
+    n_at,
+    n_next,
+    n_last,
+    n_sub,
+    n_clear,
+    n_sort,
+    n_method,         // an unknown method
+    n_in,
+    n_continue,
+    n_break,
+    n_out,
+    n_outl,
+    n_binary,         // a binary operator of the operator table
+    n_num_binary,     // a binary operator the type checker proved to
+                      // take two nums
+    n_quick_binary,   // n_binary quickened to two nums, until the
+                      // operands have other types
+    n_quick_at,       // n_at quickened to an arr indexed by a num
+    n_quick_len_arr,  // n_len quickened to an arr
+    n_quick_len_str,  // n_len quickened to a str
+    n_not,
+    n_return,
+    n_tail_call,      // `return f(...)`: a call in tail position, which
+                      // runs in place of the function if it can
+    n_operator,       // a builtin that is not an operator
+    n_symbol,         // a variable or a function call
+    n_floor,          // the builtin functions, unless redefined
+    n_ceil,
+    n_round,
+    n_rand,
+    n_num,
+    n_str
+};
+
+/// the syntax tree of a function body, flattened into one contiguous
+/// array of nodes in DFS order: the first child of a node directly
+/// follows it, and every node links to the end of its subtree, which
+/// is its next sibling; line numbers are only read on errors, so they
+/// are kept in a separate table
+class ast {
+public:
+    /// a symbol that is neither a global nor a local of its function
+    static constexpr std::uint32_t no_slot = UINT32_MAX;
+    /// slots from here on are global slots, and below are local ones
+    static constexpr std::uint32_t global_slot = 1u << 31;
+    /// the heat of a node that is never quickened
+    static constexpr std::uint8_t cold = UINT8_MAX;
+
+    /// a node of the flat tree; the slot of a symbol is bound before
+    /// the body first runs
+    struct node {
+        std::uint32_t val;
+        std::uint32_t end;
+        std::uint32_t count;
+        std::uint32_t slot;
+        short ops;
+        t_type type;
+        n_op op;
+    };
+
+    std::vector <node> nodes;
+    std::vector<int> lines;
+    // the runs in a row of each node with the operand types of its
+    // quickened op, once bound
+    std::vector <std::uint8_t> heat;
+    // the number of local slots of the function, once bound
+    std::uint32_t frame;
+    // whether the body was bound and type checked
+    bool bound;
+
+    explicit ast(const ast_node &root);
+
+    ast(std::vector <node> _nodes, std::vector<int> _lines);
+
+    /// \param u: a node index
+    /// \return the node at u
+    const node &operator[](std::uint32_t u) const {
+        return nodes[u];
+    }
+
+    /// finds a child by following the sibling links
+    /// \param u: a node index
+    /// \param i: the index of the child among the children of u
+    /// \return the node index of the child
+    std::uint32_t child(std::uint32_t u, std::uint32_t i) const {
+        std::uint32_t v = u + 1;
+        while (i--)
+            v = nodes[v].end;
+        return v;
+    }
+
+    /// \param u: a node index
+    /// \return the line number of the node
+    int line(std::uint32_t u) const {
+        return lines[u];
+    }
+
+    token val(std::uint32_t u) const;
+
+    std::size_t bytes() const;
+
+    void print(std::uint32_t u = 0, int depth = 0) const;
+
+    void bind(const object *fn);
+
+private:
+    void add(const ast_node &u);
+
+    void resolve();
+
+    void tail(std::uint32_t u);
+};
+
+#endif //QI_INTERPRETER_AST_H
@@ -1,7 +1,6 @@
 /*
  * ast_node.cpp contains:
  *   - Definitions for the Abstract Syntax Tree Node
- *   - Utility static methods, such as vector<token> subarray
  */
 
 #include "ast_node.h"
@@ -11,173 +10,210 @@
 /// \return
 ///   - true: if the tokens form a function call
 ///   - false: otherwise
-bool ast_node::is_fn(std::vector <token> &tokens) {
+bool ast_node::is_fn(token_span tokens) {
     // 1) the function call must be formatted as:
     //    [symbol] [left bracket] [parameters?] [right bracket]
-    bool valid = tokens.size() >= 3 && tokens[0].type == t_symbol && tokens[1].val == "(" &&
-                 tokens.back().val == ")";
     // 2) to avoid cases like `func1() func2()` from being split as
-    //    `func1` with parameter tokens `) func2(`, we validate the
-    //    brackets to ensure that the inside of the function call is
-    //    a valid parameter call
-    if (valid) {
-        int i = 2, depth = 0;
-        while (i < tokens.size() && !(depth == 0 && tokens[i].val == ")")) {
-            if (tokens[i].val == "(") ++depth;
-            if (tokens[i].val == ")") --depth;
-            ++i;
-        }
-        valid = (i == (tokens.size() - 1));
-    }
-    return valid;
+    //    `func1` with parameter tokens `) func2(`, the bracket after
+    //    the name must be closed by the last token
+    return tokens.size() >= 3 && tokens[0].type == t_symbol && tokens[1].val == s_lparen &&
+           tokens.back().val == s_rparen && tokens.partner(1) == tokens.size() - 1;
 }
 
+/// empty node, used for leaves that do not come from the source
+ast_node::ast_node() = default;
+
 /// constructs an `ast_node` from a sequence of tokens and
 /// recursively constructs its children
 /// \param tokens: the sequence of tokens
-ast_node::ast_node(std::vector <token> tokens) {
+/// \param in_line: whether the tokens lie within a single line, in
+///                 which case they form one block and are not split
+ast_node::ast_node(token_span tokens, bool in_line) {
     // find blocks
-    std::vector <std::pair<int, int>> blocks = ast_node::gen_blocks(tokens);
+    std::vector <std::pair<int, int>> blocks;
+    if (!in_line)
+        blocks = ast_node::gen_blocks(tokens);
+    else if (!tokens.empty())
+        blocks.emplace_back(0, tokens.size() - 1);
     if (blocks.empty())
         err("parsing error");
         // if there are multiple blocks, this is a group -> evaluate each
         // child block as a child
     else if (blocks.size() >= 2) {
-        val = token("GROUP", tokens[0].line, t_group, (int) blocks.size());
+        val = token(s_group, tokens[0].line, t_group, (int) blocks.size());
+        children.reserve(blocks.size());
         for (const std::pair<int, int> &block : blocks)
-            children.emplace_back(ast_node::subarray(tokens, block.first, block.second));
+            children.emplace_back(tokens.sub(block.first, block.second));
     } else {
-        tokens = subarray(tokens, blocks[0].first, blocks[0].second);
+        tokens = tokens.sub(blocks[0].first, blocks[0].second);
         // case 1) this is a start-end block
-        if (tokens.back().val == "end") {
+        if (tokens.back().val == s_end) {
             // `else` is the only start-end block without a condition
-            if (tokens.front().val == "else") {
-                val = token(tokens[0].val, tokens[0].line, tokens[0].type, tokens[0].ops);
+            if (tokens.front().val == s_else) {
+                val = tokens[0];
                 int start = 1;
                 for (; start < tokens.size(); ++start)
-                    if (tokens[start].val == "start")
+                    if (tokens[start].val == s_start)
                         break;
-                children.emplace_back(ast_node::subarray(tokens, start + 2, (int) tokens.size() - 2));
+                children.emplace_back(tokens.sub(start + 2, tokens.size() - 2));
             } else {
                 // otherwise, blocks are structured to have two children:
                 // 1) condition
                 // 2) child group
-                val = token(tokens[0].val, tokens[0].line, tokens[0].type, tokens[0].ops);
+                val = tokens[0];
                 int start = 2;
                 for (; start < tokens.size() - 1; ++start)
-                    if (tokens[start].val == "start")
+                    if (tokens[start].val == s_start)
                         break;
-                children.emplace_back(ast_node::subarray(tokens, 1, start - 1));
+                children.emplace_back(tokens.sub(1, start - 1));
                 if (tokens.size() - start < 4)
                     err("empty block", tokens[start].line);
-                children.emplace_back(ast_node::subarray(tokens, start + 2, (int) tokens.size() - 2));
+                children.emplace_back(tokens.sub(start + 2, tokens.size() - 2));
             }
         } else if (tokens.size() == 1) {
             // single token blocks are leaves in the trees
-            val = token(tokens[0].val, tokens[0].line, tokens[0].type, tokens[0].ops);
+            val = tokens[0];
         } else if (is_fn(tokens)) {
             // if a this is a function call, the node value is the
             // name of the function and the parameters are structured
             // as the children
-            val = token(tokens[0].val, tokens[0].line, tokens[0].type, tokens[0].ops);
-            int i = 2, depth = 0;
-            std::vector <token> curr;
-            // split by the `,` operator
+            val = tokens[0];
+            int i = 2, arg = 2;
+            // split by the `,` operator, skipping over bracketed groups
             while (i < tokens.size() - 1) {
-                if (depth == 0 && tokens[i].val == ",") {
-                    if (!curr.empty())
-                        children.emplace_back(curr);
-                    curr.clear();
-                } else {
-                    if (tokens[i].val == "(") ++depth;
-                    if (tokens[i].val == ")") --depth;
-                    curr.push_back(tokens[i]);
-                }
+                if (tokens[i].val == s_comma) {
+                    if (i > arg)
+                        children.emplace_back(tokens.sub(arg, i - 1), true);
+                    arg = i + 1;
+                } else if (tokens[i].val == s_lparen)
+                    i = tokens.partner(i);
                 ++i;
             }
-            if (!curr.empty())
-                children.emplace_back(curr);
+            if (i > arg)
+                children.emplace_back(tokens.sub(arg, i - 1), true);
         } else {
             // extract children from brackets (brackets can be
-            // ignored when the current node is enclosed in brackets
-            bool extracted = true;
-            while (extracted && tokens.front().val == "(" && tokens.back().val == ")") {
-                extracted = false;
-                int count = 0;
-                bool valid = true;
-                for (int i = 1; i < tokens.size() - 1; ++i) {
-                    std::string s = tokens[i].val;
-                    if (s != "(" && s != ")")
-                        continue;
-                    else if (s == "(")
-                        ++count;
-                    else if (count == 0) {
-                        valid = false;
-                        break;
-                    } else
-                        --count;
-                }
-                if (valid) {
-                    tokens.erase(tokens.begin());
-                    tokens.pop_back();
-                    extracted = true;
-                }
+            // ignored when the current node is enclosed in brackets,
+            // that is when the first bracket is not closed before the
+            // last one)
+            while (tokens.size() >= 2 && tokens.front().val == s_lparen && tokens.back().val == s_rparen) {
+                int close = tokens.partner(0);
+                if (close != -1 && close != tokens.size() - 1)
+                    break;
+                tokens = tokens.sub(1, tokens.size() - 2);
             }
 
-            // find the highest precedence operator in the expression
-            int pre = token::pre_none + 1, lowest_pre = -1, i = 0, depth;
-            while (i < tokens.size()) {
-                if (tokens[i].val == "(") {
-                    depth = 0;
-                    while (i < tokens.size() && !(depth == 1 && tokens[i].val == ")")) {
-                        if (tokens[i].val == "(") ++depth;
-                        if (tokens[i].val == ")") --depth;
-                        ++i;
-                    }
-                    if (i == tokens.size())
-                        err("unclosed bracket: " + tokens[i - 1].val, tokens[i - 1].line);
-                }
-                if (tokens[i].val == ")" && depth <= 0)
-                    err("unopened bracket", tokens[i].line);
-                if (tokens[i].type == t_num && tokens[i].val == ".") {
-                    tokens[i].type = t_builtin;
-                    tokens[i].ops = token::builtins[tokens[i].val].second;
-                }
-                if (tokens[i].type == t_builtin && token::builtins[tokens[i].val].second <= pre)
-                    pre = token::builtins[tokens[i].val].second, lowest_pre = i;
-
-                ++i;
-            }
-            if (lowest_pre == -1) {
-                if (tokens.size() == 1)
-                    lowest_pre = 0;
+            if (options::parser == "scan") {
+                parse_scan(tokens);
+            } else {
+                op_tree tree(tokens);
+                // an expression without operators is a single leaf or
+                // invalid, which the reference parser reports
+                if (tree.root == -1)
+                    parse_scan(tokens);
                 else
-                    err("unrecognized symbol in expression", tokens[0].line);
+                    build(tree, 0, tokens.size() - 1, tree.root);
             }
+        }
+    }
+}
 
-            // set the val to the operator and recurse the operands
-            val = token(tokens[lowest_pre].val, tokens[lowest_pre].line, tokens[lowest_pre].type,
-                        tokens[lowest_pre].ops);
-            if (val.ops == 1 || (val.val == "-" && (lowest_pre == 0 || lowest_pre == tokens.size() - 1))) {
-                if (lowest_pre != 0)
-                    err("unary operator in incorrect position", tokens[0].line);
-                if (val.val == "-") {
-                    std::vector <token> tmp;
-                    tmp.emplace_back("0", val.line, t_num, 0);
-                    children.emplace_back(tmp);
-                }
-                children.emplace_back(ast_node::subarray(tokens, 1, (int) tokens.size() - 1));
-            } else if (val.ops == 2 || val.val == ".") {
-                if (val.val == ".") {
-                    val.type = t_builtin;
-                    val.ops = 2;
-                }
-                if (lowest_pre == 0 || lowest_pre == tokens.size() - 1)
-                    err("binary operator in incorrect position", tokens[0].line);
-                children.emplace_back(ast_node::subarray(tokens, 0, lowest_pre - 1));
-                children.emplace_back(ast_node::subarray(tokens, lowest_pre + 1, (int) tokens.size() - 1));
-            }
+/// reference expression parser: splits the expression at its
+/// rightmost operator with the lowest precedence and recurses on the
+/// operands, rescanning each of them
+/// \param tokens: the expression, with enclosing brackets removed
+void ast_node::parse_scan(token_span tokens) {
+    // find the highest precedence operator in the expression
+    int pre = token::pre_none + 1, lowest_pre = -1, i = 0, depth = 0;
+    while (i < tokens.size()) {
+        if (tokens[i].val == s_lparen) {
+            int close = tokens.partner(i);
+            if (close == -1)
+                err("unclosed bracket: " + symbol::str(tokens.back().val), tokens.back().line);
+            i = close, depth = 1;
+        }
+        if (tokens[i].val == s_rparen && depth <= 0)
+            err("unopened bracket", tokens[i].line);
+        // a lone `.` is scanned as a number but is the member
+        // access operator
+        bool dot = tokens[i].type == t_num && tokens[i].val == s_dot;
+        if ((tokens[i].type == t_builtin || dot) && token::precedence(tokens[i].val) <= pre)
+            pre = token::precedence(tokens[i].val), lowest_pre = i;
+
+        ++i;
+    }
+    if (lowest_pre == -1) {
+        if (tokens.size() == 1)
+            lowest_pre = 0;
+        else
+            err("unrecognized symbol in expression", tokens[0].line);
+    }
+
+    // set the val to the operator and recurse the operands
+    val = tokens[lowest_pre];
+    if (val.ops == 1 || (val.val == s_minus && (lowest_pre == 0 || lowest_pre == tokens.size() - 1))) {
+        if (lowest_pre != 0)
+            err("unary operator in incorrect position", tokens[0].line);
+        if (val.val == s_minus) {
+            children.emplace_back();
+            children.back().val = token(s_zero, val.line, t_num, 0);
+        }
+        children.emplace_back(tokens.sub(1, tokens.size() - 1), true);
+    } else if (val.ops == 2 || val.val == s_dot) {
+        if (val.val == s_dot) {
+            val.type = t_builtin;
+            val.ops = 2;
+        }
+        if (lowest_pre == 0 || lowest_pre == tokens.size() - 1)
+            err("binary operator in incorrect position", tokens[0].line);
+        children.emplace_back(tokens.sub(0, lowest_pre - 1), true);
+        children.emplace_back(tokens.sub(lowest_pre + 1, tokens.size() - 1), true);
+    }
+}
+
+/// builds the node of an operator from the operator tree, reporting
+/// the same errors as the reference parser
+/// \param tree: the operator tree of the expression
+/// \param start: the first token of the operator's range
+/// \param end: the last token of the operator's range
+/// \param op: the index of the operator in the tree
+void ast_node::build(const op_tree &tree, int start, int end, int op) {
+    int k = tree.pos[op];
+    val = tree.tokens[k];
+    if (val.ops == 1 || (val.val == s_minus && (k == start || k == end))) {
+        if (k != start)
+            err("unary operator in incorrect position", tree.tokens[start].line);
+        if (val.val == s_minus) {
+            children.emplace_back();
+            children.back().val = token(s_zero, val.line, t_num, 0);
         }
+        add_operand(tree, k + 1, end, tree.right[op]);
+    } else if (val.ops == 2 || val.val == s_dot) {
+        if (val.val == s_dot) {
+            val.type = t_builtin;
+            val.ops = 2;
+        }
+        if (k == start || k == end)
+            err("binary operator in incorrect position", tree.tokens[start].line);
+        add_operand(tree, start, k - 1, tree.left[op]);
+        add_operand(tree, k + 1, end, tree.right[op]);
+    }
+}
+
+/// adds the operand of an operator as a child; operands without
+/// operators, and malformed ones the reference parser would reject
+/// or treat differently, are parsed on their own
+/// \param tree: the operator tree of the expression
+/// \param start: the first token of the operand
+/// \param end: the last token of the operand
+/// \param op: the index of the operand's root operator, or -1
+void ast_node::add_operand(const op_tree &tree, int start, int end, int op) {
+    token_span operand = tree.tokens.sub(start, end);
+    if (op == -1 || operand.size() == 1 || operand.back().val == s_end || tree.has_stray(start, end))
+        children.emplace_back(operand, true);
+    else {
+        children.emplace_back();
+        children.back().build(tree, start, end, op);
     }
 }
 
@@ -187,9 +223,9 @@ ast_node::ast_node(std::vector <token> tokens) {
 /// \param tokens: the sequence of tokens
 /// \param disallow_fn: defines if error is thrown if `fn` exists
 /// \return a list of start and end indices of the blocks
-std::vector <std::pair<int, int>> ast_node::gen_blocks(const std::vector <token> &tokens, bool disallow_fn) {
+std::vector <std::pair<int, int>> ast_node::gen_blocks(token_span tokens, bool disallow_fn) {
     std::vector <std::pair<int, int>> blocks;
-    int count = (int) tokens.size(), curr = 0, start, depth;
+    int count = tokens.size(), curr = 0, start;
     while (curr < count) {
         // should never be reached as blocks are consumed entirely
         // each time the while loop is run
@@ -198,49 +234,110 @@ std::vector <std::pair<int, int>> ast_node::gen_blocks(const std::vector <token>
         // either start of line or start of block
         start = curr;
         while (curr < count &&
-               !(tokens[curr].type == t_eof || tokens[curr].type == t_lb || tokens[curr].val == "start"))
+               !(tokens[curr].type == t_eof || tokens[curr].type == t_lb || tokens[curr].val == s_start))
             ++curr;
         if (curr == count || tokens[curr].type == t_eof || tokens[curr].type == t_lb) {
             blocks.emplace_back(start, curr - 1);
             ++curr;
             continue;
         }
-        depth = 1, ++curr;
         // get end of block
-        while (curr < count && tokens[curr].type != t_eof && !(depth == 1 && tokens[curr].val == "end")) {
-            if (tokens[curr].val == "start") ++depth;
-            if (tokens[curr].val == "end") --depth;
-            ++curr;
-        }
-        if (curr == count || tokens[curr].type == t_eof) {
-            for (token t : tokens)
-                std::cout << t.str() << std::endl;
-            err("unclosed block", tokens[curr - 1].line);
+        int close = tokens.partner(curr);
+        if (close == -1) {
+            while (curr < count && tokens[curr].type != t_eof)
+                ++curr;
+            std::string dump;
+            for (int i = 0; i < count; ++i)
+                dump += tokens[i].str() + "\n";
+            err("unclosed block", tokens[curr - 1].line, dump);
         }
         // validate function definition
-        if (disallow_fn && tokens[start].val == "fn")
+        if (disallow_fn && tokens[start].val == s_fn)
             err("cannot have nested functions", tokens[start].line);
-        blocks.emplace_back(start, curr);
-        curr += 2;
+        blocks.emplace_back(start, close);
+        curr = close + 2;
     }
-    if (blocks.back().first > blocks.back().second)
+    if (!blocks.empty() && blocks.back().first > blocks.back().second)
         blocks.pop_back();
     return blocks;
 }
 
-/// returns a subarray from the base array within the range start to
-/// inclusive
-/// \param tokens: the base tokens array
-/// \param start: the start index
-/// \param end: the end index
-/// \return tokens[start:end + 1]
-std::vector <token> ast_node::subarray(const std::vector <token> &tokens, int start, int end) {
-    return std::vector<token>(tokens.begin() + start, tokens.begin() + end + 1);
+/// scans one bracket level of an expression, reporting unclosed and
+/// unopened brackets, and arranges its operators by precedence
+/// \param _tokens: the expression, with enclosing brackets removed
+op_tree::op_tree(token_span _tokens) {
+    tokens = _tokens;
+    int depth = 0;
+    for (int i = 0; i < tokens.size(); ++i) {
+        bool closed = false;
+        if (tokens[i].val == s_lparen) {
+            int close = tokens.partner(i);
+            if (close == -1)
+                err("unclosed bracket: " + symbol::str(tokens.back().val), tokens.back().line);
+            groups.push_back(i);
+            i = close, depth = 1, closed = true;
+        }
+        if (tokens[i].val == s_rparen && !closed) {
+            if (depth <= 0)
+                err("unopened bracket", tokens[i].line);
+            strays.push_back(i);
+        }
+        if (is_op(tokens[i]))
+            pos.push_back(i);
+    }
+    left.assign(pos.size(), -1);
+    right.assign(pos.size(), -1);
+    std::size_t next = 0;
+    root = climb(next, std::numeric_limits<int>::min());
+}
+
+/// \param t: a token
+/// \return whether t is an operator the expression can be split at;
+///         a lone `.` is scanned as a number but is the member access
+///         operator
+bool op_tree::is_op(const token &t) {
+    return (t.type == t_builtin || (t.type == t_num && t.val == s_dot)) &&
+           token::precedence(t.val) <= token::pre_none + 1;
+}
+
+/// precedence climbing: parses a run of operators binding at least as
+/// tightly as min_pre, each taking the tighter-binding run after it as
+/// its right operand; equal precedences chain to the left, which
+/// matches splitting at the rightmost lowest-precedence operator, and
+/// a prefix operator is an operator with an empty left operand
+/// \param next: the next unparsed operator; advanced past the run
+/// \param min_pre: the lowest precedence the run may contain
+/// \return the root operator of the run, or -1 if it is empty
+int op_tree::climb(std::size_t &next, int min_pre) {
+    int root = -1;
+    while (next < pos.size() && token::precedence(tokens[pos[next]].val) >= min_pre) {
+        int op = (int) next++;
+        left[op] = root;
+        right[op] = climb(next, token::precedence(tokens[pos[op]].val) + 1);
+        root = op;
+    }
+    return root;
+}
+
+/// the reference parser rescans every operand for brackets, and
+/// rejects a `)` without a matching `(` only while no bracketed group
+/// has been seen in the operand
+/// \param start: the first token of the operand
+/// \param end: the last token of the operand
+/// \return whether the reference parser would reject the operand
+bool op_tree::has_stray(int start, int end) const {
+    for (auto s = std::lower_bound(strays.begin(), strays.end(), start); s != strays.end() && *s <= end; ++s) {
+        auto g = std::lower_bound(groups.begin(), groups.end(), start);
+        if (g == groups.end() || *g > *s)
+            return true;
+    }
+    return false;
 }
 
-/// prints the ast_node
-void ast_node::print() {
-    std::cout << val.val << "\n";
-    for (ast_node u : children)
-        u.print();
+/// prints the ast_node and its children, one node per line
+/// \param depth: the indentation level of the node
+void ast_node::print(int depth) {
+    std::cout << std::string(2 * depth, ' ') << val.str() << "\n";
+    for (ast_node &u : children)
+        u.print(depth + 1);
 }
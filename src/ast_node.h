@@ -1,35 +1,67 @@
 /*
  * ast_node.h contains:
+ *   - Declarations for the operator tree of an expression
  *   - Declarations for the Abstract Syntax Tree Node
  */
 
 #ifndef QI_INTERPRETER_AST_NODE_H
 #define QI_INTERPRETER_AST_NODE_H
 
+#include <algorithm>
 #include <iostream>
+#include <limits>
 #include <string>
 #include <vector>
 
+#include "options.h"
 #include "token.h"
 #include "util.h"
 
+/// the operators at one bracket level of an expression, arranged into
+/// the tree a precedence-climbing (Pratt) parse produces in a single
+/// pass; pos holds the token index of every operator, and left and
+/// right hold the root operator of each of its operands
+class op_tree {
+private:
+    int climb(std::size_t &next, int min_pre);
+
+public:
+    token_span tokens;
+    std::vector<int> pos, left, right, groups, strays;
+    int root;
+
+    explicit op_tree(token_span _tokens);
+
+    static bool is_op(const token &t);
+
+    bool has_stray(int start, int end) const;
+};
+
 /// ast_node is a node in the Abstract Syntax Tree that recursively
 /// creates its children nodes upon initialization, performing
-/// basic syntax and grammar validation
+/// basic syntax and grammar validation; children are built from
+/// sub-spans of the same token buffer, so no tokens are copied
 class ast_node {
 public:
     token val;
     std::vector <ast_node> children;
 
-    explicit ast_node(std::vector <token> tokens = std::vector<token>());
+    ast_node();
+
+    explicit ast_node(token_span tokens, bool in_line = false);
+
+    static std::vector <std::pair<int, int>> gen_blocks(token_span tokens, bool disallow_fn = true);
+
+    static bool is_fn(token_span tokens);
 
-    static std::vector <std::pair<int, int>> gen_blocks(const std::vector <token> &tokens, bool disallow_fn = true);
+    void print(int depth = 0);
 
-    static std::vector <token> subarray(const std::vector <token> &tokens, int start, int end);
+private:
+    void parse_scan(token_span tokens);
 
-    bool is_fn(std::vector <token> &tokens);
+    void build(const op_tree &tree, int start, int end, int op);
 
-    void print();
+    void add_operand(const op_tree &tree, int start, int end, int op);
 };
 
 #endif //QI_INTERPRETER_AST_NODE_H
@@ -0,0 +1,327 @@
+/*
+ * bytecode.cpp contains:
+ *   - Definitions for the bytecode compiler
+ *   - The bytecode printer
+ */
+
+#include "bytecode.h"
+
+/// compiles a function body. The value of a call is the value of the
+/// body: none for a block, but the value of the expression for a body
+/// of a single expression
+/// \param _tree: the syntax tree of the body
+bytecode::bytecode(ast *_tree) {
+    tree = _tree;
+    slots = 0;
+    compiled = true;
+    const ast::node &root = (*tree)[0];
+    // a lone `if` is the value of its own call, which only the tree
+    // walker keeps
+    if (root.val == s_if || root.val == s_elsif)
+        compiled = false;
+    else if (token::is_var(root.val) || root.type == t_group || token::is_control(root.val) || leaves(0)) {
+        statement(0);
+        emit(op_none);
+    } else
+        expression(0);
+    emit(op_leave, l_none);
+    code.shrink_to_fit();
+}
+
+/// appends an instruction
+/// \param op: the opcode
+/// \param a: the first operand
+/// \param b: the second operand
+/// \return the index of the instruction
+std::uint32_t bytecode::emit(opcode op, std::uint32_t a, std::uint32_t b) {
+    code.push_back({op, a, b});
+    return (std::uint32_t) code.size() - 1;
+}
+
+/// points a jump at the next instruction to be emitted
+/// \param at: the index of the jump
+void bytecode::patch(std::uint32_t at) {
+    code[at].a = (std::uint32_t) code.size();
+}
+
+/// raises an error when this point is reached
+/// \param message: the error message
+/// \param u: the node whose line is reported, or no_line
+void bytecode::error(const std::string &message, std::uint32_t u) {
+    messages.push_back(message);
+    emit(op_error, (std::uint32_t) messages.size() - 1, u);
+}
+
+/// \param u: a node index
+/// \return whether the node is a `return`, `break` or `continue`, which
+///         leave their statement
+bool bytecode::leaves(std::uint32_t u) const {
+    const ast::node &n = (*tree)[u];
+    return n.type == t_builtin && n.ops == n.count && (n.val == s_return || n.val == s_break || n.val == s_continue);
+}
+
+/// compiles the statements of a group; once a branch of an if chain is
+/// taken, it jumps past the rest of the chain
+/// \param u: the group node
+void bytecode::block(std::uint32_t u) {
+    std::vector <std::uint32_t> ends;
+    std::uint32_t count = (*tree)[u].count;
+    for (std::uint32_t i = 0, prev = u, v = u + 1; i < count; ++i, prev = v, v = (*tree)[v].end) {
+        std::uint32_t val = (*tree)[v].val, next = i + 1 < count ? (*tree)[(*tree)[v].end].val : s_blank;
+        bool chained = val == s_elsif || val == s_else;
+        if (chained && (i == 0 || ((*tree)[prev].val != s_if && (*tree)[prev].val != s_elsif))) {
+            error(val == s_elsif ? "elsif must follow if or elsif" : "else must follow if or elsif", v);
+            break;
+        }
+        if (!chained) {
+            for (std::uint32_t end : ends)
+                patch(end);
+            ends.clear();
+        }
+        if ((val == s_if || val == s_elsif) && (*tree)[v].count == 2 && (next == s_elsif || next == s_else))
+            branch(v, &ends);
+        else
+            statement(v);
+    }
+    for (std::uint32_t end : ends)
+        patch(end);
+}
+
+/// compiles a statement, which leaves nothing on the stack; statements
+/// that appear where a value is expected are left to the tree walker
+/// \param u: the node index
+void bytecode::statement(std::uint32_t u) {
+    const ast::node &n = (*tree)[u];
+    if (token::is_var(n.val))
+        emit(op_declare, 0, u);
+    else if (n.type == t_group)
+        block(u);
+    else if (token::is_control(n.val)) {
+        if ((n.val == s_if || n.val == s_elsif) && n.count == 2)
+            branch(u, nullptr);
+        else if (n.val == s_else && n.count == 1)
+            statement(u + 1);
+        else if (n.val == s_while && n.count == 2)
+            loop_while(u);
+        else if (n.val == s_for)
+            loop_for(u);
+        else
+            compiled = false;
+    } else if (leaves(u)) {
+        if (n.val == s_return) {
+            if (n.op == n_tail_call)
+                variable(u + 1, op_tail_call);
+            else
+                expression(u + 1);
+            emit(op_return);
+        } else if (loops.empty())
+            emit(op_leave, n.val == s_break ? l_break : l_continue);
+        else
+            (n.val == s_break ? loops.back().breaks : loops.back().continues).push_back(emit(op_jump));
+    } else {
+        expression(u);
+        emit(op_pop);
+    }
+}
+
+/// compiles an `if` or `elsif`
+/// \param u: the node index
+/// \param ends: the jumps past the rest of the chain, if the chain
+///              goes on
+void bytecode::branch(std::uint32_t u, std::vector <std::uint32_t> *ends) {
+    expression(u + 1);
+    std::uint32_t skip = emit(op_jump_false);
+    statement(tree->child(u, 1));
+    if (ends)
+        ends->push_back(emit(op_jump));
+    patch(skip);
+}
+
+/// compiles a `while` loop: the condition is tested before each pass
+/// \param u: the node index
+void bytecode::loop_while(std::uint32_t u) {
+    std::uint32_t test = (std::uint32_t) code.size();
+    expression(u + 1);
+    std::uint32_t exit = emit(op_jump_false);
+    loops.emplace_back();
+    statement(tree->child(u, 1));
+    for (std::uint32_t next : loops.back().continues)
+        code[next].a = test;
+    emit(op_jump, test);
+    patch(exit);
+    for (std::uint32_t brk : loops.back().breaks)
+        patch(brk);
+    loops.pop_back();
+}
+
+/// compiles a `for` loop over a range; the loop variable, the end and
+/// the step live in three slots of the frame. Malformed loops fail at
+/// the same point as in the tree walker
+/// \param u: the node index
+void bytecode::loop_for(std::uint32_t u) {
+    const ast::node &n = (*tree)[u];
+    if (n.count != 2)
+        return error("invalid for loop structure", u);
+    if ((*tree)[u + 1].val != s_of)
+        return error("must have of in for loop expression", u + 1);
+    if ((*tree)[u + 1].count != 2)
+        return error("of must have 2 children", u + 1);
+    std::uint32_t of = u + 1, var = of + 1, range = (*tree)[var].end;
+    if ((*tree)[var].type != t_symbol)
+        return error("left hand operand must be a symbol", var);
+    std::uint32_t slot = slots;
+    slots += 3;
+    emit(op_for_enter, slot, u);
+    if ((*tree)[range].val != s_range)
+        return error("right hand operand must be range(...)", of);
+    for (std::uint32_t v = range + 1; v < (*tree)[range].end; v = (*tree)[v].end) {
+        expression(v);
+        emit(op_check_int, 0, v);
+    }
+    if ((*tree)[range].count < 1 || (*tree)[range].count > 3)
+        return error("range must have 1-3 arguments", range);
+    emit(op_for_init, slot, range);
+
+    std::uint32_t test = emit(op_for_test, 0, slot);
+    loops.emplace_back();
+    statement((*tree)[of].end);
+    for (std::uint32_t next : loops.back().continues)
+        patch(next);
+    emit(op_for_step, test, slot);
+    patch(test);
+    for (std::uint32_t brk : loops.back().breaks)
+        patch(brk);
+    loops.pop_back();
+    emit(op_for_exit, slot, u);
+}
+
+/// compiles an expression, which leaves its value on the stack
+/// \param u: the node index
+void bytecode::expression(std::uint32_t u) {
+    const ast::node &n = (*tree)[u];
+    if (token::is_var(n.val)) {
+        emit(op_declare, 0, u);
+        emit(op_none);
+    } else if (n.type == t_group || token::is_control(n.val)) {
+        compiled = false;
+        emit(op_none);
+    } else if (n.type == t_builtin)
+        builtin(u);
+    else if (n.type == t_symbol)
+        variable(u);
+    else if (n.type == t_num) {
+        const std::string &val = symbol::str(n.val);
+        std::size_t offset = 0;
+        try {
+            numbers.push_back(std::stod(val, &offset));
+        } catch (const std::exception &) {
+            // what the tree walker does with a number that doesn't
+            // parse at all is its own business
+            compiled = false;
+            return (void) emit(op_none);
+        }
+        if (offset != val.size())
+            error("invalid number", u);
+        emit(op_num, (std::uint32_t) numbers.size() - 1);
+    } else if (n.type == t_str)
+        emit(op_str, n.val);
+    else
+        emit(op_none);
+}
+
+/// compiles a builtin operation: its operands are evaluated in order,
+/// except for the method of a `.`
+/// \param u: the node index
+void bytecode::builtin(std::uint32_t u) {
+    const ast::node &n = (*tree)[u];
+    if (n.ops != n.count)
+        return (void) emit(op_arity, 0, u);
+    if (n.val == s_dot) {
+        expression(u + 1);
+        return method(u);
+    } else if (n.val == s_in) {
+        expression(u + 1);
+        return (void) emit(op_in, 0, u);
+    } else if (n.val == s_return || n.val == s_break || n.val == s_continue) {
+        compiled = false;
+        return (void) emit(op_none);
+    }
+
+    for (std::uint32_t v = u + 1; v < n.end; v = (*tree)[v].end)
+        expression(v);
+    if (n.val == s_out)
+        emit(op_out);
+    else if (n.val == s_outl)
+        emit(op_outl);
+    else if (n.val == s_not)
+        emit(op_not);
+    else if (n.op == n_num_binary)
+        emit(op_num_binary, n.val);
+    else if (runtime::operators[n.val] && n.count == 2)
+        emit(op_binary, n.val);
+    else if (runtime::operators[n.val])
+        compiled = false;
+    else
+        error("operator \"" + symbol::str(n.val) + "\" not implemented", u);
+}
+
+/// compiles the method call on the right of a `.`; the target is
+/// already on the stack, and only methods with arguments evaluate them
+/// \param u: the `.` node
+void bytecode::method(std::uint32_t u) {
+    std::uint32_t call = (*tree)[u + 1].end, name = (*tree)[call].val, count = (*tree)[call].count, args = 0;
+    if (name == s_push || name == s_find || name == s_at)
+        args = 1;
+    else if (name == s_fill)
+        args = 3;
+    else if (name == s_sub) {
+        args = count;
+        if (count > 3)
+            return error("sub requires 0 to 3 arguments", no_line);
+    } else if (name != s_pop && name != s_len && name != s_empty && name != s_reverse && name != s_next &&
+               name != s_last && name != s_clear && name != s_sort)
+        return error("unknown method \"" + symbol::str(name) + "\"", u);
+    if (count != args && name != s_pop && name != s_len && name != s_empty && name != s_reverse && name != s_next &&
+        name != s_last && name != s_clear && name != s_sort)
+        return error(symbol::str(name) + (args == 1 ? " requires 1 argument" : " requires 3 arguments"), call);
+    for (std::uint32_t i = 0, v = call + 1; i < args; ++i, v = (*tree)[v].end)
+        expression(v);
+    emit(op_method, name, call);
+}
+
+/// compiles a symbol: a variable is pushed as it is, while the
+/// arguments of a function or builtin method are evaluated and passed
+/// to the call; which one it is is only known at run time
+/// \param u: the node index
+/// \param call: the opcode of the call
+void bytecode::variable(std::uint32_t u, opcode call) {
+    std::uint32_t skip = emit(op_symbol, 0, u);
+    for (std::uint32_t v = u + 1; v < (*tree)[u].end; v = (*tree)[v].end)
+        expression(v);
+    emit(call, 0, u);
+    patch(skip);
+}
+
+/// prints the instructions of the body, one per line, with the value
+/// an operand refers to
+void bytecode::print() const {
+    static const char *names[] = {"num", "str", "none", "pop", "jump", "jump_false", "error", "arity", "declare",
+                                  "symbol", "call", "tail_call", "method", "binary", "num_binary", "not", "out",
+                                  "outl", "in", "return", "leave", "check_int", "for_enter", "for_init", "for_test",
+                                  "for_step", "for_exit"};
+    if (!compiled) {
+        std::cout << "  runs on the tree walker\n";
+        return;
+    }
+    for (std::uint32_t i = 0; i < code.size(); ++i) {
+        const instruction &in = code[i];
+        std::cout << "  " << i << ": " << names[in.op] << " " << in.a << " " << in.b;
+        if (in.op == op_num)
+            std::cout << " (" << numbers[in.a] << ")";
+        else if (in.op == op_str || in.op == op_binary || in.op == op_method)
+            std::cout << " (" << symbol::str(in.a) << ")";
+        else if (in.op == op_error)
+            std::cout << " (" << messages[in.a] << ")";
+        std::cout << "\n";
+    }
+}
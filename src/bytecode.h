@@ -0,0 +1,127 @@
+/*
+ * bytecode.h contains:
+ *   - Opcodes for the bytecode VM
+ *   - Declarations for the bytecode compiler
+ */
+
+#ifndef QI_INTERPRETER_BYTECODE_H
+#define QI_INTERPRETER_BYTECODE_H
+
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "ast.h"
+#include "keywords.h"
+#include "object.h"
+#include "runtime.h"
+#include "symbol.h"
+#include "token.h"
+
+/// the operations of the VM; every operation that can fail keeps the
+/// syntax tree node it was compiled from, for the line of the error
+enum opcode : std::uint8_t {
+    op_num,        // push a number constant: a = constant
+    op_str,        // push a string constant: a = symbol
+    op_none,       // push a none object
+    op_pop,        // drop the top of the stack
+    op_jump,       // jump to a
+    op_jump_false, // pop a condition, jump to a if it is false
+    op_error,      // raise error a at node b, or without a line
+    op_arity,      // report the wrong operand count of node b
+    op_declare,    // declare the variable of node b
+    op_symbol,     // push variable b, or jump to a unless b is a
+                   // function or a builtin method and check its args
+    op_call,       // call the function or builtin method of node b
+    op_tail_call,  // op_call in tail position, whose callee runs in
+                   // place of the function if it returns its type
+    op_method,     // call method b on the target below its args
+    op_binary,     // pop two operands, push the operator a of them
+    op_num_binary, // op_binary on two operands checked to be nums
+    op_not,        // replace the top with its negation
+    op_out,        // print the top, replace it with none
+    op_outl,       // print the top and a newline, replace it with none
+    op_in,         // read a line into the top, replace it with none
+    op_return,     // return the top from the function
+    op_leave,      // leave the function with flag a raised
+    op_check_int,  // check that the range arg of node b is an integer
+    op_for_enter,  // declare the variable of the for loop b in slot a
+    op_for_init,   // pop the range args of node b into slot a
+    op_for_test,   // jump to a once slot b has reached its end
+    op_for_step,   // step slot b, jump to a
+    op_for_exit    // remove the variable of the for loop b
+};
+
+/// flags a function can be left with besides a normal return
+enum leave_flag : std::uint32_t {
+    l_none,
+    l_return,
+    l_continue,
+    l_break
+};
+
+/// one operation with two operands; a jump target is always `a`, and
+/// `b` is usually a node index
+struct instruction {
+    opcode op;
+    std::uint32_t a, b;
+};
+
+/// the compiled body of a function: a flat array of instructions that
+/// a stack VM runs instead of walking the syntax tree. Bodies that use
+/// statements in expressions (e.g. `return` inside an argument) are
+/// left to the tree walker, which is marked by `compiled`
+class bytecode {
+public:
+    static constexpr std::uint32_t no_line = UINT32_MAX;
+
+    ast *tree;
+    std::vector <instruction> code;
+    std::vector<double> numbers;
+    std::vector <std::string> messages;
+    std::uint32_t slots;
+    bool compiled;
+
+    explicit bytecode(ast *_tree);
+
+    void print() const;
+
+private:
+    /// a loop being compiled, with its pending `break` and `continue`
+    /// jumps
+    struct loop {
+        std::vector <std::uint32_t> breaks, continues;
+    };
+
+    std::vector <loop> loops;
+
+    std::uint32_t emit(opcode op, std::uint32_t a = 0, std::uint32_t b = 0);
+
+    void patch(std::uint32_t at);
+
+    void error(const std::string &message, std::uint32_t u);
+
+    bool leaves(std::uint32_t u) const;
+
+    void block(std::uint32_t u);
+
+    void statement(std::uint32_t u);
+
+    void branch(std::uint32_t u, std::vector <std::uint32_t> *ends);
+
+    void loop_while(std::uint32_t u);
+
+    void loop_for(std::uint32_t u);
+
+    void expression(std::uint32_t u);
+
+    void builtin(std::uint32_t u);
+
+    void method(std::uint32_t u);
+
+    void variable(std::uint32_t u, opcode call = op_call);
+};
+
+#endif //QI_INTERPRETER_BYTECODE_H
@@ -0,0 +1,317 @@
+/*
+ * cache.cpp contains:
+ *   - The layout of a cache file
+ *   - Definitions for the compiled program cache
+ */
+
+#include "cache.h"
+
+// a cache file holds, with every integer in native byte order:
+//   - "qic\n", u32 format, the interpreter version as u32 + bytes,
+//     u64 source hash, u64 source size, u32 size of a tree node and
+//     u64 hash of the rest of the file
+//   - u32 n, then n symbols as u32 + bytes, with ids from s_count on
+//   - u32 n, then n globals as u32 type, u32 name, i32 line
+//   - u32 n, then n functions as u32 name, u32 return type, u32 whether
+//     it is marked `memo`, u32 m,
+//     m parameters as u32 type, u32 symbol, u32 k, k tree nodes and
+//     k line numbers
+const char program_cache::magic[4] = {'q', 'i', 'c', '\n'};
+// bumped whenever the layout of the file or of a tree node changes
+const std::uint32_t program_cache::format = 3;
+// the hash of the sources that decide what a cache holds, from the
+// lexer to the tree layout, which the Makefile passes in; a change to
+// any of them keys new caches, so an older tree is never loaded
+#ifndef QI_CACHE_LAYOUT
+#error "QI_CACHE_LAYOUT must hold the hash of the sources that shape a program cache"
+#endif
+const std::string program_cache::version = QI_CACHE_LAYOUT;
+
+/// appends the bytes of a value to a cache file
+/// \param out: the cache file contents
+/// \param val: the value
+template<typename T>
+static void put(std::string &out, const T &val) {
+    out.append((const char *) &val, sizeof(T));
+}
+
+/// appends a length-prefixed string to a cache file
+/// \param out: the cache file contents
+/// \param val: the string
+static void put_str(std::string &out, std::string_view val) {
+    put(out, (std::uint32_t) val.size());
+    out.append(val);
+}
+
+/// a bounds-checked cursor over a mapped cache file; reading past the
+/// end marks the file as invalid and returns zeroes
+class cache_reader {
+private:
+    std::string_view data;
+    std::size_t pos;
+
+public:
+    bool valid;
+
+    explicit cache_reader(std::string_view _data) : data(_data), pos(0), valid(true) {}
+
+    /// \param count: a number of items
+    /// \param size: the size of an item
+    /// \return whether that many items are left in the file
+    bool fits(std::size_t count, std::size_t size) {
+        valid = valid && count <= (data.size() - pos) / size;
+        return valid;
+    }
+
+    /// copies the next bytes of the file
+    /// \param dest: the destination
+    /// \param size: the number of bytes
+    void bytes(void *dest, std::size_t size) {
+        if (fits(size, 1) && size > 0) {
+            std::memcpy(dest, data.data() + pos, size);
+            pos += size;
+        }
+    }
+
+    template<typename T>
+    T get() {
+        T val{};
+        bytes(&val, sizeof(T));
+        return val;
+    }
+
+    /// \return the unread part of the file
+    std::string_view rest() const {
+        return data.substr(pos);
+    }
+
+    /// \return the next length-prefixed string, viewing into the file
+    std::string_view str() {
+        std::uint32_t size = get<std::uint32_t>();
+        if (!fits(size, 1))
+            return {};
+        pos += size;
+        return data.substr(pos - size, size);
+    }
+};
+
+/// a cached global declaration
+struct cached_global {
+    std::uint32_t type, name;
+    int line;
+};
+
+/// a cached function declaration
+struct cached_fn {
+    std::uint32_t name, ret, memoized;
+    std::vector <f_param> params;
+    std::vector <ast::node> nodes;
+    std::vector<int> lines;
+};
+
+/// hashes a source file: FNV-1a over 8-byte words, with a shift after
+/// each multiply so that high bytes reach the low bits
+/// \param source: the source text
+/// \return the 64-bit hash
+std::uint64_t program_cache::hash(std::string_view source) {
+    const std::uint64_t prime = 1099511628211ull;
+    std::uint64_t h = 14695981039346656037ull ^ source.size();
+    std::size_t i = 0;
+    for (; i + 8 <= source.size(); i += 8) {
+        std::uint64_t word;
+        std::memcpy(&word, source.data() + i, 8);
+        h = (h ^ word) * prime;
+        h ^= h >> 29;
+    }
+    for (; i < source.size(); ++i)
+        h = (h ^ (unsigned char) source[i]) * prime;
+    return h ^ (h >> 32);
+}
+
+/// \param key: the source hash
+/// \return the cache file of the program: next to the source as
+///         `file.qic`, or named by the key in the cache directory
+std::string program_cache::path(std::uint64_t key) {
+    if (options::cache_dir.empty())
+        return options::file_name + "c";
+    char name[17];
+    std::snprintf(name, sizeof(name), "%016llx", (unsigned long long) key);
+    return options::cache_dir + "/" + name + ".qic";
+}
+
+/// loads the cached program of a source file
+/// \param key: the source hash
+/// \param size: the source size
+/// \return the interpreter with every global and function declared,
+///         or nullptr if there is no valid cache for the source
+std::unique_ptr <interpreter> program_cache::load(std::uint64_t key, std::size_t size) {
+    int fd = open(path(key).c_str(), O_RDONLY);
+    if (fd < 0)
+        return nullptr;
+    struct stat info{};
+    void *addr = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0)
+        addr = mmap(nullptr, (std::size_t) info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED)
+        return nullptr;
+
+    std::unique_ptr <interpreter> runtime = std::make_unique<interpreter>();
+    bool loaded = read(std::string_view((const char *) addr, (std::size_t) info.st_size), key, size, *runtime);
+    munmap(addr, (std::size_t) info.st_size);
+    return loaded ? std::move(runtime) : nullptr;
+}
+
+/// validates a cache file and declares its program; nothing but
+/// symbols is declared unless the whole file is valid
+/// \param data: the cache file contents
+/// \param key: the source hash
+/// \param size: the source size
+/// \param runtime: the interpreter to declare the program in
+/// \return whether the file was a valid cache of the source
+bool program_cache::read(std::string_view data, std::uint64_t key, std::size_t size, interpreter &runtime) {
+    cache_reader in(data);
+    char head[4];
+    in.bytes(head, sizeof(head));
+    if (!in.valid || std::memcmp(head, magic, sizeof(magic)) != 0 || in.get<std::uint32_t>() != format ||
+        in.str() != version || in.get<std::uint64_t>() != key || in.get<std::uint64_t>() != size ||
+        in.get<std::uint32_t>() != sizeof(ast::node))
+        return false;
+    std::uint64_t check = in.get<std::uint64_t>();
+    if (!in.valid || hash(in.rest()) != check)
+        return false;
+
+    // symbols are interned in id order, so the trees keep their ids
+    std::uint32_t count = in.get<std::uint32_t>();
+    for (std::uint32_t i = 0; i < count && in.valid; ++i) {
+        std::string_view name = in.str();
+        if (in.valid && symbol::intern(name) != s_count + i)
+            return false;
+    }
+    std::uint32_t symbols = s_count + count;
+
+    std::uint32_t n = in.get<std::uint32_t>();
+    if (!in.fits(n, 3 * sizeof(std::uint32_t)))
+        return false;
+    std::vector <cached_global> globals(n);
+    for (cached_global &g : globals) {
+        g = {in.get<std::uint32_t>(), in.get<std::uint32_t>(), in.get<int>()};
+        if (!token::is_var(g.type) || g.name >= symbols)
+            return false;
+    }
+
+    n = in.get<std::uint32_t>();
+    if (!in.fits(n, 4 * sizeof(std::uint32_t)))
+        return false;
+    std::vector <cached_fn> fns(n);
+    for (cached_fn &fn : fns) {
+        fn.name = in.get<std::uint32_t>();
+        fn.ret = in.get<std::uint32_t>();
+        fn.memoized = in.get<std::uint32_t>();
+        n = in.get<std::uint32_t>();
+        if (fn.name >= symbols || fn.ret > o_stack || fn.memoized > 1 || !in.fits(n, 2 * sizeof(std::uint32_t)))
+            return false;
+        for (std::uint32_t i = 0; i < n; ++i) {
+            std::uint32_t type = in.get<std::uint32_t>(), name = in.get<std::uint32_t>();
+            if (type > o_stack || name >= symbols)
+                return false;
+            fn.params.emplace_back((o_type) type, name);
+        }
+        n = in.get<std::uint32_t>();
+        if (n == 0 || !in.fits(n, sizeof(ast::node) + sizeof(int)))
+            return false;
+        fn.nodes.resize(n);
+        fn.lines.resize(n);
+        in.bytes(fn.nodes.data(), n * sizeof(ast::node));
+        in.bytes(fn.lines.data(), n * sizeof(int));
+        // the executor follows sibling links without bounds checks
+        for (std::uint32_t u = 0; u < n; ++u)
+            if (fn.nodes[u].end <= u || fn.nodes[u].end > fn.nodes[0].end || fn.nodes[u].val >= symbols)
+                return false;
+        if (fn.nodes[0].end != n)
+            return false;
+    }
+    if (!in.valid)
+        return false;
+
+    for (const cached_global &g : globals) {
+        token decl[2] = {token(g.type, g.line, t_builtin, token::arity(g.type)), token(g.name, g.line, t_symbol)};
+        memory::add(g.name, interpreter::declare_obj(token_span(decl, nullptr, 2)));
+    }
+    for (cached_fn &fn : fns) {
+        object *fn_obj = new object(o_fn);
+        fn_obj->def->returns = (o_type) fn.ret;
+        fn_obj->def->params = std::move(fn.params);
+        fn_obj->set_body(new ast(std::move(fn.nodes), std::move(fn.lines)));
+        if (fn.memoized)
+            fn_obj->def->table = new memo(fn.name);
+        memory::add(fn.name, fn_obj);
+        runtime.functions.push_back(fn.name);
+    }
+    return true;
+}
+
+/// writes the cache file of a program; lazily declared bodies are
+/// parsed first, and a program with a body that fails to parse is
+/// not cached, so that its error is still only reported on a call.
+/// The file is written aside and renamed into place, so concurrent
+/// runs never load a partial file
+/// \param runtime: the interpreter that declared the program
+/// \param key: the source hash
+/// \param size: the source size
+void program_cache::save(interpreter &runtime, std::uint64_t key, std::size_t size) {
+    try {
+        error_scope scope;
+        for (std::uint32_t id : runtime.functions)
+            memory::get(id)->body();
+    } catch (const deferred_error &) {
+        return;
+    }
+
+    std::string out;
+    put(out, symbol::count() - s_count);
+    for (std::uint32_t id = s_count; id < symbol::count(); ++id)
+        put_str(out, symbol::str(id));
+
+    put(out, (std::uint32_t) runtime.globals.size());
+    for (int i : runtime.globals) {
+        put(out, runtime.tokens[i].val);
+        put(out, runtime.tokens[i + 1].val);
+        put(out, runtime.tokens[i + 1].line);
+    }
+
+    put(out, (std::uint32_t) runtime.functions.size());
+    for (std::uint32_t id : runtime.functions) {
+        object *fn = memory::get(id);
+        put(out, id);
+        put(out, (std::uint32_t) fn->def->returns);
+        put(out, (std::uint32_t) (fn->def->table != nullptr));
+        put(out, (std::uint32_t) fn->def->params.size());
+        for (const f_param &param : fn->def->params) {
+            put(out, (std::uint32_t) param.type);
+            put(out, param.symbol);
+        }
+        const ast *tree = fn->def->body;
+        put(out, (std::uint32_t) tree->nodes.size());
+        out.append((const char *) tree->nodes.data(), tree->nodes.size() * sizeof(ast::node));
+        out.append((const char *) tree->lines.data(), tree->lines.size() * sizeof(int));
+    }
+
+    std::string head(magic, sizeof(magic));
+    put(head, format);
+    put_str(head, version);
+    put(head, key);
+    put(head, (std::uint64_t) size);
+    put(head, (std::uint32_t) sizeof(ast::node));
+    put(head, hash(out));
+
+    std::string file = path(key), temp = file + "." + std::to_string(getpid());
+    if (!options::cache_dir.empty())
+        mkdir(options::cache_dir.c_str(), 0755);
+    std::ofstream stream(temp, std::ios::binary);
+    stream.write(head.data(), (std::streamsize) head.size());
+    stream.write(out.data(), (std::streamsize) out.size());
+    stream.close();
+    if (!stream || std::rename(temp.c_str(), file.c_str()) != 0)
+        std::remove(temp.c_str());
+}
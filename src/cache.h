@@ -0,0 +1,56 @@
+/*
+ * cache.h contains:
+ *   - Declarations for the compiled program cache
+ */
+
+#ifndef QI_INTERPRETER_CACHE_H
+#define QI_INTERPRETER_CACHE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "ast.h"
+#include "interpreter.h"
+#include "memory.h"
+#include "object.h"
+#include "options.h"
+#include "symbol.h"
+#include "token.h"
+#include "util.h"
+
+/// the compiled program cache stores a program as it is after parsing:
+/// the interned symbols, the global declarations and the function
+/// table with the flat syntax tree of every body. A cache file (.qic)
+/// is keyed by the hash of the source and the interpreter version and
+/// is loaded with a single mmap; a file that doesn't match is ignored
+/// and rewritten, so stale caches never need to be removed by hand
+class program_cache {
+private:
+    static const char magic[4];
+    static const std::uint32_t format;
+    static const std::string version;
+
+    static std::string path(std::uint64_t key);
+
+    static bool read(std::string_view data, std::uint64_t key, std::size_t size, interpreter &runtime);
+
+public:
+    static std::uint64_t hash(std::string_view source);
+
+    static std::unique_ptr<interpreter> load(std::uint64_t key, std::size_t size);
+
+    static void save(interpreter &runtime, std::uint64_t key, std::size_t size);
+};
+
+#endif //QI_INTERPRETER_CACHE_H
@@ -0,0 +1,454 @@
+/*
+ * checker.cpp contains:
+ *   - Definitions for the static type checker
+ */
+
+#include "checker.h"
+
+/// \param t: a static type
+/// \param types: the accepted types
+/// \return whether t is known and not one of the accepted types
+static bool known_not(std::optional<o_type> t, std::initializer_list<o_type> types) {
+    return t && std::find(types.begin(), types.end(), *t) == types.end();
+}
+
+/// constructor for the checker of a function body
+/// \param _tree: the bound syntax tree of the body
+/// \param _fn: the function
+checker::checker(ast *_tree, object *_fn) : tree(_tree), fn(_fn), locals(_tree->frame), safe(true), error_line(0) {}
+
+/// checks a function body once its symbols are bound, and resolves the
+/// operators it proves to take nums to their fast path; does nothing
+/// with `--types=dynamic`
+/// \param fn: the function
+void checker::check(object *fn) {
+    if (options::types != "static")
+        return;
+    checker pass(fn->def->body, fn);
+    pass.declare_locals();
+    pass.statement(0);
+    if (!pass.safe)
+        return;
+    if (!pass.error.empty())
+        err(pass.error, pass.error_line);
+    for (std::uint32_t u : pass.specialized)
+        fn->def->body->nodes[u].op = n_num_binary;
+}
+
+/// \param fn: a function whose body is bound
+/// \return the static type of every local slot of the body, empty for a
+///         slot that is only typed at run time
+std::vector <std::optional<o_type>> checker::local_types(object *fn) {
+    checker pass(fn->def->body, fn);
+    pass.declare_locals();
+    return pass.locals;
+}
+
+/// records the first error of the body, raised once the whole body is
+/// known to be checked
+/// \param message: the error the operation would raise at run time
+/// \param u: the node of the operation
+void checker::reject(const std::string &message, std::uint32_t u) {
+    if (error.empty()) {
+        error = message;
+        error_line = tree->line(u);
+    }
+}
+
+/// finds the type of every local slot: a parameter or a variable has
+/// its declared type, and a loop variable is a num; a slot declared
+/// with different types in different places is only known at run time
+void checker::declare_locals() {
+    std::vector<bool> seen(locals.size(), false);
+    auto declare = [&](std::uint32_t slot, o_type type) {
+        if (slot >= locals.size())
+            return;
+        if (!seen[slot])
+            locals[slot] = type;
+        else if (locals[slot] != type)
+            locals[slot].reset();
+        seen[slot] = true;
+    };
+    for (std::uint32_t i = 0; i < fn->def->params.size(); ++i)
+        declare(i, fn->def->params[i].type);
+    for (std::uint32_t u = 0; u < tree->nodes.size(); ++u) {
+        const ast::node &n = (*tree)[u];
+        if (n.op == n_declare && n.count && (*tree)[u + 1].type == t_symbol && n.val != s_none)
+            declare((*tree)[u + 1].slot, object::sym_o_type(n.val));
+        else if (n.op == n_for && u + 2 < n.end && (*tree)[u + 2].type == t_symbol)
+            declare((*tree)[u + 2].slot, o_num);
+    }
+}
+
+/// checks a statement: a node whose value is dropped, so that it may
+/// leave the function or a loop
+/// \param u: the node index
+void checker::statement(std::uint32_t u) {
+    const ast::node &n = (*tree)[u];
+    switch (n.op) {
+        case n_group: {
+            for (std::uint32_t v = u + 1; v < n.end; v = (*tree)[v].end)
+                statement(v);
+            break;
+        }
+        case n_if:
+        case n_while: {
+            expression(u + 1);
+            statement(tree->child(u, 1));
+            break;
+        }
+        case n_else: {
+            statement(u + 1);
+            break;
+        }
+        case n_for: {
+            // a malformed loop fails before its body runs
+            std::uint32_t of = u + 1, var = of + 1, range = (*tree)[var].end;
+            if (n.count != 2 || (*tree)[of].val != s_of || (*tree)[of].count != 2 ||
+                (*tree)[var].type != t_symbol || (*tree)[range].val != s_range)
+                break;
+            for (std::uint32_t v = range + 1; v < (*tree)[range].end; v = (*tree)[v].end)
+                if (known_not(expression(v), {o_num}))
+                    reject("range arg must be integers", v);
+            statement((*tree)[of].end);
+            break;
+        }
+        case n_return:
+        case n_tail_call: {
+            static_type val = expression(u + 1);
+            if (fn->def->returns == o_none) {
+                if (val)
+                    reject("none function returned non-none object", u);
+            }
+            else if (known_not(val, {fn->def->returns}))
+                reject("function return type does not match returned object type", u);
+            break;
+        }
+        case n_continue:
+        case n_break:
+            break;
+        default:
+            expression(u);
+            break;
+    }
+}
+
+/// infers the type of an expression, and checks its operations
+/// \param u: the node index
+/// \return the type of the value of the expression
+checker::static_type checker::expression(std::uint32_t u) {
+    const ast::node &n = (*tree)[u];
+    switch (n.op) {
+        case n_declare:
+            // a malformed declaration, e.g. a lone `none`, fails at run
+            // time with its own error
+            if (!n.count || (*tree)[u + 1].type != t_symbol)
+                return {};
+            return o_none;
+        case n_none:
+            return o_none;
+        case n_num:
+            return o_num;
+        case n_str:
+            return o_str;
+        case n_group:
+        case n_if:
+        case n_else:
+        case n_while:
+        case n_for:
+        case n_return:
+        case n_tail_call:
+        case n_continue:
+        case n_break:
+            return control(u);
+        case n_in: {
+            if (known_not(expression(u + 1), {o_num, o_str}))
+                reject("unsupported input type", u);
+            return o_none;
+        }
+        case n_out:
+        case n_outl: {
+            expression(u + 1);
+            return o_none;
+        }
+        case n_not: {
+            expression(u + 1);
+            return o_bool;
+        }
+        case n_binary:
+            return binary(u);
+        case n_symbol:
+        case n_floor:
+        case n_ceil:
+        case n_round:
+        case n_rand:
+            return symbol(u);
+        case n_control:
+        case n_arity:
+        case n_operator:
+        case n_num_binary:
+        case n_quick_binary:
+        case n_quick_at:
+        case n_quick_len_arr:
+        case n_quick_len_str:
+            return {};
+        default:
+            return method(u);
+    }
+}
+
+/// a statement inside an expression may raise a flag, after which the
+/// rest of the expression evaluates to none; such a body is not checked
+/// \return an unknown type
+checker::static_type checker::control(std::uint32_t) {
+    safe = false;
+    return {};
+}
+
+/// checks a binary operator, and marks it for the num fast path when
+/// both operands are proven nums
+/// \param u: the node index
+/// \return the type of the result
+checker::static_type checker::binary(std::uint32_t u) {
+    const ast::node &n = (*tree)[u];
+    // `^=` is declared with one operand, which the object method
+    // doesn't support
+    if (n.count != 2) {
+        expression(u + 1);
+        return {};
+    }
+    static_type left = expression(u + 1), right = expression((*tree)[u + 1].end);
+    std::uint32_t base = runtime::compound_base(n.val);
+    if (n.val == s_assign || base != s_blank) {
+        static_type val = base == s_blank ? right : operation(base, left, right, u);
+        if (left == o_fn || (known_not(left, {o_bool, o_none}) && known_not(val, {*left})))
+            reject("cannot assign differently typed variables", u);
+        if (left == o_num && right == o_num && runtime::num_operator(n.val))
+            specialized.push_back(u);
+        return o_none;
+    }
+    static_type val = operation(n.val, left, right, u);
+    if (left == o_num && right == o_num && runtime::num_operator(n.val))
+        specialized.push_back(u);
+    return val;
+}
+
+/// checks an operator of the object methods on two operands
+/// \param op: the operator
+/// \param left: the type of the left operand
+/// \param right: the type of the right operand
+/// \param u: the node index
+/// \return the type of the result
+checker::static_type checker::operation(std::uint32_t op, static_type left, static_type right, std::uint32_t u) {
+    std::string message = symbol::str(op) + " not supported here";
+    switch (op) {
+        case s_plus: {
+            if (left && right) {
+                if (left == right && known_not(left, {o_num, o_str}))
+                    reject(message, u);
+                else if (left != right && left != o_str && right != o_str)
+                    reject(message, u);
+                return left == right ? left : o_str;
+            }
+            if (left == o_str || right == o_str)
+                return o_str;
+            return {};
+        }
+        case s_minus:
+        case s_star:
+        case s_star_star:
+        case s_slash:
+        case s_slash_slash:
+        case s_percent: {
+            if (known_not(left, {o_num}) || known_not(right, {o_num}))
+                reject(message, u);
+            return o_num;
+        }
+        // bitwise operators only test for an integer value, which a
+        // none object holds
+        case s_caret:
+        case s_bar:
+        case s_amp:
+        case s_shift_right:
+        case s_shift_left: {
+            if (known_not(left, {o_num, o_none}) || known_not(right, {o_num, o_none}))
+                reject(message, u);
+            return o_num;
+        }
+        case s_greater:
+        case s_less:
+        case s_greater_eq:
+        case s_less_eq: {
+            // `>=` and `<=` fail on the strict comparison first
+            std::uint32_t strict = op == s_greater || op == s_greater_eq ? s_greater : s_less;
+            if (left && left == right && known_not(left, {o_num, o_bool, o_str}))
+                reject(symbol::str(strict) + " not supported here", u);
+            return o_bool;
+        }
+        case s_eq_eq:
+        case s_not_eq: {
+            if (left && left == right && known_not(left, {o_num, o_bool, o_str, o_arr}))
+                reject("== not supported here", u);
+            return o_bool;
+        }
+        default:
+            return o_bool;
+    }
+}
+
+/// checks a method call on the right of a `.`
+/// \param u: the `.` node
+/// \return the type of the result
+checker::static_type checker::method(std::uint32_t u) {
+    const ast::node &n = (*tree)[u];
+    static_type target = expression(u + 1);
+    std::uint32_t call = (*tree)[u + 1].end, count = (*tree)[call].count;
+    std::vector <static_type> args;
+    for (std::uint32_t v = call + 1; v < (*tree)[call].end; v = (*tree)[v].end)
+        args.push_back(expression(v));
+    switch (n.op) {
+        case n_push: {
+            if (count != 1)
+                reject("push requires 1 argument", call);
+            else if (known_not(target, {o_arr, o_queue, o_stack, o_set}))
+                reject("objects can only be pushed to sequence objects" + std::to_string(*target), u);
+            return o_none;
+        }
+        case n_pop: {
+            // popping a stack falls through to the error
+            if (known_not(target, {o_str, o_arr, o_queue}))
+                reject("pop() is not supported on this object", u);
+            return o_none;
+        }
+        case n_len:
+        case n_empty: {
+            if (known_not(target, {o_str, o_arr, o_queue, o_stack}))
+                reject("len() is not supported on this object", u);
+            return n.op == n_len ? o_num : o_bool;
+        }
+        case n_find: {
+            if (count != 1)
+                reject("find requires 1 argument", call);
+            else if (target == o_str && known_not(args[0], {o_str}))
+                reject("only str can be searched for in str", u);
+            else if (known_not(target, {o_str, o_arr, o_set, o_map}))
+                reject("find() is only supported for str, arr and set", u);
+            if (target == o_str || target == o_arr)
+                return o_num;
+            if (target == o_set || target == o_map)
+                return o_bool;
+            return {};
+        }
+        case n_reverse: {
+            if (known_not(target, {o_str, o_arr}))
+                reject("rev() is not supported on this object", u);
+            return o_none;
+        }
+        case n_fill: {
+            if (count != 3)
+                reject("fill requires 3 arguments", call);
+            else if (known_not(target, {o_arr}))
+                reject("fill() may only be called on type arr", u);
+            return o_none;
+        }
+        case n_at: {
+            if (count != 1)
+                reject("at requires 1 argument", call);
+            else if ((target == o_str || target == o_arr) && known_not(args[0], {o_num, o_none}))
+                reject("index must be integer", u);
+            else if (known_not(target, {o_str, o_arr, o_map}))
+                reject("at() is not supported on this object", u);
+            if (target == o_str)
+                return o_str;
+            return {};
+        }
+        case n_next: {
+            if (known_not(target, {o_queue, o_stack}))
+                reject("next() is not supported on this object", u);
+            return {};
+        }
+        case n_last: {
+            if (known_not(target, {o_str, o_arr, o_queue}))
+                reject("last() is not supported on this object", u);
+            if (target == o_str)
+                return o_str;
+            return {};
+        }
+        case n_sub: {
+            if (count > 3)
+                reject("sub requires 0 to 3 arguments", u);
+            if (count == 0 || target == o_str || target == o_arr)
+                return target;
+            return {};
+        }
+        case n_clear: {
+            if (known_not(target, {o_str, o_arr, o_queue, o_stack, o_set, o_map}))
+                reject("clear() not supported for this object", u);
+            return o_none;
+        }
+        case n_sort: {
+            if (known_not(target, {o_str, o_arr}))
+                reject("sort() not supported on this object", u);
+            return o_none;
+        }
+        default: {
+            reject("unknown method \"" + symbol::str((*tree)[call].val) + "\"", u);
+            return {};
+        }
+    }
+}
+
+/// checks a symbol: a variable, a call of a function, or a builtin
+/// function unless a variable hides it
+/// \param u: the node index
+/// \return the type of the variable or of the result of the call
+checker::static_type checker::symbol(std::uint32_t u) {
+    const ast::node &n = (*tree)[u];
+    if (n.slot < ast::global_slot)
+        return locals[n.slot];
+    if (n.slot != ast::no_slot) {
+        object *obj = memory::globals[n.slot - ast::global_slot];
+        if (obj->type == o_fn)
+            return call(u, obj);
+        return obj->type;
+    }
+    if (n.op == n_symbol)
+        return {};
+
+    std::vector <static_type> args;
+    for (std::uint32_t v = u + 1; v < n.end; v = (*tree)[v].end)
+        args.push_back(expression(v));
+    if (n.op == n_floor || n.op == n_ceil) {
+        if (n.count != 1)
+            reject(symbol::str(n.val) + " requires 1 argument", u);
+        else if (known_not(args[0], {o_num}))
+            reject(symbol::str(n.val) + " only applies to num", u);
+    } else if (n.op == n_round) {
+        if (n.count != 2)
+            reject("round requires 2 arguments", u);
+        else if (known_not(args[0], {o_num}) || known_not(args[1], {o_num}))
+            reject("rand takes a num and a positive, non-zero int", u);
+    } else if (n.count != 0)
+        reject("rand takes no arguments", u);
+    return o_num;
+}
+
+/// checks a call of a user-defined function
+/// \param u: the node index
+/// \param callee: the function
+/// \return the return type, unless the function returns none, whose
+///         calls may still have the value of a body expression
+checker::static_type checker::call(std::uint32_t u, object *callee) {
+    const ast::node &n = (*tree)[u];
+    if (callee->def->params.size() != n.count) {
+        reject("incorrect number of children for function \"" + symbol::str(n.val) + "\"", u);
+        return {};
+    }
+    std::uint32_t i = 0;
+    for (std::uint32_t v = u + 1; v < n.end; v = (*tree)[v].end, ++i)
+        if (known_not(expression(v), {callee->def->params[i].type}))
+            reject("parameter types don't match", v);
+    if (callee->def->returns == o_none)
+        return {};
+    return callee->def->returns;
+}
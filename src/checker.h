@@ -0,0 +1,77 @@
+/*
+ * checker.h contains:
+ *   - Declarations for the static type checker
+ */
+
+#ifndef QI_INTERPRETER_CHECKER_H
+#define QI_INTERPRETER_CHECKER_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <initializer_list>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "ast.h"
+#include "memory.h"
+#include "object.h"
+#include "options.h"
+#include "runtime.h"
+#include "symbol.h"
+#include "token.h"
+#include "util.h"
+
+/// the static type checker infers the type of every expression of a
+/// function body from the declared types of its variables, parameters
+/// and functions, before the body first runs. An operation whose
+/// operand types are known and would fail at run time is rejected
+/// with the error it would raise, and an operator that is proven to
+/// take two nums is resolved to n_num_binary, whose fast path neither
+/// tests the operand types nor goes through the object methods.
+/// Functions with statements inside expressions are left unchecked,
+/// since a raised flag turns the rest of an expression into none
+class checker {
+private:
+    /// the static type of an expression; empty if it is only known at
+    /// run time
+    using static_type = std::optional<o_type>;
+
+    ast *tree;
+    object *fn;
+    std::vector <static_type> locals;
+    std::vector <std::uint32_t> specialized;
+    bool safe;
+    std::string error;
+    int error_line;
+
+    checker(ast *_tree, object *_fn);
+
+    void reject(const std::string &message, std::uint32_t u);
+
+    void declare_locals();
+
+    void statement(std::uint32_t u);
+
+    static_type expression(std::uint32_t u);
+
+    static_type control(std::uint32_t u);
+
+    static_type binary(std::uint32_t u);
+
+    static_type operation(std::uint32_t op, static_type left, static_type right, std::uint32_t u);
+
+    static_type method(std::uint32_t u);
+
+    static_type symbol(std::uint32_t u);
+
+    static_type call(std::uint32_t u, object *callee);
+
+public:
+    static void check(object *fn);
+
+    static std::vector <std::optional<o_type>> local_types(object *fn);
+};
+
+#endif //QI_INTERPRETER_CHECKER_H
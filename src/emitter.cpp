@@ -0,0 +1,981 @@
+/*
+ * emitter.cpp contains:
+ *   - Definitions for the C++ emitter
+ */
+
+#include "emitter.h"
+
+/// \param op: an arithmetic operator
+/// \param a: the C++ code of the left num
+/// \param b: the C++ code of the right num
+/// \return the C++ code of the operator on two nums, as
+///         runtime::num_value computes it
+static std::string num_value(std::uint32_t op, const std::string &a, const std::string &b) {
+    switch (op) {
+        case s_plus:
+            return a + " + " + b;
+        case s_minus:
+            return a + " - " + b;
+        case s_star:
+            return a + " * " + b;
+        case s_star_star:
+            return "std::pow(" + a + ", " + b + ")";
+        case s_slash:
+            return a + " / " + b;
+        case s_slash_slash:
+            return "std::floor(" + a + " / " + b + ")";
+        default:
+            return "std::fmod(" + a + ", " + b + ")";
+    }
+}
+
+/// \param type: the type of a global
+/// \return the type keyword that declares it
+static std::uint32_t keyword(o_type type) {
+    switch (type) {
+        case o_num:
+            return s_num;
+        case o_bool:
+            return s_bool;
+        case o_str:
+            return s_str;
+        case o_arr:
+            return s_arr;
+        case o_map:
+            return s_map;
+        case o_set:
+            return s_set;
+        case o_queue:
+            return s_queue;
+        default:
+            return s_stack;
+    }
+}
+
+/// prints the C++ translation of a program. The program is checked as
+/// it is before main runs, so that a program that fails there fails
+/// here with the same error; a function the bytecode compiler leaves
+/// to the tree walker can't be translated and is rejected
+/// \param program: the declared program
+void emitter::emit(const interpreter &program) {
+    object *root = memory::get(s_main);
+    if (root->def->params.size() != 0)
+        err("main must have no parameters");
+    if (root->def->returns != o_none)
+        err("main must have return type none");
+    for (std::uint32_t id : program.functions)
+        memory::get(id)->body();
+    for (std::uint32_t id : program.functions)
+        if (!memory::get(id)->code()->compiled)
+            err("function \"" + symbol::str(id) + "\" cannot be compiled to C++");
+
+    std::vector <std::pair<std::uint32_t, std::uint32_t>> globals;
+    for (const auto &[id, slot] : memory::table)
+        if (memory::globals[slot]->type != o_fn)
+            globals.emplace_back(slot, id);
+    std::sort(globals.begin(), globals.end());
+
+    std::ostringstream declarations, definitions;
+    for (std::uint32_t id : program.functions) {
+        emitter translation(memory::get(id), id);
+        translation.function();
+        declarations << translation.signature() << ";\n";
+        definitions << "\n" << translation.out.str();
+    }
+
+    std::cout << "// " << options::file_name << ", compiled by qi --emit-cpp\n\n#include \"runtime.h\"\n\n";
+    for (const auto &[slot, id] : globals)
+        std::cout << "static object *g_" << mangle(id) << ";\n";
+    if (!globals.empty())
+        std::cout << "\n";
+    std::cout << declarations.str() << definitions.str() << "\nint main() {\n";
+    for (const auto &[slot, id] : globals)
+        std::cout << "    g_" << mangle(id) << " = runtime::make(" << op(keyword(memory::globals[slot]->type))
+                  << ");\n";
+    // main runs on a stack of the size the program was translated with
+    std::cout << "    runtime::run_on_stack((std::size_t) " << options::stack_limit
+              << " << 20, [] { f_main(); });\n    return 0;\n}\n";
+}
+
+/// constructor for the emitter of a function; the slot types are the
+/// ones the type checker declares
+/// \param _fn: the function
+/// \param _id: the symbol of the function
+emitter::emitter(object *_fn, std::uint32_t _id) : fn(_fn), id(_id), tree(_fn->body()), depth(1), loops(0),
+                                                    temps(0) {
+    types = checker::local_types(fn);
+    slots.resize(tree->frame, c_obj);
+    names.resize(tree->frame);
+    defined.assign(tree->frame, false);
+    for (std::uint32_t i = 0; i < tree->frame; ++i)
+        if (types[i])
+            slots[i] = plain(*types[i]);
+    for (std::uint32_t i = 0; i < fn->def->params.size(); ++i) {
+        names[i] = "v_" + mangle(fn->def->params[i].symbol);
+        defined[i] = true;
+    }
+    for (const ast::node &n : tree->nodes)
+        if (n.type == t_symbol && n.slot < ast::global_slot)
+            names[n.slot] = "v_" + mangle(n.val);
+    // a slot of a declared name that turns out to be a global is
+    // never read
+    for (std::uint32_t i = 0; i < tree->frame; ++i)
+        if (names[i].empty())
+            names[i] = "v_" + std::to_string(i);
+}
+
+/// rejects a function that uses what the translation doesn't support,
+/// e.g. a local that may or may not shadow a builtin function
+void emitter::reject() const {
+    err("function \"" + symbol::str(id) + "\" cannot be compiled to C++");
+    std::abort();
+}
+
+/// appends a line of code at the current depth
+/// \param code: the line
+void emitter::line(const std::string &code) {
+    out << std::string(4 * depth, ' ') << code << "\n";
+}
+
+/// declares a temporary
+/// \param type: the type of the temporary
+/// \param init: the C++ code of its value
+/// \return the name of the temporary
+std::string emitter::temp(cpp_type type, const std::string &init) {
+    std::string name = "t" + std::to_string(++temps);
+    line(type_name(type) + name + " = " + init + ";");
+    return name;
+}
+
+/// raises an error when this point is reached
+/// \param message: the error message
+/// \param u: the node whose line is reported, or no_line
+void emitter::fail(const std::string &message, std::uint32_t u) {
+    if (u == bytecode::no_line)
+        line("runtime::fail(" + literal(message) + ");");
+    else
+        line("runtime::fail(" + literal(message) + ", " + std::to_string(tree->line(u)) + ");");
+}
+
+/// raises an error if a condition holds
+/// \param cond: the C++ code of the condition
+/// \param message: the error message
+/// \param u: the node whose line is reported, or no_line
+void emitter::check(const std::string &cond, const std::string &message, std::uint32_t u) {
+    line("if (" + cond + ")");
+    ++depth;
+    fail(message, u);
+    --depth;
+}
+
+/// \param u: a node index
+/// \return whether the node is a `return`, `break` or `continue`, which
+///         leave their statement
+bool emitter::leaves(std::uint32_t u) const {
+    const ast::node &n = (*tree)[u];
+    return n.type == t_builtin && n.ops == n.count && (n.val == s_return || n.val == s_break || n.val == s_continue);
+}
+
+/// \param slot: a local slot of a plain type
+/// \return the flag of whether its variable is declared
+std::string emitter::flag(std::uint32_t slot) const {
+    return "d" + names[slot].substr(1);
+}
+
+/// \return the C++ declaration of the function: plain parameters and
+///         return values are passed as plain C++ values, and a
+///         parameter whose slot is an object is boxed by the function
+std::string emitter::signature() const {
+    std::string params;
+    for (std::uint32_t i = 0; i < fn->def->params.size(); ++i) {
+        cpp_type type = plain(fn->def->params[i].type);
+        params += (i ? ", " : "") + type_name(type) + (slots[i] == type ? names[i] : "p" + std::to_string(i));
+    }
+    return "static " + type_name(plain(fn->def->returns)) + "f_" + mangle(id) + "(" + params + ")";
+}
+
+/// emits the definition of the function. A body that is a block or a
+/// statement has no value, while a body of a single expression is the
+/// value of a call of a none function
+void emitter::function() {
+    out << signature() << " {\n";
+    for (std::uint32_t i = 0; i < fn->def->params.size(); ++i) {
+        cpp_type type = plain(fn->def->params[i].type);
+        if (slots[i] != type)
+            line(type_name(slots[i]) + names[i] + " = " + box({"p" + std::to_string(i), type}) + ";");
+    }
+    // a call of the function itself in tail position starts over here
+    for (std::uint32_t u = 0; u < tree->nodes.size(); ++u)
+        if (tree->nodes[u].op == n_tail_call && restarts(u + 1)) {
+            out << "start:\n";
+            break;
+        }
+    for (std::uint32_t i = (std::uint32_t) fn->def->params.size(); i < tree->frame; ++i) {
+        if (slots[i] == c_obj)
+            line("object *" + names[i] + " = nullptr;");
+        else {
+            line(type_name(slots[i]) + names[i] + " = " + zero(slots[i]) + ";");
+            line("bool " + flag(i) + " = false;");
+        }
+    }
+
+    const ast::node &root = (*tree)[0];
+    value val;
+    if (token::is_var(root.val) || root.type == t_group || token::is_control(root.val) || leaves(0))
+        statement(0);
+    else
+        val = expression(0);
+    if (fn->def->returns != o_none)
+        fail("non-none function returned none", bytecode::no_line);
+    else
+        line("return " + box(val) + ";");
+    out << "}\n";
+}
+
+/// emits a statement, whose value is dropped
+/// \param u: the node index
+void emitter::statement(std::uint32_t u) {
+    const ast::node &n = (*tree)[u];
+    if (token::is_var(n.val))
+        declare(u);
+    else if (n.type == t_group)
+        block(u);
+    else if (token::is_control(n.val)) {
+        if ((n.val == s_if || n.val == s_elsif) && n.count == 2)
+            branch(u, false);
+        else if (n.val == s_else && n.count == 1)
+            statement(u + 1);
+        else if (n.val == s_while && n.count == 2)
+            loop_while(u);
+        else if (n.val == s_for)
+            loop_for(u);
+        else
+            reject();
+    } else if (leaves(u))
+        leave(u);
+    else
+        expression(u);
+}
+
+/// emits the statements of a group; an if chain is a nest of C++ `if`
+/// and `else` blocks, closed by the first statement after the chain
+/// \param u: the group node
+void emitter::block(std::uint32_t u) {
+    int chain = 0;
+    std::vector<bool> before;
+    auto close = [&]() {
+        if (!chain)
+            return;
+        for (; chain; --chain) {
+            --depth;
+            line("}");
+        }
+        defined = before;
+    };
+    std::uint32_t count = (*tree)[u].count;
+    for (std::uint32_t i = 0, prev = u, v = u + 1; i < count; ++i, prev = v, v = (*tree)[v].end) {
+        std::uint32_t val = (*tree)[v].val, next = i + 1 < count ? (*tree)[(*tree)[v].end].val : s_blank;
+        bool chained = val == s_elsif || val == s_else;
+        if (chained && (i == 0 || ((*tree)[prev].val != s_if && (*tree)[prev].val != s_elsif))) {
+            fail(val == s_elsif ? "elsif must follow if or elsif" : "else must follow if or elsif", v);
+            break;
+        }
+        if (!chained)
+            close();
+        if ((val == s_if || val == s_elsif) && (*tree)[v].count == 2 && (next == s_elsif || next == s_else)) {
+            if (!chain)
+                before = defined;
+            branch(v, true);
+            ++chain;
+        } else
+            statement(v);
+    }
+    close();
+}
+
+/// emits an `if` or `elsif`
+/// \param u: the node index
+/// \param chained: whether the chain goes on in an `else` block, which
+///                 the caller closes
+void emitter::branch(std::uint32_t u, bool chained) {
+    value cond = expression(u + 1);
+    line("if (" + truth(cond) + ") {");
+    ++depth;
+    std::vector<bool> before = defined;
+    statement(tree->child(u, 1));
+    defined = before;
+    --depth;
+    line(chained ? "} else {" : "}");
+    if (chained)
+        ++depth;
+}
+
+/// emits a `while` loop: the condition is tested before each pass
+/// \param u: the node index
+void emitter::loop_while(std::uint32_t u) {
+    std::vector<bool> before = defined;
+    line("while (true) {");
+    ++depth;
+    value cond = expression(u + 1);
+    line("if (!" + truth(cond) + ")");
+    line("    break;");
+    ++loops;
+    statement(tree->child(u, 1));
+    --loops;
+    --depth;
+    line("}");
+    defined = before;
+}
+
+/// emits a `for` loop over a range as a C++ `for` on the loop variable.
+/// Malformed loops fail at the same point as in the engines
+/// \param u: the node index
+void emitter::loop_for(std::uint32_t u) {
+    const ast::node &n = (*tree)[u];
+    if (n.count != 2)
+        return fail("invalid for loop structure", u);
+    if ((*tree)[u + 1].val != s_of)
+        return fail("must have of in for loop expression", u + 1);
+    if ((*tree)[u + 1].count != 2)
+        return fail("of must have 2 children", u + 1);
+    std::uint32_t of = u + 1, var = of + 1, range = (*tree)[var].end, slot = (*tree)[var].slot;
+    if ((*tree)[var].type != t_symbol)
+        return fail("left hand operand must be a symbol", var);
+    if (slot == ast::no_slot)
+        reject();
+    if (slot >= ast::global_slot || defined[slot])
+        return fail("for loop variable already defined", var);
+    bool boxed = slots[slot] == c_obj;
+    const std::string &it = names[slot];
+    check(boxed ? it : flag(slot), "for loop variable already defined", var);
+    // the loop variable is declared before the range is evaluated
+    if (boxed)
+        line(it + " = runtime::num(0);");
+    else {
+        line(it + " = 0;");
+        line(flag(slot) + " = true;");
+    }
+    defined[slot] = true;
+    if ((*tree)[range].val != s_range)
+        return fail("right hand operand must be range(...)", of);
+
+    // each bound is checked once it is evaluated, and read once all are
+    std::vector <std::string> bounds;
+    for (std::uint32_t v = range + 1; v < (*tree)[range].end; v = (*tree)[v].end) {
+        value arg = expression(v);
+        if (arg.type == c_num)
+            check("!(" + arg.code + " == static_cast<int>(" + arg.code + "))", "range arg must be integers", v);
+        else if (arg.type == c_obj)
+            check("!" + arg.code + "->is_int()", "range arg must be integers", v);
+        else if (arg.type != c_none)
+            fail("range arg must be integers", v);
+        bounds.push_back(arg.type == c_num ? arg.code : arg.type == c_obj ? unbox(c_num, arg.code) : "0.0");
+    }
+    if ((*tree)[range].count < 1 || (*tree)[range].count > 3)
+        return fail("range must have 1-3 arguments", range);
+    std::string end = temp(c_num, bounds.size() == 1 ? bounds[0] : bounds[1]);
+    std::string step = temp(c_num, bounds.size() == 3 ? bounds[2] : "1.0");
+    std::string start = bounds.size() == 1 ? "0.0" : bounds[0];
+    if (boxed) {
+        std::string at = unbox(c_num, it);
+        line("for (" + it + "->store = " + start + "; " + at + " < " + end + "; " + it + "->store = " + at + " + " +
+             step + ") {");
+    } else
+        line("for (" + it + " = " + start + "; " + it + " < " + end + "; " + it + " += " + step + ") {");
+    ++depth;
+    ++loops;
+    std::vector<bool> before = defined;
+    statement((*tree)[of].end);
+    defined = before;
+    --loops;
+    --depth;
+    line("}");
+    line(boxed ? it + " = nullptr;" : flag(slot) + " = false;");
+    defined[slot] = false;
+}
+
+/// emits a `return`, `break` or `continue`; outside a loop, a `break`
+/// or `continue` leaves the function with the error the engines raise
+/// \param u: the node index
+void emitter::leave(std::uint32_t u) {
+    const ast::node &n = (*tree)[u];
+    if (n.val == s_return) {
+        if (n.op == n_tail_call && restarts(u + 1))
+            return restart(u + 1);
+        value val = expression(u + 1);
+        o_type type = fn->def->returns;
+        if (type == o_none) {
+            // the returned value is copied before the error
+            if (val.type == c_obj)
+                line("runtime::copy(" + val.code + ");");
+            return fail("none function returned non-none object", bytecode::no_line);
+        }
+        cpp_type ret = plain(type);
+        if (ret != c_obj && val.type == ret)
+            return line("return " + val.code + ";");
+        std::string obj = temp(c_obj, "runtime::copy(" + box(val) + ")");
+        check(obj + "->type != " + o_name(type), "function return type does not match returned object type",
+              bytecode::no_line);
+        line("return " + (ret == c_obj ? obj : unbox(ret, obj)) + ";");
+    } else if (loops)
+        line(n.val == s_break ? "break;" : "continue;");
+    else if (fn->def->returns != o_none)
+        fail("non-none function returned none", bytecode::no_line);
+    else
+        fail(n.val == s_break ? "break called outside loop" : "continue called outside loop", bytecode::no_line);
+}
+
+/// emits a variable declaration, with the checks of
+/// interpreter::declare_obj; whether the variable is already declared
+/// is only tested at run time where it isn't known here
+/// \param u: the node index
+void emitter::declare(std::uint32_t u) {
+    const ast::node &n = (*tree)[u];
+    if (!n.count)
+        return fail("variable declaration format is [type] [identifier]", u);
+    std::uint32_t var = u + 1, slot = (*tree)[var].slot, name = (*tree)[var].val;
+    if ((*tree)[var].type != t_symbol)
+        return fail("invalid variable identifier", var);
+    std::string message = "cannot redeclare existing symbol \"" + symbol::str(name) + "\"";
+    if (!memory::valid(name) || slot >= ast::global_slot || defined[slot])
+        return fail(message, var);
+    check(slots[slot] == c_obj ? names[slot] : flag(slot), message, var);
+    o_type type = object::sym_o_type(n.val);
+    if (type == o_none || type == o_fn)
+        return fail("unimplemented var type", bytecode::no_line);
+    if (slots[slot] == c_obj)
+        line(names[slot] + " = runtime::make(" + op(n.val) + ");");
+    else {
+        line(names[slot] + " = " + zero(slots[slot]) + ";");
+        line(flag(slot) + " = true;");
+    }
+    defined[slot] = true;
+}
+
+/// emits an expression
+/// \param u: the node index
+/// \return its value
+emitter::value emitter::expression(std::uint32_t u) {
+    const ast::node &n = (*tree)[u];
+    if (token::is_var(n.val)) {
+        declare(u);
+        return {};
+    }
+    if (n.type == t_group || token::is_control(n.val))
+        reject();
+    if (n.type == t_builtin)
+        return builtin(u);
+    if (n.type == t_symbol)
+        return variable(u);
+    if (n.type == t_num) {
+        const std::string &val = symbol::str(n.val);
+        std::size_t offset = 0;
+        double num = 0;
+        try {
+            num = std::stod(val, &offset);
+        } catch (const std::exception &) {
+            reject();
+        }
+        if (offset != val.size())
+            fail("invalid number", u);
+        return {number(num), c_num};
+    }
+    if (n.type == t_str) {
+        const std::string &val = symbol::str(n.val);
+        if (val.find('\0') != std::string::npos)
+            return {"std::string(" + literal(val) + ", " + std::to_string(val.size()) + ")", c_str};
+        return {"std::string(" + literal(val) + ")", c_str};
+    }
+    return {};
+}
+
+/// emits a builtin operation: its operands are evaluated in order,
+/// except for the method of a `.`
+/// \param u: the node index
+/// \return its value
+emitter::value emitter::builtin(std::uint32_t u) {
+    const ast::node &n = (*tree)[u];
+    if (n.ops != n.count) {
+        line("std::cout << " + std::to_string(n.count) + " << std::endl;");
+        fail("incorrect number of children for operation \"" + symbol::str(n.val) + "\"", u);
+        return {};
+    }
+    if (n.val == s_dot)
+        return method(u, expression(u + 1));
+    if (n.val == s_in) {
+        value target = expression(u + 1);
+        std::string at = std::to_string(tree->line(u));
+        if (!target.var.empty() && target.type == c_num)
+            line(target.var + " = runtime::read_num(" + at + ");");
+        else if (!target.var.empty() && target.type == c_str)
+            line(target.var + " = runtime::read_str();");
+        else
+            line("runtime::read(" + box(target) + ", " + at + ");");
+        return {};
+    }
+    if (n.val == s_return || n.val == s_break || n.val == s_continue)
+        reject();
+
+    std::vector <value> operands;
+    for (std::uint32_t v = u + 1; v < n.end; v = (*tree)[v].end)
+        operands.push_back(expression(v));
+    if (n.val == s_out || n.val == s_outl) {
+        print(operands[0], n.val == s_outl);
+        return {};
+    }
+    if (n.val == s_not)
+        return {temp(c_bool, "!" + truth(operands[0])), c_bool};
+    if (runtime::operators[n.val] && n.count == 2)
+        return binary(u, operands[0], operands[1]);
+    if (runtime::operators[n.val])
+        reject();
+    fail("operator \"" + symbol::str(n.val) + "\" not implemented", u);
+    return {};
+}
+
+/// emits a binary operator: two nums, two strs and two bools are
+/// operated on as plain C++ values, and anything else goes through
+/// the object methods. The operands of an operator the type checker
+/// proved to take nums are nums even when they are objects
+/// \param u: the node index
+/// \param left: the left operand
+/// \param right: the right operand
+/// \return the result
+emitter::value emitter::binary(std::uint32_t u, const value &left, const value &right) {
+    std::uint32_t val = (*tree)[u].val;
+    if (val == s_assign || runtime::compound_base(val) != s_blank)
+        return assign(u, left, right);
+    bool proven = (*tree)[u].op == n_num_binary;
+    bool nums = (left.type == c_num || (proven && left.type == c_obj)) &&
+                (right.type == c_num || (proven && right.type == c_obj));
+    if (nums && runtime::arithmetic(val))
+        return {temp(c_num, num_value(val, num(left), num(right))), c_num};
+    if (nums && runtime::comparison(val))
+        return {temp(c_bool, num(left) + " " + symbol::str(val) + " " + num(right)), c_bool};
+    if (val == s_and || val == s_or)
+        return {temp(c_bool, truth(left) + (val == s_and ? " && " : " || ") + truth(right)), c_bool};
+    if (left.type == right.type && (left.type == c_str || left.type == c_bool) && runtime::comparison(val))
+        return {temp(c_bool, left.code + " " + symbol::str(val) + " " + right.code), c_bool};
+    if (left.type == c_str && right.type == c_str && val == s_plus)
+        return {temp(c_str, left.code + " + " + right.code), c_str};
+    if (runtime::comparison(val))
+        return {temp(c_bool, "runtime::compare(" + op(val) + ", " + box(left) + ", " + box(right) + ")"), c_bool};
+    return {temp(c_obj, "runtime::binary(" + op(val) + ", " + box(left) + ", " + box(right) + ")"), c_obj};
+}
+
+/// emits an assignment or a compound assignment. A plain local is
+/// assigned directly where the value fits its type; otherwise the
+/// object method runs on a copy of it, which is written back
+/// \param u: the node index
+/// \param left: the assigned value
+/// \param right: the value assigned
+/// \return the result, which is none unless an object method runs
+emitter::value emitter::assign(std::uint32_t u, const value &left, const value &right) {
+    std::uint32_t val = (*tree)[u].val, base = runtime::compound_base(val);
+    bool proven = (*tree)[u].op == n_num_binary;
+    const std::string &var = left.var;
+    if (!var.empty() && left.type == c_num && (right.type == c_num || (proven && right.type == c_obj)) &&
+        (val == s_assign || runtime::arithmetic(base))) {
+        line(var + " = " + (val == s_assign ? num(right) : num_value(base, var, num(right))) + ";");
+        return {};
+    }
+    if (!var.empty() && left.type == c_str && right.type == c_str && (val == s_assign || val == s_plus_eq)) {
+        line(var + (val == s_assign ? " = " : " += ") + right.code + ";");
+        return {};
+    }
+    if (!var.empty() && left.type == c_bool && val == s_assign) {
+        line(var + " = " + truth(right) + ";");
+        return {};
+    }
+    if (!var.empty() && val == s_assign && right.type == c_obj) {
+        // only an object of the type of the variable is assigned
+        check(right.code + "->type != " + (left.type == c_num ? "o_num" : "o_str"),
+              "cannot assign differently typed variables", bytecode::no_line);
+        line(var + " = " + unbox(left.type, right.code) + ";");
+        return {};
+    }
+    if (!var.empty()) {
+        std::string obj = temp(c_obj, box(left));
+        value res{temp(c_obj, "runtime::binary(" + op(val) + ", " + obj + ", " + box(right) + ")"), c_obj};
+        line(var + " = " + unbox(left.type, obj) + ";");
+        return res;
+    }
+    if (proven && left.type == c_obj) {
+        line(left.code + "->store = " +
+             (val == s_assign ? num(right) : num_value(base, unbox(c_num, left.code), num(right))) + ";");
+        return {};
+    }
+    return {temp(c_obj, "runtime::binary(" + op(val) + ", " + box(left) + ", " + box(right) + ")"), c_obj};
+}
+
+/// emits the method call on the right of a `.`, once its target is
+/// evaluated; only methods with arguments evaluate them
+/// \param u: the `.` node
+/// \param target: the target of the method
+/// \return the result of the method
+emitter::value emitter::method(std::uint32_t u, const value &target) {
+    std::uint32_t call = (*tree)[u + 1].end, name = (*tree)[call].val, count = (*tree)[call].count, args = 0;
+    bool bare = name == s_pop || name == s_len || name == s_empty || name == s_reverse || name == s_next ||
+                name == s_last || name == s_clear || name == s_sort;
+    if (name == s_push || name == s_find || name == s_at)
+        args = 1;
+    else if (name == s_fill)
+        args = 3;
+    else if (name == s_sub) {
+        args = count;
+        if (count > 3) {
+            fail("sub requires 0 to 3 arguments", bytecode::no_line);
+            return {};
+        }
+    } else if (!bare) {
+        fail("unknown method \"" + symbol::str(name) + "\"", u);
+        return {};
+    }
+    if (count != args && !bare) {
+        fail(symbol::str(name) + (args == 1 ? " requires 1 argument" : " requires 3 arguments"), call);
+        return {};
+    }
+    std::vector <value> params;
+    for (std::uint32_t i = 0, v = call + 1; i < args; ++i, v = (*tree)[v].end)
+        params.push_back(expression(v));
+
+    if (name == s_len && target.type == c_str)
+        return {temp(c_num, "(double) " + target.code + ".size()"), c_num};
+    if (name == s_len && target.type == c_obj)
+        return {temp(c_num, "runtime::len(" + target.code + ")"), c_num};
+    if (name == s_at && target.type == c_obj && params[0].type == c_num)
+        return {temp(c_obj, "runtime::at(" + target.code + ", " + params[0].code + ")"), c_obj};
+    // the methods that change a str in place run on a copy of a plain
+    // local, which is written back
+    bool changes = !target.var.empty() && target.type == c_str &&
+                   (name == s_pop || name == s_reverse || name == s_clear || name == s_sort);
+    std::string obj = changes ? temp(c_obj, box(target)) : box(target), list;
+    for (std::size_t i = 0; i < params.size(); ++i)
+        list += (i ? ", " : "") + box(params[i]);
+    value res{temp(c_obj, obj + "->" + symbol::str(name) + "(" + list + ")"), c_obj};
+    if (changes)
+        line(target.var + " = " + unbox(c_str, obj) + ";");
+    return res;
+}
+
+/// emits a symbol: a variable is read where it is used, and a function
+/// is called. Globals and functions are known here; a local is only
+/// tested to be declared where that isn't known
+/// \param u: the node index
+/// \return the variable or the value of the call
+emitter::value emitter::variable(std::uint32_t u) {
+    const ast::node &n = (*tree)[u];
+    bool library_fn = n.val == s_floor || n.val == s_ceil || n.val == s_round || n.val == s_rand;
+    if (n.slot == ast::no_slot) {
+        if (library_fn)
+            return library(u);
+        if (!token::is_method(n.val))
+            fail("symbol \"" + symbol::str(n.val) + "\" is undefined", u);
+        return {};
+    }
+    if (n.slot >= ast::global_slot) {
+        object *obj = memory::globals[n.slot - ast::global_slot];
+        if (obj->type == o_fn)
+            return call(u, obj);
+        return {"g_" + mangle(n.val), c_obj};
+    }
+    if (library_fn && !defined[n.slot])
+        reject();
+    if (!defined[n.slot]) {
+        check("!" + (slots[n.slot] == c_obj ? names[n.slot] : flag(n.slot)),
+              "symbol \"" + symbol::str(n.val) + "\" is undefined", u);
+        defined[n.slot] = true;
+    }
+    return {names[n.slot], slots[n.slot], slots[n.slot] == c_obj ? "" : names[n.slot]};
+}
+
+/// emits a call of a builtin function: floor, ceil, round or rand
+/// \param u: the node index
+/// \return the result
+emitter::value emitter::library(std::uint32_t u) {
+    const ast::node &n = (*tree)[u];
+    if ((n.val == s_floor || n.val == s_ceil) && n.count != 1) {
+        fail(symbol::str(n.val) + " requires 1 argument", u);
+        return {};
+    }
+    if (n.val == s_round && n.count != 2) {
+        fail("round requires 2 arguments", u);
+        return {};
+    }
+    if (n.val == s_rand) {
+        if (n.count != 0)
+            fail("rand takes no arguments", u);
+        return {temp(c_obj, "object::rand()"), c_obj};
+    }
+    value val = expression(u + 1);
+    if (n.val == s_round) {
+        value digits = expression(tree->child(u, 1));
+        return {temp(c_obj, box(val) + "->round(" + box(digits) + ")"), c_obj};
+    }
+    if (val.type == c_num)
+        return {temp(c_num, "std::" + symbol::str(n.val) + "(" + val.code + ")"), c_num};
+    return {temp(c_obj, box(val) + "->" + symbol::str(n.val) + "()"), c_obj};
+}
+
+/// emits a call of a function: the arguments are evaluated in order,
+/// then each is copied into its parameter and checked against its type
+/// \param u: the node index
+/// \param callee: the function
+/// \return the value of the call
+emitter::value emitter::call(std::uint32_t u, object *callee) {
+    const ast::node &n = (*tree)[u];
+    if (callee->def->params.size() != n.count) {
+        // the engines report the node type as the line
+        line("runtime::fail(" + literal("incorrect number of children for function \"" + symbol::str(n.val) + "\"") +
+             ", " + std::to_string(n.type) + ");");
+        return {};
+    }
+    std::string list;
+    for (const std::string &param : arguments(u, callee))
+        list += (list.empty() ? "" : ", ") + param;
+    line("runtime::check_stack(" + std::to_string(tree->line(u)) + ");");
+    cpp_type ret = plain(callee->def->returns);
+    return {temp(ret, "f_" + mangle(n.val) + "(" + list + ")"), ret};
+}
+
+/// emits the args of a call, which are evaluated in order, then each
+/// copied into its parameter and checked against its type
+/// \param u: the node index of the call
+/// \param callee: the function
+/// \return the value of each parameter
+std::vector <std::string> emitter::arguments(std::uint32_t u, object *callee) {
+    const ast::node &n = (*tree)[u];
+    std::vector <value> args;
+    for (std::uint32_t v = u + 1; v < n.end; v = (*tree)[v].end)
+        args.push_back(expression(v));
+    std::vector <std::string> params;
+    for (std::uint32_t i = 0, v = u + 1; i < args.size(); ++i, v = (*tree)[v].end) {
+        o_type type = callee->def->params[i].type;
+        cpp_type param = plain(type);
+        std::string code;
+        if (param == c_obj) {
+            code = temp(c_obj, "new object()");
+            line(code + "->assign(" + box(args[i]) + ");");
+            check(code + "->type != " + o_name(type), "parameter types don't match", v);
+        } else if (args[i].type == param)
+            code = args[i].code;
+        else if (args[i].type == c_obj) {
+            check(args[i].code + "->type != " + o_name(type), "parameter types don't match", v);
+            code = unbox(param, args[i].code);
+        } else {
+            fail("parameter types don't match", v);
+            code = zero(param);
+        }
+        params.push_back(code);
+    }
+    return params;
+}
+
+/// \param u: the node index of the operand of a `return`
+/// \return whether it is a call of the function itself, which runs in
+///         place of the function by jumping back to its start
+bool emitter::restarts(std::uint32_t u) const {
+    const ast::node &n = (*tree)[u];
+    return n.slot >= ast::global_slot && n.slot != ast::no_slot &&
+           memory::globals[n.slot - ast::global_slot] == fn && fn->def->params.size() == n.count;
+}
+
+/// emits `return f(...)` of the function itself in tail position: the
+/// parameters take the args and the body starts over, with every local
+/// declared again, so that the recursion runs in a loop
+/// \param u: the node index of the call
+void emitter::restart(std::uint32_t u) {
+    std::vector <std::string> params = arguments(u, fn);
+    // every arg is read before a parameter is written
+    for (std::uint32_t i = 0; i < params.size(); ++i)
+        params[i] = temp(plain(fn->def->params[i].type), params[i]);
+    for (std::uint32_t i = 0; i < params.size(); ++i) {
+        cpp_type type = plain(fn->def->params[i].type);
+        line(names[i] + " = " + (slots[i] == type ? params[i] : box({params[i], type})) + ";");
+    }
+    line("goto start;");
+}
+
+/// emits `out` or `outl`, which print a value as its object would be
+/// \param val: the value
+/// \param newline: whether a line ends after the value
+void emitter::print(const value &val, bool newline) {
+    std::string text;
+    switch (val.type) {
+        case c_num:
+            text = "runtime::num_str(" + val.code + ")";
+            break;
+        case c_bool:
+            text = "(" + val.code + " ? \"true\" : \"false\")";
+            break;
+        case c_str:
+            text = val.code;
+            break;
+        case c_none:
+            text = literal("none");
+            break;
+        default:
+            text = val.code + "->str()";
+            break;
+    }
+    line("std::cout << " + text + (newline ? " << std::endl;" : ";"));
+}
+
+/// \param type: an object type
+/// \return the C++ type a value of the type is held in
+emitter::cpp_type emitter::plain(o_type type) {
+    switch (type) {
+        case o_num:
+            return c_num;
+        case o_bool:
+            return c_bool;
+        case o_str:
+            return c_str;
+        default:
+            return c_obj;
+    }
+}
+
+/// \param type: a C++ type
+/// \return its name, as written before a declared name
+std::string emitter::type_name(cpp_type type) {
+    switch (type) {
+        case c_num:
+            return "double ";
+        case c_bool:
+            return "bool ";
+        case c_str:
+            return "std::string ";
+        default:
+            return "object *";
+    }
+}
+
+/// \param type: a plain C++ type
+/// \return the default value of a declared variable of the type
+std::string emitter::zero(cpp_type type) {
+    return type == c_num ? "0" : type == c_bool ? "false" : "std::string()";
+}
+
+/// \param type: an object type
+/// \return the C++ name of the type
+std::string emitter::o_name(o_type type) {
+    return "o_" + object::o_type_str(type);
+}
+
+/// \param id: a symbol id
+/// \return the symbol as a C++ identifier: characters that can't be
+///         part of one are written as their hex code
+std::string emitter::mangle(std::uint32_t id) {
+    std::ostringstream ss;
+    for (unsigned char c : symbol::str(id)) {
+        if (std::isalnum(c))
+            ss << c;
+        else if (c == '_')
+            ss << "__";
+        else
+            ss << "_" << std::hex << std::setw(2) << std::setfill('0') << (int) c << std::dec;
+    }
+    return ss.str();
+}
+
+/// \param val: a str
+/// \return the str as a C++ string literal
+std::string emitter::literal(const std::string &val) {
+    std::ostringstream ss;
+    ss << '"';
+    for (unsigned char c : val) {
+        if (c == '"' || c == '\\')
+            ss << '\\' << c;
+        else if (c == '\n')
+            ss << "\\n";
+        else if (c == '\t')
+            ss << "\\t";
+        else if (c < 0x20 || c >= 0x7f)
+            // octal escapes end after three digits, unlike hex ones
+            ss << '\\' << std::oct << std::setw(3) << std::setfill('0') << (int) c << std::dec;
+        else
+            ss << c;
+    }
+    ss << '"';
+    return ss.str();
+}
+
+/// \param val: a num
+/// \return the shortest C++ double literal that reads back as the num
+std::string emitter::number(double val) {
+    if (std::isnan(val))
+        return "std::nan(\"\")";
+    if (std::isinf(val))
+        return val > 0 ? "HUGE_VAL" : "(-HUGE_VAL)";
+    char buf[32];
+    // integers are written out, rather than in the shortest exponent
+    if (val == std::floor(val) && std::fabs(val) < 1e15) {
+        std::snprintf(buf, sizeof(buf), "%.1f", val);
+        return val < 0 ? "(" + std::string(buf) + ")" : buf;
+    }
+    for (int precision = 1; precision <= 17; ++precision) {
+        std::snprintf(buf, sizeof(buf), "%.*g", precision, val);
+        if (std::strtod(buf, nullptr) == val)
+            break;
+    }
+    std::string code = buf;
+    if (code.find_first_of(".e") == std::string::npos)
+        code += ".0";
+    return code[0] == '-' ? "(" + code + ")" : code;
+}
+
+/// \param id: a pre-assigned symbol, e.g. an operator
+/// \return its id as C++ code, with the symbol as a comment
+std::string emitter::op(std::uint32_t id) {
+    return std::to_string(id) + " /* " + symbol::str(id) + " */";
+}
+
+/// \param val: a value
+/// \return the C++ code of the value as an object; a plain value is
+///         copied into a new object
+std::string emitter::box(const value &val) {
+    switch (val.type) {
+        case c_num:
+            return "runtime::num(" + val.code + ")";
+        case c_bool:
+            return "runtime::boolean(" + val.code + ")";
+        case c_str:
+            return "runtime::str(" + val.code + ")";
+        case c_none:
+            return "(new object())";
+        default:
+            return val.code;
+    }
+}
+
+/// \param type: a plain C++ type
+/// \param obj: the C++ code of an object of the type
+/// \return the C++ code of the plain value of the object
+std::string emitter::unbox(cpp_type type, const std::string &obj) {
+    std::string name = type == c_num ? "double" : type == c_bool ? "bool" : "std::string";
+    return "std::get<" + name + ">(" + obj + "->store)";
+}
+
+/// \param val: a value that is a num, or an object that is one
+/// \return the C++ code of the num
+std::string emitter::num(const value &val) {
+    return val.type == c_obj ? unbox(c_num, val.code) : val.code;
+}
+
+/// \param val: a value
+/// \return the C++ code of whether the value is true in a condition
+std::string emitter::truth(const value &val) {
+    switch (val.type) {
+        case c_num:
+            return "(" + val.code + " != 0)";
+        case c_bool:
+            return val.code;
+        case c_str:
+            return "!" + val.code + ".empty()";
+        case c_none:
+            return "false";
+        default:
+            return "runtime::truth(" + val.code + ")";
+    }
+}
@@ -0,0 +1,164 @@
+/*
+ * emitter.h contains:
+ *   - Declarations for the C++ emitter
+ */
+
+#ifndef QI_INTERPRETER_EMITTER_H
+#define QI_INTERPRETER_EMITTER_H
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ast.h"
+#include "bytecode.h"
+#include "checker.h"
+#include "interpreter.h"
+#include "memory.h"
+#include "object.h"
+#include "options.h"
+#include "runtime.h"
+#include "symbol.h"
+#include "token.h"
+#include "util.h"
+
+/// translates a program into a standalone C++17 source file, printed
+/// for `--emit-cpp`, which only links the runtime library. Every
+/// function becomes a C++ function that runs its body as the bytecode
+/// compiler lays it out; a local or parameter whose slot only ever
+/// holds a num, bool or str is a plain C++ local, and everything else
+/// stays an object that the runtime operates on. Each step of an
+/// expression is a statement of its own, so that the operands are
+/// evaluated in the order the engines evaluate them, and an error is
+/// raised at the point where the engines raise it
+class emitter {
+private:
+    /// the C++ type a value is held in; none is only created once it
+    /// is used as an object
+    enum cpp_type {
+        c_obj,
+        c_num,
+        c_bool,
+        c_str,
+        c_none
+    };
+
+    /// an emitted value: a literal, a variable or a temporary, which
+    /// is read where it is used; var is the plain local it reads, to
+    /// write back what an object method changes
+    struct value {
+        std::string code;
+        cpp_type type = c_none;
+        std::string var;
+    };
+
+    object *fn;
+    std::uint32_t id;
+    ast *tree;
+    std::vector <std::optional<o_type>> types;
+    std::vector <cpp_type> slots;
+    std::vector <std::string> names;
+    // whether a local slot is surely declared at the emitted point
+    std::vector<bool> defined;
+    std::ostringstream out;
+    int depth;
+    int loops;
+    std::uint32_t temps;
+
+    emitter(object *_fn, std::uint32_t _id);
+
+    [[noreturn]] void reject() const;
+
+    void line(const std::string &code);
+
+    std::string temp(cpp_type type, const std::string &init);
+
+    void fail(const std::string &message, std::uint32_t u);
+
+    void check(const std::string &cond, const std::string &message, std::uint32_t u);
+
+    bool leaves(std::uint32_t u) const;
+
+    std::string flag(std::uint32_t slot) const;
+
+    std::string signature() const;
+
+    void function();
+
+    void statement(std::uint32_t u);
+
+    void block(std::uint32_t u);
+
+    void branch(std::uint32_t u, bool chained);
+
+    void loop_while(std::uint32_t u);
+
+    void loop_for(std::uint32_t u);
+
+    void leave(std::uint32_t u);
+
+    void declare(std::uint32_t u);
+
+    value expression(std::uint32_t u);
+
+    value builtin(std::uint32_t u);
+
+    value binary(std::uint32_t u, const value &left, const value &right);
+
+    value assign(std::uint32_t u, const value &left, const value &right);
+
+    value method(std::uint32_t u, const value &target);
+
+    value variable(std::uint32_t u);
+
+    value library(std::uint32_t u);
+
+    value call(std::uint32_t u, object *callee);
+
+    std::vector <std::string> arguments(std::uint32_t u, object *callee);
+
+    bool restarts(std::uint32_t u) const;
+
+    void restart(std::uint32_t u);
+
+    void print(const value &val, bool newline);
+
+    static cpp_type plain(o_type type);
+
+    static std::string type_name(cpp_type type);
+
+    static std::string zero(cpp_type type);
+
+    static std::string o_name(o_type type);
+
+    static std::string mangle(std::uint32_t id);
+
+    static std::string literal(const std::string &val);
+
+    static std::string number(double val);
+
+    static std::string op(std::uint32_t id);
+
+    static std::string box(const value &val);
+
+    static std::string unbox(cpp_type type, const std::string &obj);
+
+    static std::string num(const value &val);
+
+    static std::string truth(const value &val);
+
+public:
+    static void emit(const interpreter &program);
+};
+
+#endif //QI_INTERPRETER_EMITTER_H
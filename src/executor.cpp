@@ -9,422 +9,713 @@
 /// constructor for the executor
 /// \param _tree: AST that will be executed
 /// \param _parent: parent of AST (function)
-executor::executor(ast_node *_tree, object *_parent) {
+executor::executor(ast *_tree, object *_parent) {
     tree = _tree;
     parent = _parent;
 }
 
-/// starts the executor
+/// starts the executor. A call in tail position takes over the frame
+/// of the function and runs in the same executor, so that a chain of
+/// tail calls runs in constant stack and memory
 /// \return the return value of the function or none
-object *executor::init() {
-    has_return = false;
-    has_continue = false;
-    has_break = false;
-    object *res = run(tree);
-    // validate return
-    if (has_return && parent->f_return == o_none)
+value executor::init() {
+    for (;;) {
+        has_return = false;
+        has_continue = false;
+        has_break = false;
+        next = nullptr;
+        value res = eval(0);
+        // at most one flag is raised, since nothing runs after it
+        if (has_return && !next)
+            return leave(parent, l_return, return_val);
+        if (!next)
+            return leave(parent, has_continue ? l_continue : (has_break ? l_break : l_none), res);
+        memory::reuse(next->body()->frame, next->def->params.size());
+        for (std::uint32_t i = 0; i < next->def->params.size(); ++i)
+            memory::local(i) = args[params + i].obj();
+        args.resize(params);
+        parent = next;
+        tree = parent->body();
+        if (jit::hot(parent))
+            return value::of(jit::run(parent));
+    }
+}
+
+/// validates the way a function body was left; shared with the VM
+/// \param fn: the function
+/// \param flag: the flag the body was left with
+/// \param ret: the returned value, or else the value of the body
+/// \return the value of the call
+value executor::leave(object *fn, leave_flag flag, value ret) {
+    if (flag == l_return && fn->def->returns == o_none)
         err("none function returned non-none object");
-    if (!has_return && parent->f_return != o_none)
+    if (flag != l_return && fn->def->returns != o_none)
         err("non-none function returned none");
-    if (has_return && return_val->type != parent->f_return)
+    if (flag == l_return && ret.type() != fn->def->returns)
         err("function return type does not match returned object type");
-    if (has_continue)
+    if (flag == l_continue)
         err("continue called outside loop");
-    if (has_break)
+    if (flag == l_break)
         err("break called outside loop");
-    return has_return ? return_val : res;
+    return ret;
+}
+
+std::vector<value> executor::args;
+
+#ifdef QI_COUNT_VISITS
+/// the number of nodes visited by every executor, for benchmarks
+std::uint64_t executor::visits = 0;
+#endif
+/// the number of nodes quickened, and of quickened nodes turned back
+/// to their generic op
+std::uint64_t executor::specialized = 0;
+std::uint64_t executor::deoptimized = 0;
+
+/// counts a run of a generic node, and quickens it once its operands
+/// had the types of the quickened op for quicken_after runs in a row;
+/// a node that was deoptimized is never quickened again
+/// \param u: the node index
+/// \param fits: whether the operands of this run fit the quickened op
+/// \param quick: the quickened op
+/// \return whether the node was quickened
+bool executor::quicken(std::uint32_t u, bool fits, n_op quick) {
+    std::uint8_t &heat = tree->heat[u];
+    if (heat == ast::cold)
+        return false;
+    if (!fits) {
+        heat = 0;
+        return false;
+    }
+    if (++heat < quicken_after)
+        return false;
+    tree->nodes[u].op = quick;
+    ++specialized;
+    return true;
+}
+
+/// turns a quickened node whose operands no longer fit back to its
+/// generic op, for good
+/// \param u: the node index
+/// \param generic: the op the node was quickened from
+void executor::deoptimize(std::uint32_t u, n_op generic) {
+    tree->nodes[u].op = generic;
+    tree->heat[u] = ast::cold;
+    ++deoptimized;
+}
+
+/// runs a node to an object, for the nodes whose value is needed as one
+/// \param u: index of the node
+/// \return the value of the node, or a new none
+object *executor::run(std::uint32_t u) {
+    object *obj = exec(u);
+    return obj ? obj : new object();
 }
 
 /// recursively executes an AST with an inorder DFS traversal of the
-/// AST, with flags for if `return`, `continue` or `break` is called
-/// \param u: current AST node
-/// \return return value from subbranch/leaf execution
-object *executor::run(ast_node *u) {
+/// AST, with flags for if `return`, `continue` or `break` is called;
+/// every node is dispatched on the operation it was resolved to
+/// \param u: index of the current AST node
+/// \return return value from subbranch/leaf execution, or nullptr for
+///         none, which run and eval create as they need
+object *executor::exec(std::uint32_t u) {
     // only execute if no flags are set
-    if (!(has_return || has_continue || has_break)) {
-        // holds results from executing children
-        std::vector < object * > sub;
-        if (token::vars.find(u->val.val) != token::vars.end())
-            interpreter::declare_obj({u->val, u->children[0].val});
-        else if (u->val.type == t_group) {
-            // execute all blocks in group
-            for (int i = 0; i < u->children.size(); ++i) {
-                if (!(has_return || has_continue || has_break)) {
-                    // if we are at an elsif or else block, we must
-                    // validate by checking if the previous block was
-                    // an if block; otherwise, this is invalid
-                    // grammar and we can throw an error
-                    if (u->children[i].val.val == "elsif") {
-                        if (i == 0 || (u->children[i - 1].val.val != "if" && u->children[i - 1].val.val != "elsif"))
-                            err("elsif must follow if or elsif", u->children[i].val.line);
-                        if (std::get<bool>(sub.back()->store)) {
-                            sub.push_back(sub.back());
-                            continue;
-                        }
-                    } else if (u->children[i].val.val == "else") {
-                        if (i == 0 || (u->children[i - 1].val.val != "if" && u->children[i - 1].val.val != "elsif"))
-                            err("else must follow if or elsif", u->children[i].val.line);
-                        if (std::get<bool>(sub.back()->store))
-                            continue;
-                    }
-                    sub.push_back(run(&(u->children[i])));
+    if (has_return || has_continue || has_break)
+        return nullptr;
+    visit();
+    const ast::node &n = (*tree)[u];
+    switch (n.op) {
+        case n_declare: {
+            // a type keyword without an identifier, e.g. `none`, is
+            // passed alone and rejected by the declaration
+            token decl[2] = {tree->val(u), n.count ? tree->val(u + 1) : token()};
+            bool defined = n.count && memory::find((*tree)[u + 1].slot);
+            object *obj = interpreter::declare_obj(token_span(decl, nullptr, n.count ? 2 : 1), defined);
+            memory::local((*tree)[u + 1].slot) = obj;
+            break;
+        }
+        case n_group: {
+            group(u);
+            break;
+        }
+        // if control structure: computed to whether its body ran
+        case n_if:
+            return compute(u).box();
+        case n_else: {
+            run(u + 1);
+            break;
+        }
+        case n_while: {
+            // execute the while loop
+            while (runtime::truth(eval(u + 1))) {
+                // run the body
+                block(tree->child(u, 1));
+                // count the pass towards compiling the function
+                jit::hot(parent);
+                // if continue or break is called while running the
+                // body, then perform the correct action and unset the
+                // flag
+                if (has_continue)
+                    has_continue = false;
+                if (has_break) {
+                    has_break = false;
+                    break;
                 }
             }
-        } else if (token::control.find(u->val.val) != token::control.end()) {
-            // if control structure: test condition, then execute
-            // its body accordingly
-            if (u->val.val == "if" || u->val.val == "elsif") {
-                object *ret = new object(o_bool);
-                if (std::get<bool>(run(&u->children[0])->to_bool()->store)) {
-                    run(&u->children[1]);
-                    ret->set(true);
-                } else
-                    ret->set(false);
-                return ret;
-            } else if (u->val.val == "else") {
-                run(&u->children[0]);
-            } else if (u->val.val == "while") {
-                // execute the while loop
-                while (std::get<bool>(run(&u->children[0])->to_bool()->store)) {
-                    // run the body
-                    run(&u->children[1]);
-                    // if continue or break is called while running
-                    // the body, then perform the correct action
-                    // and unset the flag
-                    if (has_continue)
-                        has_continue = false;
-                    if (has_break) {
-                        has_break = false;
-                        break;
-                    }
-                }
-            } else if (u->val.val == "for") {
-                // validate for loop condition
-                if (u->children.size() != 2)
-                    err("invalid for loop structure", u->val.line);
-                else if (u->children[0].val.val != "of")
-                    err("must have of in for loop expression", u->children[0].val.line);
-                else if (u->children[0].children.size() != 2)
-                    err("of must have 2 children", u->children[0].val.line);
-                ast_node *of = &(u->children[0]);
-                if (of->children[0].val.type != t_symbol)
-                    err("left hand operand must be a symbol", of->children[0].val.line);
-                else if (memory::has(of->children[0].val.val))
-                    err("for loop variable already defined", of->children[0].val.line);
-                object *it = new object(o_num),
-                        *start = new object(o_num),
-                        *end = new object(o_num),
-                        *every = new object(o_num);
-
-                // add the loop variable, e.g. `i` to the memory
-                memory::add(of->children[0].val.val, it);
+            break;
+        }
+        case n_for: {
+            // validate for loop condition
+            if (n.count != 2)
+                err("invalid for loop structure", tree->line(u));
+            else if ((*tree)[u + 1].val != s_of)
+                err("must have of in for loop expression", tree->line(u + 1));
+            else if ((*tree)[u + 1].count != 2)
+                err("of must have 2 children", tree->line(u + 1));
+            std::uint32_t of = u + 1, var = of + 1, range = (*tree)[var].end;
+            if ((*tree)[var].type != t_symbol)
+                err("left hand operand must be a symbol", tree->line(var));
+            else if (memory::find((*tree)[var].slot))
+                err("for loop variable already defined", tree->line(var));
+            // add the loop variable, e.g. `i` to the memory; the range
+            // is kept in doubles, and the variable is one num object that
+            // the body reads and may assign to
+            object *it = memory::acquire();
+            it->type = o_num;
+            it->store = 0.0;
+            memory::local((*tree)[var].slot) = it;
 
-                start->set((double) 0);
-                end->set((double) 0);
-                every->set((double) 1);
+            if ((*tree)[range].val != s_range)
+                err("right hand operand must be range(...)", tree->line(of));
 
-                if (of->children[1].val.val != "range")
-                    err("right hand operand must be range(...)", of->val.line);
+            double bounds[3] = {0, 0, 1};
+            std::uint32_t count = (*tree)[range].count, i = 0;
+            for (std::uint32_t v = range + 1; v < (*tree)[range].end; v = (*tree)[v].end, ++i) {
+                object *arg = run(v);
+                if (!arg->is_int())
+                    err("range arg must be integers", tree->line(v));
+                if (i < 3)
+                    bounds[count == 1 ? 1 : i] = std::get<double>(arg->store);
+            }
+            if (count < 1 || count > 3)
+                err("range must have 1-3 arguments", tree->line(range));
+            double end = bounds[1], every = bounds[2];
+            it->store = bounds[0];
 
-                ast_node range = of->children[1];
-                for (ast_node &v : range.children) {
-                    sub.push_back(run(&v));
-                    if (!sub.back()->is_int())
-                        err("range arg must be integers", v.val.line);
-                }
-                if (range.children.size() < 1 || range.children.size() > 3)
-                    err("range must have 1-3 arguments", range.val.line);
-                switch (range.children.size()) {
-                    case 1: {
-                        end->set(std::get<double>(sub[0]->store));
-                        break;
-                    }
-                    case 2: {
-                        start->set(std::get<double>(sub[0]->store));
-                        end->set(std::get<double>(sub[1]->store));
-                        break;
-                    }
-                    case 3: {
-                        start->set(std::get<double>(sub[0]->store));
-                        end->set(std::get<double>(sub[1]->store));
-                        every->set(std::get<double>(sub[2]->store));
-                        break;
-                    }
-                    default: {
-                        err("range must have 1-3 arguments", range.val.line);
-                        break;
-                    }
+            // a loop variable the body assigns another type to ends
+            // the loop, as `<` of other types is false
+            while (it->type == o_num && std::get<double>(it->store) < end) {
+                block((*tree)[u + 1].end);
+                jit::hot(parent);
+                if (has_continue)
+                    has_continue = false;
+                if (has_break) {
+                    has_break = false;
+                    break;
                 }
-
-                for (it->equal(start); std::get<bool>((it->less_than(end))->store); it->add_equal(every)) {
-                    run(&(u->children[1]));
-                    if (has_continue)
-                        has_continue = false;
-                    if (has_break) {
-                        has_break = false;
-                        break;
-                    }
+                if (it->type == o_num)
+                    std::get<double>(it->store) += every;
+                else {
+                    object *step = new object(o_num);
+                    step->set(every);
+                    it->add_equal(step);
                 }
-
-                // remove the for loop variable from memory
-                memory::remove(of->children[0].val.val);
-            } else
-                err("unsupported control structure", u->val.line);
-        } else if (u->val.type == t_builtin) {
-            if (u->val.ops != u->children.size()) {
-                std::cout << u->children.size() << std::endl;
-                err("incorrect number of children for operation \"" + u->val.val + "\"", u->val.line);
             }
 
-            // dot operator: perform function on right to the operand
-            // on the left hand side
-            if (u->val.val == ".") {
-                object *target = run(&(u->children[0]));
-                std::string method = u->children[1].val.val;
-                if (method == "push") {
-                    if (u->children[1].children.size() != 1)
-                        err("push requires 1 argument", u->children[1].val.line);
-                    object *arg = run(&(u->children[1].children[0]));
-                    return target->push(arg);
-                } else if (method == "pop")
-                    return target->pop();
-                else if (method == "len")
-                    return target->len();
-                else if (method == "empty")
-                    return target->empty();
-                else if (method == "find") {
-                    if (u->children[1].children.size() != 1)
-                        err("find requires 1 argument", u->children[1].val.line);
-                    object *arg = run(&(u->children[1].children[0]));
-                    return target->find(arg);
-                } else if (method == "reverse")
-                    return target->reverse();
-                else if (method == "fill") {
-                    if (u->children[1].children.size() != 3)
-                        err("fill requires 3 arguments", u->children[1].val.line);
-                    object *arg1 = run(&(u->children[1].children[0]));
-                    object *arg2 = run(&(u->children[1].children[1]));
-                    object *arg3 = run(&(u->children[1].children[2]));
-                    return target->fill(arg1, arg2, arg3);
-                } else if (method == "at") {
-                    if (u->children[1].children.size() != 1)
-                        err("at requires 1 argument", u->children[1].val.line);
-                    object *arg = run(&(u->children[1].children[0]));
-                    return target->at(arg);
-                } else if (method == "next")
-                    return target->next();
-                else if (method == "last")
-                    return target->last();
-                else if (method == "sub") {
-                    switch (u->children[1].children.size()) {
-                        case 0: {
-                            return target->sub();
-                        }
-                        case 1: {
-                            object *arg = run(&(u->children[1].children[0]));
-                            return target->sub(arg);
-                        }
-                        case 2: {
-                            object *arg1 = run(&(u->children[1].children[0]));
-                            object *arg2 = run(&(u->children[1].children[1]));
-                            return target->sub(arg1, arg2);
-                        }
-                        case 3: {
-                            object *arg1 = run(&(u->children[1].children[0]));
-                            object *arg2 = run(&(u->children[1].children[1]));
-                            object *arg3 = run(&(u->children[1].children[2]));
-                            return target->sub(arg1, arg2, arg3);
-                        }
-                        default: {
-                            err("sub requires 0 to 3 arguments");
-                            return new object();
-                        }
-                    }
-                } else if (method == "clear")
-                    return target->clear();
-                else if (method == "sort")
-                    return target->sort();
-                else
-                    err("unknown method \"" + method + "\"", u->val.line);
-            } else if (u->val.val == "in") {
-                // take in input and valid assignment
-                object *var = run(&(u->children[0]));
-                std::string in;
-                std::getline(std::cin, in);
-                switch (var->type) {
-                    case o_num: {
-                        std::size_t offset = 0;
-                        double self = std::stod(in, &offset);
-                        if (offset != in.size())
-                            err("invalid number in input", u->val.line);
-                        var->set(self);
-                        break;
-                    }
-                    case o_str: {
-                        var->set(in);
-                        break;
-                    }
-                    default: {
-                        err("unsupported input type", u->val.line);
-                        break;
-                    }
+            // remove the for loop variable from memory
+            memory::local((*tree)[var].slot) = nullptr;
+            memory::recycle(it);
+            break;
+        }
+        case n_control: {
+            err("unsupported control structure", tree->line(u));
+            break;
+        }
+        case n_arity: {
+            std::cout << n.count << std::endl;
+            err("incorrect number of children for operation \"" + symbol::str(n.val) + "\"", tree->line(u));
+            break;
+        }
+        // dot operator: perform the method on the right on the operand
+        // on the left hand side
+        case n_push: {
+            object *target = run(u + 1);
+            std::uint32_t call = (*tree)[u + 1].end;
+            if ((*tree)[call].count != 1)
+                err("push requires 1 argument", tree->line(call));
+            gc::hold(value::of(target));
+            object *arg = run(tree->child(call, 0));
+            gc::drop();
+            return target->push(arg);
+        }
+        case n_pop:
+            return run(u + 1)->pop();
+        case n_len: {
+            object *target = run(u + 1);
+            quicken(u, target->type == o_arr || target->type == o_str,
+                    target->type == o_arr ? n_quick_len_arr : n_quick_len_str);
+            return target->len();
+        }
+        case n_quick_len_arr:
+        case n_quick_len_str:
+            return compute(u).box();
+        case n_empty:
+            return run(u + 1)->empty();
+        case n_find: {
+            object *target = run(u + 1);
+            std::uint32_t call = (*tree)[u + 1].end;
+            if ((*tree)[call].count != 1)
+                err("find requires 1 argument", tree->line(call));
+            gc::hold(value::of(target));
+            object *arg = run(tree->child(call, 0));
+            gc::drop();
+            return target->find(arg);
+        }
+        case n_reverse:
+            return run(u + 1)->reverse();
+        case n_fill: {
+            object *target = run(u + 1);
+            std::uint32_t call = (*tree)[u + 1].end;
+            if ((*tree)[call].count != 3)
+                err("fill requires 3 arguments", tree->line(call));
+            gc::hold(value::of(target));
+            object *arg1 = run(tree->child(call, 0));
+            gc::hold(value::of(arg1));
+            object *arg2 = run(tree->child(call, 1));
+            gc::hold(value::of(arg2));
+            object *arg3 = run(tree->child(call, 2));
+            gc::drop(3);
+            return target->fill(arg1, arg2, arg3);
+        }
+        case n_at: {
+            object *target = run(u + 1);
+            std::uint32_t call = (*tree)[u + 1].end;
+            if ((*tree)[call].count != 1)
+                err("at requires 1 argument", tree->line(call));
+            gc::hold(value::of(target));
+            value arg = eval(tree->child(call, 0));
+            gc::drop();
+            quicken(u, target->type == o_arr && arg.type() == o_num, n_quick_at);
+            return target->at(arg.box());
+        }
+        case n_quick_at: {
+            object *target = run(u + 1);
+            std::uint32_t call = (*tree)[u + 1].end;
+            if ((*tree)[call].count != 1)
+                err("at requires 1 argument", tree->line(call));
+            gc::hold(value::of(target));
+            value arg = eval(tree->child(call, 0));
+            gc::drop();
+            if (target->type != o_arr || arg.type() != o_num) {
+                deoptimize(u, n_at);
+                return target->at(arg.box());
+            }
+            // an index out of bounds or not an integer fails as usual
+            const std::vector<object *> &items = target->as_arr();
+            double i = arg.number();
+            if (!(i >= 0 && i < (double) items.size() && i == (int) i))
+                return target->at(arg.box());
+            return items[(std::size_t) i];
+        }
+        case n_next:
+            return run(u + 1)->next();
+        case n_last:
+            return run(u + 1)->last();
+        case n_sub: {
+            object *target = run(u + 1);
+            std::uint32_t call = (*tree)[u + 1].end;
+            switch ((*tree)[call].count) {
+                case 0: {
+                    return target->sub();
+                }
+                case 1: {
+                    gc::hold(value::of(target));
+                    object *arg = run(tree->child(call, 0));
+                    gc::drop();
+                    return target->sub(arg);
+                }
+                case 2: {
+                    gc::hold(value::of(target));
+                    object *arg1 = run(tree->child(call, 0));
+                    gc::hold(value::of(arg1));
+                    object *arg2 = run(tree->child(call, 1));
+                    gc::drop(2);
+                    return target->sub(arg1, arg2);
+                }
+                case 3: {
+                    gc::hold(value::of(target));
+                    object *arg1 = run(tree->child(call, 0));
+                    gc::hold(value::of(arg1));
+                    object *arg2 = run(tree->child(call, 1));
+                    gc::hold(value::of(arg2));
+                    object *arg3 = run(tree->child(call, 2));
+                    gc::drop(3);
+                    return target->sub(arg1, arg2, arg3);
+                }
+                default: {
+                    err("sub requires 0 to 3 arguments");
+                    return nullptr;
                 }
-                return new object();
-                // raise loop flags
-            } else if (u->val.val == "continue") {
-                has_continue = true;
-                return new object();
-            } else if (u->val.val == "break") {
-                has_break = true;
-                return new object();
             }
+        }
+        case n_clear:
+            return run(u + 1)->clear();
+        case n_sort:
+            return run(u + 1)->sort();
+        case n_method: {
+            run(u + 1);
+            err("unknown method \"" + symbol::str((*tree)[(*tree)[u + 1].end].val) + "\"", tree->line(u));
+            break;
+        }
+        case n_in: {
+            // take in input and valid assignment
+            runtime::read(run(u + 1), tree->line(u));
+            break;
+        }
+        // raise loop flags
+        case n_continue: {
+            has_continue = true;
+            break;
+        }
+        case n_break: {
+            has_break = true;
+            break;
+        }
+        case n_out:
+        case n_outl:
+        case n_binary:
+        case n_quick_binary:
+        case n_num_binary:
+        case n_not:
+        case n_return:
+        case n_tail_call:
+            return compute(u).box();
+        case n_operator: {
+            for (std::uint32_t v = u + 1; v < n.end; v = (*tree)[v].end)
+                run(v);
+            err("operator \"" + symbol::str(n.val) + "\" not implemented", tree->line(u));
+            break;
+        }
+        // builtin functions, unless a variable or function of the same
+        // name is defined
+        case n_floor: {
+            if (memory::find(n.slot))
+                return call(u).box();
+            if (n.count != 1)
+                err("floor requires 1 argument", tree->line(u));
+            return run(u + 1)->floor();
+        }
+        case n_ceil: {
+            if (memory::find(n.slot))
+                return call(u).box();
+            if (n.count != 1)
+                err("ceil requires 1 argument", tree->line(u));
+            return run(u + 1)->ceil();
+        }
+        case n_round: {
+            if (memory::find(n.slot))
+                return call(u).box();
+            if (n.count != 2)
+                err("round requires 2 arguments", tree->line(u));
+            object *val = run(u + 1);
+            gc::hold(value::of(val));
+            object *places = run(tree->child(u, 1));
+            gc::drop();
+            return val->round(places);
+        }
+        case n_rand: {
+            if (memory::find(n.slot))
+                return call(u).box();
+            if (n.count != 0)
+                err("rand takes no arguments", tree->line(u));
+            return object::rand();
+        }
+        case n_symbol: {
+            // symbols are variables or functions; the other builtin
+            // method names evaluate to none
+            if (memory::find(n.slot))
+                return call(u).box();
+            if (!token::is_method(n.val))
+                err("symbol \"" + symbol::str(n.val) + "\" is undefined", tree->line(u));
+            break;
+        }
+        case n_num:
+            return compute(u).box();
+        case n_str: {
+            // return base leaf str
+            object *tmp = new object(o_str);
+            tmp->set(symbol::str(n.val));
+            return tmp;
+        }
+        case n_none:
+            break;
+    }
 
-            for (ast_node &v : u->children)
-                sub.push_back(run(&v));
-            // perform operation
-            if (u->val.val == "out")
-                std::cout << sub[0]->str();
-            else if (u->val.val == "outl")
-                std::cout << sub[0]->str() << std::endl;
-            else if (u->val.val == "=")
-                return sub[0]->equal(sub[1]);
-            else if (u->val.val == "+")
-                return sub[0]->add(sub[1]);
-            else if (u->val.val == "-")
-                return sub[0]->subtract(sub[1]);
-            else if (u->val.val == "*")
-                return sub[0]->multiply(sub[1]);
-            else if (u->val.val == "**")
-                return sub[0]->power(sub[1]);
-            else if (u->val.val == "/")
-                return sub[0]->divide(sub[1]);
-            else if (u->val.val == "//")
-                return sub[0]->truncate_divide(sub[1]);
-            else if (u->val.val == "%")
-                return sub[0]->modulo(sub[1]);
-            else if (u->val.val == "^")
-                return sub[0]->b_xor(sub[1]);
-            else if (u->val.val == "|")
-                return sub[0]->b_or(sub[1]);
-            else if (u->val.val == "&")
-                return sub[0]->b_and(sub[1]);
-            else if (u->val.val == ">>")
-                return sub[0]->b_right_shift(sub[1]);
-            else if (u->val.val == "<<")
-                return sub[0]->b_left_shift(sub[1]);
-            else if (u->val.val == ">")
-                return sub[0]->greater_than(sub[1]);
-            else if (u->val.val == "<")
-                return sub[0]->less_than(sub[1]);
-            else if (u->val.val == "==")
-                return sub[0]->equals(sub[1]);
-            else if (u->val.val == "!=")
-                return sub[0]->not_equals(sub[1]);
-            else if (u->val.val == ">=")
-                return sub[0]->greater_than_equal_to(sub[1]);
-            else if (u->val.val == "<=")
-                return sub[0]->less_than_equal_to(sub[1]);
-            else if (u->val.val == "+=")
-                return sub[0]->add_equal(sub[1]);
-            else if (u->val.val == "-=")
-                return sub[0]->subtract_equal(sub[1]);
-            else if (u->val.val == "*=")
-                return sub[0]->multiply_equal(sub[1]);
-            else if (u->val.val == "**=")
-                return sub[0]->power_equal(sub[1]);
-            else if (u->val.val == "/=")
-                return sub[0]->divide_equal(sub[1]);
-            else if (u->val.val == "//=")
-                return sub[0]->truncate_divide_equal(sub[1]);
-            else if (u->val.val == "%=")
-                return sub[0]->modulo_equal(sub[1]);
-            else if (u->val.val == "^=")
-                return sub[0]->b_xor_equal(sub[1]);
-            else if (u->val.val == "|=")
-                return sub[0]->b_or_equal(sub[1]);
-            else if (u->val.val == "&=")
-                return sub[0]->b_and_equal(sub[1]);
-            else if (u->val.val == ">>=")
-                return sub[0]->b_right_shift_equal(sub[1]);
-            else if (u->val.val == "<<=")
-                return sub[0]->b_right_shift_equal(sub[1]);
-            else if (u->val.val == "and")
-                return sub[0]->_and(sub[1]);
-            else if (u->val.val == "or")
-                return sub[0]->_or(sub[1]);
-            else if (u->val.val == "not")
-                return sub[0]->_not();
-                // add return value and raise the flag
-            else if (u->val.val == "return") {
-                return_val = new object(sub[0]->type);
-                return_val->equal(sub[0]);
-                has_return = true;
-                return sub[0];
-            } else
-                err("operator \"" + u->val.val + "\" not implemented", u->val.line);
-        } else if (u->val.type == t_symbol) {
-            // symbols are variables or functions
-            if (memory::has(u->val.val)) {
-                // handle user-defined variables/functions
-                object *obj = memory::get(u->val.val);
-                if (obj->type != o_fn)
-                    return obj;
-                if (obj->f_params.size() != u->children.size())
-                    err("incorrect number of children for function \"" + u->val.val + "\"", u->val.type);
-
-                for (ast_node &v : u->children)
-                    sub.push_back(run(&v));
+    return nullptr;
+}
 
-                memory::push();
-                for (int i = 0; i < obj->f_params.size(); ++i) {
-                    object *param = new object();
-                    param->equal(sub[i]);
-                    if (param->type != obj->f_params[i].type)
-                        err("parameter types don't match", u->children[i].val.line);
-                    memory::add(obj->f_params[i].symbol, param);
-                }
-                executor *call = new executor(obj->f_body, obj);
-                object *ret = call->init();
-                memory::pop();
+/// evaluates a node to a value; the nodes that give a num, a bool or a
+/// none are computed without objects, and the rest are run
+/// \param u: index of the node
+/// \return the value of the node
+value executor::eval(std::uint32_t u) {
+    if (has_return || has_continue || has_break)
+        return value();
+    switch ((*tree)[u].op) {
+        case n_if:
+        case n_quick_len_arr:
+        case n_quick_len_str:
+        case n_out:
+        case n_outl:
+        case n_binary:
+        case n_quick_binary:
+        case n_num_binary:
+        case n_not:
+        case n_return:
+        case n_tail_call:
+        case n_num:
+            visit();
+            return compute(u);
+        // a block, and a call that gives a num or a bool, is evaluated
+        // without an object for its value
+        case n_group:
+            visit();
+            group(u);
+            return value();
+        case n_symbol:
+            if (memory::find((*tree)[u].slot)) {
+                visit();
+                return call(u);
+            }
+            break;
+        default:
+            break;
+    }
+    object *obj = exec(u);
+    return obj ? value::of(obj) : value();
+}
 
-                return ret;
-            } else if (token::methods.find(u->val.val) != token::methods.end()) {
-                // handle builtin functions
-                if (u->val.val == "floor") {
-                    if (u->children.size() != 1)
-                        err("floor requires 1 argument", u->val.line);
-                    return run(&(u->children[0]))->floor();
-                } else if (u->val.val == "ceil") {
-                    if (u->children.size() != 1)
-                        err("ceil requires 1 argument", u->val.line);
-                    return run(&(u->children[0]))->ceil();
-                } else if (u->val.val == "round") {
-                    if (u->children.size() != 2)
-                        err("round requires 2 arguments", u->val.line);
-                    return run(&(u->children[0]))->round(run(&(u->children[1])));
-                } else if (u->val.val == "rand") {
-                    if (u->children.size() != 0)
-                        err("rand takes no arguments", u->val.line);
-                    return object::rand();
+/// computes the nodes that eval gives values for, once they are counted
+/// \param u: index of the node
+/// \return the value of the node
+value executor::compute(std::uint32_t u) {
+    const ast::node &n = (*tree)[u];
+    switch (n.op) {
+        // if control structure: test condition, then execute its body
+        // accordingly; an elsif or else reads whether it was taken
+        case n_if: {
+            if (!runtime::truth(eval(u + 1)))
+                return value::boolean(false);
+            block(tree->child(u, 1));
+            return value::boolean(true);
+        }
+        case n_quick_len_arr: {
+            object *target = run(u + 1);
+            if (target->type != o_arr) {
+                deoptimize(u, n_len);
+                return value::of(target->len());
+            }
+            return value::num((double) target->as_arr().size());
+        }
+        case n_quick_len_str: {
+            object *target = run(u + 1);
+            if (target->type != o_str) {
+                deoptimize(u, n_len);
+                return value::of(target->len());
+            }
+            return value::num((double) std::get<std::string>(target->store).size());
+        }
+        case n_out: {
+            std::cout << eval(u + 1).str();
+            return value();
+        }
+        case n_outl: {
+            std::cout << eval(u + 1).str() << std::endl;
+            return value();
+        }
+        case n_binary: {
+            value left = eval(u + 1);
+            gc::hold(left);
+            value right = eval((*tree)[u + 1].end);
+            gc::drop();
+            if (runtime::num_operator(n.val))
+                quicken(u, left.type() == o_num && right.type() == o_num, n_quick_binary);
+            return runtime::apply(n.val, left, right);
+        }
+        case n_quick_binary: {
+            value left = eval(u + 1);
+            gc::hold(left);
+            value right = eval((*tree)[u + 1].end);
+            gc::drop();
+            if (left.type() != o_num || right.type() != o_num)
+                deoptimize(u, n_binary);
+            return runtime::apply(n.val, left, right);
+        }
+        case n_num_binary: {
+            value left = eval(u + 1);
+            gc::hold(left);
+            value right = eval((*tree)[u + 1].end);
+            gc::drop();
+            return runtime::apply(n.val, left, right);
+        }
+        case n_not:
+            return value::boolean(!runtime::truth(eval(u + 1)));
+        // add return value and raise the flag
+        case n_return:
+        case n_tail_call: {
+            value val;
+            if (n.op == n_tail_call) {
+                val = tail(u + 1);
+                if (next) {
+                    has_return = true;
+                    return value();
                 }
             } else
-                err("symbol \"" + u->val.val + "\" is undefined", u->val.line);
-        } else if (u->val.type == t_num) {
+                val = eval(u + 1);
+            return_val = val.own();
+            has_return = true;
+            return val;
+        }
+        default: {
             // return base leaf num
-            object *tmp = new object(o_num);
             std::size_t offset = 0;
-            double self = std::stod(u->val.val, &offset);
-            if (offset != u->val.val.size())
-                err("invalid number", u->val.line);
-            tmp->set(self);
-            return tmp;
-        } else if (u->val.type == t_str) {
-            // return base leaf str
-            object *tmp = new object(o_str);
-            tmp->set(u->val.val);
-            return tmp;
+            const std::string &val = symbol::str(n.val);
+            double self = std::stod(val, &offset);
+            if (offset != val.size())
+                err("invalid number", tree->line(u));
+            return value::num(self);
+        }
+    }
+}
+
+/// runs the statements of a block; an elsif or else reads whether the
+/// if chain before it was taken
+/// \param u: index of the group node
+void executor::group(std::uint32_t u) {
+    std::uint32_t prev = u;
+    value last;
+    for (std::uint32_t i = 0, v = u + 1; i < (*tree)[u].count; ++i, prev = v, v = (*tree)[v].end) {
+        if (!(has_return || has_continue || has_break)) {
+            // nothing is held between two statements, which makes it a
+            // safe point to collect at
+            gc::poll();
+            // if we are at an elsif or else block, we must validate by
+            // checking if the previous block was an if block; otherwise,
+            // this is invalid grammar and we can throw an error
+            if ((*tree)[v].val == s_elsif) {
+                if (i == 0 || ((*tree)[prev].val != s_if && (*tree)[prev].val != s_elsif))
+                    err("elsif must follow if or elsif", tree->line(v));
+                if (last.boolean())
+                    continue;
+            } else if ((*tree)[v].val == s_else) {
+                if (i == 0 || ((*tree)[prev].val != s_if && (*tree)[prev].val != s_elsif))
+                    err("else must follow if or elsif", tree->line(v));
+                if (last.boolean())
+                    continue;
+            }
+            last = eval(v);
         }
     }
+}
 
-    return new object();
+/// runs the body of a loop as run does, without creating the none that
+/// a block evaluates to, which the loop never reads
+/// \param u: index of the body
+void executor::block(std::uint32_t u) {
+    if ((*tree)[u].op != n_group) {
+        eval(u);
+        return;
+    }
+    if (has_return || has_continue || has_break)
+        return;
+    visit();
+    group(u);
+}
+
+/// looks up a variable, or calls a user-defined function
+/// \param u: index of the symbol node
+/// \return the variable or the return value of the function
+value executor::call(std::uint32_t u) {
+    const ast::node &n = (*tree)[u];
+    object *obj = memory::find(n.slot);
+    if (obj->type != o_fn)
+        return value::of(obj);
+    if (obj->def->params.size() != n.count)
+        err("incorrect number of children for function \"" + symbol::str(n.val) + "\"", n.type);
+
+    std::size_t base = args.size();
+    for (std::uint32_t v = u + 1; v < n.end; v = (*tree)[v].end)
+        args.push_back(eval(v));
+    value ret = invoke(u, obj, base);
+    args.resize(base);
+    return ret;
+}
+
+/// calls a function with its evaluated args
+/// \param u: the node index of the call
+/// \param obj: the function
+/// \param base: the first arg on the arg stack
+/// \return the value of the call
+value executor::invoke(std::uint32_t u, object *obj, std::size_t base) {
+    std::string key;
+    if (obj->def->table)
+        if (object *ret = obj->def->table->find(args.data() + base, obj->def->params.size(), key))
+            return value::of(ret);
+    runtime::check_stack(tree->line(u));
+    // the parameters take the first slots of the frame
+    std::size_t frame = memory::push(obj->body()->frame, obj->def->params.size());
+    for (int i = 0; i < obj->def->params.size(); ++i) {
+        object *param = memory::acquire();
+        args[base + i].assign(param);
+        if (param->type != obj->def->params[i].type)
+            err("parameter types don't match", tree->line(tree->child(u, i)));
+        memory::local(i) = param;
+    }
+    value ret;
+    if (jit::hot(obj))
+        ret = value::of(jit::run(obj));
+    else
+        ret = executor(obj->body(), obj).init();
+    memory::pop(frame, parent->def->params.size(), ret.is_obj() ? ret.obj() : nullptr);
+    // a memo table keeps its values as objects
+    if (obj->def->table)
+        obj->def->table->store(std::move(key), ret.box());
+
+    return ret;
+}
+
+/// runs `return f(...)`: the args are evaluated and copied into the
+/// parameters, which stay on the arg stack, and the call is left to
+/// init to run in place of the function. The function then returns
+/// what the callee returns, which needs the callee to return the same
+/// type; any other call runs as it would anywhere else
+/// \param u: the node index of the call
+/// \return the value of the call, or none if it is left to init, which
+///         sets next
+value executor::tail(std::uint32_t u) {
+    const ast::node &n = (*tree)[u];
+    object *obj = memory::find(n.slot);
+    if (!obj || obj->type != o_fn || obj->def->params.size() != n.count || obj->def->returns != parent->def->returns ||
+        parent->def->returns == o_none)
+        return eval(u);
+
+    std::size_t base = args.size();
+    for (std::uint32_t v = u + 1; v < n.end; v = (*tree)[v].end)
+        args.push_back(eval(v));
+    // a flag raised by an arg is overridden by the return, as it is for
+    // a call
+    if (has_return || has_continue || has_break) {
+        value ret = invoke(u, obj, base);
+        args.resize(base);
+        return ret;
+    }
+    for (int i = 0; i < obj->def->params.size(); ++i) {
+        object *param = memory::acquire();
+        args[base + i].assign(param);
+        if (param->type != obj->def->params[i].type)
+            err("parameter types don't match", tree->line(tree->child(u, i)));
+        args[base + i] = value::of(param);
+    }
+    next = obj;
+    params = base;
+    return value();
 }
@@ -6,30 +6,91 @@
 #ifndef QI_INTERPRETER_EXECUTOR_H
 #define QI_INTERPRETER_EXECUTOR_H
 
+#include <cstdint>
 #include <vector>
 
-#include "ast_node.h"
+#include "ast.h"
+#include "bytecode.h"
+#include "gc.h"
+#include "runtime.h"
 #include "interpreter.h"
+#include "jit.h"
+#include "memo.h"
 #include "memory.h"
 #include "object.h"
 #include "token.h"
 #include "util.h"
+#include "value.h"
 
 /// executor class that visits the Abstract Syntax Tree supplied as a
-/// function body
+/// function body. Statements, conditions, operators, literals and args
+/// are evaluated to values, so that the nums and bools in between never
+/// become objects; run gives an object for the nodes that need one. A
+/// call gives its value as a value too, so that neither the body nor
+/// the return of a function creates an object for a num or a bool
 class executor {
 private:
-    ast_node *tree;
+    friend class gc;
+
+    ast *tree;
     object *parent;
     bool has_return, has_continue, has_break;
-    object *return_val;
+    value return_val;
+    // a call in tail position that runs in place of the function once
+    // the body is left, and where its parameters are on the arg stack
+    object *next;
+    std::size_t params;
+
+    // the args of the calls of every executor, on one stack that stops
+    // allocating once it has grown
+    static std::vector<value> args;
+
+    value compute(std::uint32_t u);
+
+    void group(std::uint32_t u);
+
+    void block(std::uint32_t u);
+
+    value call(std::uint32_t u);
+
+    value invoke(std::uint32_t u, object *obj, std::size_t base);
+
+    value tail(std::uint32_t u);
+
+    object *exec(std::uint32_t u);
+
+    bool quicken(std::uint32_t u, bool fits, n_op quick);
+
+    void deoptimize(std::uint32_t u, n_op generic);
+
+    /// counts a node visited, in builds that count them
+    static void visit() {
+#ifdef QI_COUNT_VISITS
+        ++visits;
+#endif
+    }
 
 public:
-    executor(ast_node *_tree, object *_parent);
+    /// the runs in a row with the same operand types after which a node
+    /// is quickened
+    static constexpr std::uint8_t quicken_after = 8;
+
+#ifdef QI_COUNT_VISITS
+    // the nodes visited, only counted in the benchmarks
+    static std::uint64_t visits;
+#endif
+    static std::uint64_t specialized;
+    static std::uint64_t deoptimized;
+
+    executor(ast *_tree, object *_parent);
+
+    value init();
+
+    static value leave(object *fn, leave_flag flag, value ret);
 
-    object *init();
+    object *run(std::uint32_t u);
 
-    object *run(ast_node *u);
+    value eval(std::uint32_t u);
 };
 
 #endif //QI_INTERPRETER_EXECUTOR_H
@@ -1,65 +1,99 @@
 /*
  * fstream.cpp contains:
- *   - Definitions for the file stream node
+ *   - Definitions for the source buffer
  *   - Definitions for the file stream
  */
 
 #include "fstream.h"
 
-fstream_node::fstream_node() {
-    val = 0;
-    next = nullptr;
+/// loads a source file into memory; regular files are mapped with a
+/// single mmap, while pipes and other unmappable files fall back to
+/// one bulk read
+/// \param file_name: the path to the source file
+source_buffer::source_buffer(const std::string &file_name) {
+    mapped = nullptr;
+    mapped_size = 0;
+
+    int fd = open(file_name.c_str(), O_RDONLY);
+    if (fd < 0)
+        err("file does not exist");
+
+    struct stat info{};
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+        void *addr = mmap(nullptr, (std::size_t) info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr != MAP_FAILED) {
+            mapped = (char *) addr;
+            mapped_size = (std::size_t) info.st_size;
+            madvise(addr, mapped_size, MADV_SEQUENTIAL);
+        }
+    }
+
+    if (mapped) {
+        data = std::string_view(mapped, mapped_size);
+    } else {
+        char chunk[1 << 16];
+        ssize_t count;
+        while ((count = read(fd, chunk, sizeof(chunk))) > 0)
+            contents.append(chunk, (std::size_t) count);
+        if (count < 0)
+            err("could not read file");
+        data = std::string_view(contents);
+    }
+
+    close(fd);
 }
 
-fstream_node::fstream_node(char _val) {
-    val = _val;
-    next = nullptr;
+/// unmaps the file if it was mapped
+source_buffer::~source_buffer() {
+    if (mapped)
+        munmap(mapped, mapped_size);
 }
 
 fstream::fstream() {
-    file = nullptr;
+    pos = 0;
 }
 
-/// initializes the file stream by reading the input file name,
-/// validating the file and loading it into the linked list format
+/// initializes the file stream by validating the input file name and
+/// loading the file into a source buffer
 /// \param file_name
 fstream::fstream(std::string file_name) {
     if (file_name.size() <= 3 || file_name.substr(file_name.size() - 3) != ".qi")
         err("invalid file name");
 
-    std::ifstream f(file_name);
-    if (!f.good())
-        err("file does not exist");
-
-    file = new fstream_node();
-    char curr;
-    fstream_node *dummy = file;
+    source = std::make_shared<source_buffer>(file_name);
+    file = source->data;
+    pos = 0;
+}
 
-    while (f.good()) {
-        curr = (char) f.get();
-        dummy->next = new fstream_node(curr);
-        dummy = dummy->next;
-    }
+/// maps a cursor position to the framed stream: position 0 is the
+/// empty character before the file, then the file contents, then EOF
+/// \param i: the cursor position
+/// \return the char at that position, or 0 past the end
+char fstream::at(std::size_t i) const {
+    if (i == 0 || i > file.size() + 1)
+        return 0;
+    return i <= file.size() ? file[i - 1] : (char) EOF;
+}
 
-    f.close();
+/// \return the underlying source text
+std::string_view fstream::view() const {
+    return file;
 }
 
 /// \return current char
 char fstream::curr() const {
-    return file ? file->val : 0;
+    return at(pos);
 }
 
 /// \return next char
 char fstream::next() const {
-    return file->next ? file->next->val : 0;
+    return at(pos + 1);
 }
 
-/// moves to the next node in the file stream
+/// moves to the next char in the file stream
 void fstream::move() {
-    if (file->next) {
-        fstream_node *prev = file;
-        file = file->next;
-        delete prev;
-    } else
+    if (pos <= file.size())
+        ++pos;
+    else
         err("interpreter error; no characters in stream");
 }
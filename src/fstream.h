@@ -1,40 +1,65 @@
 /*
  * fstream.h contains:
+ *   - Declarations for the source buffer
  *   - Declarations for the file stream reader
  */
 
 #ifndef QI_INTERPRETER_FSTREAM_H
 #define QI_INTERPRETER_FSTREAM_H
 
+#include <cstdio>
 #include <cstdlib>
-#include <fstream>
+#include <memory>
 #include <string>
+#include <string_view>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include "util.h"
 
-/// the filestream is implemented as a singly-linked list, made up of
-/// nodes with its val and the next node
-class fstream_node {
+/// the source buffer owns the contents of a source file as one flat
+/// block of memory; regular files are memory-mapped, anything that
+/// can't be mapped (e.g. pipes) is read into a string in bulk
+class source_buffer {
+private:
+    char *mapped;
+    std::size_t mapped_size;
+    std::string contents;
+
 public:
-    char val;
-    fstream_node *next;
+    std::string_view data;
+
+    explicit source_buffer(const std::string &file_name);
 
-    fstream_node();
+    source_buffer(const source_buffer &other) = delete;
 
-    explicit fstream_node(char _val);
+    source_buffer &operator=(const source_buffer &other) = delete;
+
+    ~source_buffer();
 };
 
-/// fstream is the filestream with methods to interface with the
-/// linked list made from `fstream_node`
+/// fstream is the filestream: a cursor over the source buffer. The
+/// cursor starts before the first character and the stream ends
+/// with an EOF character, so `curr()` and `next()` behave as if the
+/// file was framed as [0, c_1, ..., c_n, EOF]
 class fstream {
 private:
-    fstream_node *file;
+    std::shared_ptr<source_buffer> source;
+    std::string_view file;
+    std::size_t pos;
+
+    char at(std::size_t i) const;
 
 public:
     fstream();
 
     explicit fstream(std::string file_name);
 
+    std::string_view view() const;
+
     char curr() const;
 
     char next() const;
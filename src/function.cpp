@@ -0,0 +1,34 @@
+/*
+ * function.cpp contains:
+ *   - Definitions for the bodies of function objects, which the
+ *     runtime of compiled programs leaves out
+ */
+
+#include "bytecode.h"
+#include "checker.h"
+#include "object.h"
+
+/// returns the function body, parsing it from its source tokens on
+/// the first call if it was declared without being parsed, then binding
+/// its symbols to their slots and type checking it; every global is
+/// declared by then. A body that fails the check is checked again on
+/// the next call, so that its error is never lost
+/// \return the syntax tree of the function body
+ast *object::body() {
+    if (!def->body)
+        def->body = new ast(ast_node(def->source));
+    if (!def->body->bound) {
+        def->body->bind(this);
+        checker::check(this);
+        def->body->bound = true;
+    }
+    return def->body;
+}
+
+/// returns the compiled function body, compiling it on the first call
+/// \return the bytecode of the function body
+bytecode *object::code() {
+    if (!def->code)
+        def->code = new bytecode(body());
+    return def->code;
+}
@@ -0,0 +1,119 @@
+/*
+ * gc.cpp contains:
+ *   - Definitions for the garbage collector
+ */
+
+#include "gc.h"
+#include "executor.h"
+#include "jit.h"
+#include "memo.h"
+#include "memory.h"
+#include "vm.h"
+
+// static vars
+std::vector<object *> gc::work;
+std::vector<object *> gc::temps;
+std::size_t gc::minimum = 1000000;
+std::uint64_t gc::collections = 0;
+double gc::total_ms = 0;
+double gc::max_ms = 0;
+
+/// \param c: a queue or a stack
+/// \return the container the adaptor keeps its objects in
+template <typename C>
+static const typename C::container_type &items(const C &c) {
+    struct adaptor : C {
+        static const typename C::container_type &of(const C &c) {
+            return c.*&adaptor::c;
+        }
+    };
+    return adaptor::of(c);
+}
+
+/// marks an object, whose objects are marked once it is taken off the
+/// work list
+/// \param obj: the object, or nullptr
+void gc::mark(object *obj) {
+    if (!obj || obj->marked)
+        return;
+    obj->marked = true;
+    work.push_back(obj);
+}
+
+/// marks every object reachable from the roots; the work list is
+/// explicit, so that nesting containers deeply does not recurse
+void gc::trace() {
+    for (object *obj : memory::globals)
+        mark(obj);
+    for (object *obj : memory::frames)
+        mark(obj);
+    for (object *obj : memory::spare)
+        mark(obj);
+    for (value val : executor::args)
+        if (val.is_obj())
+            mark(val.obj());
+    for (object *obj : temps)
+        mark(obj);
+    for (value val : vm::stack)
+        if (val.is_obj())
+            mark(val.obj());
+    for (const auto &frame : jit::frames) {
+        std::uint64_t live = *reinterpret_cast<const std::uint64_t *>(frame.second + frame.first->live);
+        object **cells = reinterpret_cast<object **>(frame.second + frame.first->cells);
+        for (std::uint32_t i = 0; live; ++i, live >>= 1)
+            if (live & 1)
+                mark(cells[i]);
+    }
+    for (const memo *table : memo::tables)
+        for (const auto &entry : table->values)
+            mark(entry.second.first);
+
+    while (!work.empty()) {
+        object *obj = work.back();
+        work.pop_back();
+        // by the alternative of the store, as a container declared
+        // without a value may still hold a num
+        const object_store &store = obj->store;
+        if (std::holds_alternative<boxed<std::vector<object *>>>(store)) {
+            for (object *o : obj->as_arr())
+                mark(o);
+        } else if (std::holds_alternative<boxed<std::queue<object *>>>(store)) {
+            for (object *o : items(obj->as_queue()))
+                mark(o);
+        } else if (std::holds_alternative<boxed<std::stack<object *>>>(store)) {
+            for (object *o : items(obj->as_stack()))
+                mark(o);
+        } else if (std::holds_alternative<boxed<std::unordered_set<object *, obj_hash, obj_equals>>>(store)) {
+            for (object *o : obj->as_set())
+                mark(o);
+        } else if (std::holds_alternative<boxed<std::unordered_map<object *, object *, obj_hash, obj_equals>>>(store)) {
+            for (const auto &entry : obj->as_map()) {
+                mark(entry.first);
+                mark(entry.second);
+            }
+        }
+    }
+}
+
+/// marks what the roots reach and frees the rest; the next collection
+/// is due once as many objects were allocated as are left, or as the
+/// least threshold if that is more
+void gc::collect() {
+    auto start = std::chrono::steady_clock::now();
+    trace();
+    heap::sweep();
+    heap::threshold = std::max(minimum, heap::live);
+    auto stop = std::chrono::steady_clock::now();
+    double ms = std::chrono::duration<double, std::milli>(stop - start).count();
+    ++collections;
+    total_ms += ms;
+    max_ms = std::max(max_ms, ms);
+}
+
+/// prints the collections, their pauses and the size of the heap
+void gc::report() {
+    std::cerr << "gc: " << collections << " collections, " << total_ms << " ms paused, " << max_ms
+              << " ms longest pause" << std::endl;
+    std::cerr << "gc: heap of " << (double) heap::size() / (1 << 20) << " MB, peak " << heap::peak << " objects ("
+              << (double) (heap::peak * sizeof(object)) / (1 << 20) << " MB), " << heap::live << " live" << std::endl;
+}
@@ -0,0 +1,72 @@
+/*
+ * gc.h contains:
+ *   - Declarations for the garbage collector
+ */
+
+#ifndef QI_INTERPRETER_GC_H
+#define QI_INTERPRETER_GC_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "heap.h"
+#include "object.h"
+#include "value.h"
+
+/// the precise mark-and-sweep collector of the object heap. It marks
+/// every object reachable from the roots: the globals, the frames and
+/// the free list of the memory, the arg stack of the tree walker and
+/// the operands it holds while it evaluates the next one, the operand
+/// stack of the VM, the object cells of native frames, and the values
+/// kept by memo tables. Everything else is freed. A collection is due
+/// once as many objects were allocated as the threshold, which grows to
+/// the objects left by the last one; it runs at the next safe point,
+/// between two statements of the tree walker, at the end of a
+/// statement, a jump, a loop pass or a call of the VM, or at the start
+/// or the head of a loop of native code, where nothing else holds an
+/// object
+class gc {
+private:
+    static std::vector<object *> work;
+
+    static void mark(object *obj);
+
+    static void trace();
+
+public:
+    // the objects the tree walker holds while it evaluates the next
+    // operand or arg
+    static std::vector<object *> temps;
+    // the least threshold, from --gc-threshold
+    static std::size_t minimum;
+
+    static std::uint64_t collections;
+    static double total_ms, max_ms;
+
+    static void collect();
+
+    static void report();
+
+    /// collects if a collection is due; only called at a safe point
+    static void poll() {
+        if (heap::due())
+            collect();
+    }
+
+    /// holds an operand of the tree walker until it is dropped
+    /// \param val: the operand
+    static void hold(value val) {
+        temps.push_back(val.is_obj() ? val.obj() : nullptr);
+    }
+
+    /// drops the last operands held
+    /// \param count: the number of operands
+    static void drop(std::size_t count = 1) {
+        temps.resize(temps.size() - count);
+    }
+};
+
+#endif //QI_INTERPRETER_GC_H
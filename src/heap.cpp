@@ -0,0 +1,74 @@
+/*
+ * heap.cpp contains:
+ *   - Definitions for the object heap
+ *   - Allocation of objects from the heap
+ */
+
+#include <cassert>
+
+#include "heap.h"
+
+// static vars
+std::vector<heap::block *> heap::blocks;
+heap::free_slot *heap::free_list = nullptr;
+std::size_t heap::live = 0;
+std::size_t heap::peak = 0;
+std::uint64_t heap::total = 0;
+std::size_t heap::allocated = 0;
+// a program that allocates less never collects
+std::size_t heap::threshold = 1000000;
+
+/// allocates a block and puts its slots on the free list, the first
+/// slot first
+void heap::grow() {
+    void *mem = std::aligned_alloc(block_bytes, block_bytes);
+    if (!mem)
+        throw std::bad_alloc();
+    block *b = static_cast<block *>(mem);
+    blocks.push_back(b);
+    for (std::size_t i = per_block; i-- > 0;) {
+        b->used[i] = 0;
+        free_slot *slot = reinterpret_cast<free_slot *>(b->slots[i]);
+        slot->next = free_list;
+        free_list = slot;
+    }
+}
+
+/// frees every object the collector did not mark, and unmarks the rest
+/// for the next collection
+/// \return the number of objects freed
+std::size_t heap::sweep() {
+    std::size_t freed = 0;
+    for (block *b : blocks)
+        for (std::size_t i = 0; i < per_block; ++i) {
+            if (!b->used[i])
+                continue;
+            object *obj = reinterpret_cast<object *>(b->slots[i]);
+            if (obj->marked) {
+                obj->marked = false;
+                continue;
+            }
+            obj->~object();
+            release(obj);
+            ++freed;
+        }
+    allocated = 0;
+    return freed;
+}
+
+/// allocates an object from a heap slot; objects are never subclassed,
+/// so every allocation is one sizeof(object) slot
+/// \param size: the size of the object
+/// \return the slot
+void *object::operator new(std::size_t size) {
+    assert(size == sizeof(object));
+    (void) size;
+    return heap::allocate();
+}
+
+/// returns an object's slot to the heap
+/// \param p: the slot
+void object::operator delete(void *p) {
+    if (p)
+        heap::release(p);
+}
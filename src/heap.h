@@ -0,0 +1,110 @@
+/*
+ * heap.h contains:
+ *   - Declarations for the object heap
+ */
+
+#ifndef QI_INTERPRETER_HEAP_H
+#define QI_INTERPRETER_HEAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+#include "object.h"
+
+/// the object heap allocates every object in a slot of a large block
+/// and keeps the slots of freed objects on a free list, so that the
+/// collector can walk every object there is and free those it did not
+/// reach. It counts the objects allocated since the last collection,
+/// which is what a collection is due on. Blocks are never given back;
+/// the slots of freed objects are reused instead
+class heap {
+private:
+    static constexpr std::size_t block_bytes = std::size_t(1) << 18;
+    static constexpr std::size_t per_block = (block_bytes - 64) / (sizeof(object) + 1);
+
+    /// a block of slots, with a byte for whether each slot holds an
+    /// object
+    struct block {
+        std::uint8_t used[per_block];
+        alignas(object) unsigned char slots[per_block][sizeof(object)];
+    };
+
+    static_assert(sizeof(block) <= block_bytes, "a block does not fit its allocation");
+
+    /// a freed slot holds the next free slot
+    struct free_slot {
+        free_slot *next;
+    };
+
+    static std::vector<block *> blocks;
+    static free_slot *free_list;
+
+    static void grow();
+
+    /// \param p: an object slot
+    /// \return the block of the slot, which blocks are aligned to
+    static block *block_of(const void *p) {
+        return reinterpret_cast<block *>(reinterpret_cast<std::uintptr_t>(p) & ~(block_bytes - 1));
+    }
+
+    /// \param b: a block
+    /// \param p: an object slot of the block
+    /// \return the index of the slot in the block
+    static std::size_t index_of(const block *b, const void *p) {
+        return (std::size_t) (static_cast<const unsigned char *>(p) - b->slots[0]) / sizeof(object);
+    }
+
+public:
+    // the objects allocated and not freed, and the most there were
+    static std::size_t live;
+    static std::size_t peak;
+    // the objects allocated in all
+    static std::uint64_t total;
+    // the objects allocated since the last collection, and how many of
+    // them make a collection due
+    static std::size_t allocated;
+    static std::size_t threshold;
+
+    /// \return a slot for an object
+    static void *allocate() {
+        if (!free_list)
+            grow();
+        free_slot *slot = free_list;
+        free_list = slot->next;
+        block_of(slot)->used[index_of(block_of(slot), slot)] = 1;
+        if (++live > peak)
+            peak = live;
+        ++allocated;
+        ++total;
+        return slot;
+    }
+
+    /// puts the slot of a destroyed object on the free list
+    /// \param p: the slot
+    static void release(void *p) {
+        block *b = block_of(p);
+        b->used[index_of(b, p)] = 0;
+        free_slot *slot = static_cast<free_slot *>(p);
+        slot->next = free_list;
+        free_list = slot;
+        --live;
+    }
+
+    /// \return whether enough objects were allocated since the last
+    ///         collection for the next one
+    static bool due() {
+        return allocated >= threshold;
+    }
+
+    /// \return the bytes of every block
+    static std::size_t size() {
+        return blocks.size() * block_bytes;
+    }
+
+    static std::size_t sweep();
+};
+
+#endif //QI_INTERPRETER_HEAP_H
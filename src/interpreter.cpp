@@ -4,13 +4,22 @@
  */
 
 #include "interpreter.h"
+#include "vm.h"
+
+/// initializes an interpreter without a program, for a program that is
+/// declared from a cache
+interpreter::interpreter() = default;
 
 /// initializes the interpreter and adds global variables and all
 /// function declaration to global memory
 /// \param _tokens: token sequence from the lexer
-interpreter::interpreter(std::vector <token> &_tokens) {
-    tokens = _tokens;
+interpreter::interpreter(std::vector <token> _tokens) : buffer(std::move(_tokens)) {
+    tokens = buffer.span();
     std::vector <std::pair<int, int >> blocks = ast_node::gen_blocks(tokens, false);
+    std::vector <fn_body> bodies = find_bodies(tokens, blocks);
+    // lazily declared functions are parsed on their first call
+    if (!options::lazy)
+        parse_bodies(bodies);
     // flags to enforce the definition of the file in the following order:
     // 1) global variables
     // 2) function declarations
@@ -21,12 +30,17 @@ interpreter::interpreter(std::vector <token> &_tokens) {
     // go through blocks -> each block MUST be either a function or a line
     // lines: must be variable declarations
     // functions: must be non-main until the last one
-    for (int i = 0; i < blocks.size(); ++i) {
-        if (!fn_declared && token::vars.find(tokens[blocks[i].first].val) != token::vars.end())
-            interpreter::declare_obj(ast_node::subarray(tokens, blocks[i].first, blocks[i].second), true);
-        else if (!main_declared && tokens[blocks[i].first].val == "fn") {
+    // the bodies were parsed ahead, in parallel; functions are still
+    // validated and registered in source order, so the first error by
+    // source line is the one reported
+    for (int i = 0, fn = 0; i < blocks.size(); ++i) {
+        if (!fn_declared && token::is_var(tokens[blocks[i].first].val)) {
+            token_span decl = tokens.sub(blocks[i].first, blocks[i].second);
+            memory::add(decl.back().val, interpreter::declare_obj(decl));
+            globals.push_back(blocks[i].first);
+        } else if (!main_declared && tokens[blocks[i].first].val == s_fn) {
             fn_declared = true;
-            main_declared = declare_fn(blocks[i].first, blocks[i].second);
+            main_declared = declare_fn(blocks[i].first, blocks[i].second, bodies[fn++]);
         } else
             err("invalid sequence", tokens[blocks[i].first].line);
     }
@@ -35,107 +49,143 @@ interpreter::interpreter(std::vector <token> &_tokens) {
         err("main function not declared");
 }
 
-/// creates a new object and adds it onto the stack or to the global
-/// memory based on defined scoping
+/// finds the body of every function declaration: the tokens between
+/// the first `start` of the declaration and its final `end`
+/// \param tokens: the program tokens
+/// \param blocks: the top-level blocks of the program
+/// \return the bodies in source order
+std::vector <fn_body> interpreter::find_bodies(token_span tokens, const std::vector <std::pair<int, int>> &blocks) {
+    std::vector <fn_body> bodies;
+    for (const std::pair<int, int> &block : blocks) {
+        if (tokens[block.first].val != s_fn)
+            continue;
+        int start = block.first;
+        while (start < block.second && tokens[start].val != s_start)
+            ++start;
+        // a declaration without a body fails its own validation first
+        bodies.push_back({start + 2, block.second - 1, nullptr, start == block.second, {}});
+    }
+    return bodies;
+}
+
+/// parses the function bodies on a pool of options::jobs threads;
+/// each thread takes the next unparsed body until none are left, and
+/// an error is kept with its body instead of ending the program
+/// \param bodies: the bodies to parse
+void interpreter::parse_bodies(std::vector <fn_body> &bodies) {
+    std::atomic <std::size_t> next(0);
+    auto work = [&]() {
+        error_scope scope;
+        for (std::size_t i; (i = next++) < bodies.size();) {
+            if (bodies[i].failed)
+                continue;
+            try {
+                bodies[i].tree = new ast(ast_node(tokens.sub(bodies[i].start, bodies[i].end)));
+            } catch (const deferred_error &e) {
+                bodies[i].failed = true;
+                bodies[i].error = e;
+            }
+        }
+    };
+    std::vector <std::thread> pool;
+    for (int i = 1; i < std::min<int>(options::jobs, (int) bodies.size()); ++i)
+        pool.emplace_back(work);
+    work();
+    for (std::thread &t : pool)
+        t.join();
+}
+
+/// validates a variable declaration and creates its object; the caller
+/// stores it in the slot of the variable
 /// \param obj: the tokens required to define the object
-/// \param to_global: whether to commit the new declaration to the
-///                   global memory scope
-void interpreter::declare_obj(std::vector <token> obj, bool to_global) {
+/// \param defined: whether the variable is already declared in its
+///                 function
+/// \return the object of the new variable
+object *interpreter::declare_obj(token_span obj, bool defined) {
     if (obj.size() != 2)
         err("variable declaration format is [type] [identifier]", obj.back().line);
     if (obj.back().type != t_symbol)
         err("invalid variable identifier", obj.back().line);
-    if (!memory::valid(obj.back().val))
-        err("cannot redeclare existing symbol \"" + obj.back().val + "\"", obj.back().line);
-    o_type t_obj = object::str_o_type(obj.front().val);
-    std::variant<double, std::string, bool, std::vector<object *>, std::queue<object *>, std::stack<object *>, std::unordered_set<object *, obj_hash, obj_equals>, std::unordered_map<object *, object *, obj_hash, obj_equals>> store;
-    if (obj.front().val == "num")
-        store = (double) 0;
-    else if (obj.front().val == "bool")
-        store = false;
-    else if (obj.front().val == "str")
-        store = "";
-    else if (obj.front().val == "arr")
-        store = std::vector<object *>();
-    else if (obj.front().val == "queue")
-        store = std::queue<object *>();
-    else if (obj.front().val == "stack")
-        store = std::stack<object *>();
-    else if (obj.front().val == "set")
-        store = std::unordered_set<object *, obj_hash, obj_equals>();
-    else if (obj.front().val == "map")
-        store = std::unordered_map<object *, object *, obj_hash, obj_equals>();
-    else
-        err("unimplemented var type");
-
-    object *tmp = new object(t_obj);
-    tmp->set(store);
-    memory::add(obj.back().val, tmp, to_global);
+    if (defined || !memory::valid(obj.back().val))
+        err("cannot redeclare existing symbol \"" + symbol::str(obj.back().val) + "\"", obj.back().line);
+    return runtime::make(obj.front().val);
 }
 
 /// validates and declares a function
 /// \param start: the start index of the function declaration
 /// \param end: the end index of the function declaration
+/// \param body: the parsed body of the function
 /// \return true if the function is valid
-bool interpreter::declare_fn(int start, int end) {
+bool interpreter::declare_fn(int start, int end, const fn_body &body) {
     int beg = start + 1;
     if (end - start < 7)
         err("function declaration is too short", tokens[end].line);
-    if (tokens[start].val == "fn" &&
-        (tokens[++start].val == "main" || memory::valid(tokens[start].val)) &&
-        token::vars.find(tokens[++start].val) != token::vars.end()) {
+    if (tokens[start].val == s_fn &&
+        (tokens[++start].val == s_main || memory::valid(tokens[start].val)) &&
+        token::is_var(tokens[++start].val)) {
         object *fn_obj = new object(o_fn);
-        fn_obj->f_return = object::str_o_type(tokens[start].val);
+        fn_obj->def->returns = object::sym_o_type(tokens[start].val);
         ++start;
-        if (tokens[start].val != "(")
+        if (tokens[start].val != s_lparen)
             err("invalid function declaration format", tokens[start].line);
         int p_end = start;
-        while (p_end < end && tokens[p_end].val != "start" && tokens[p_end].val != ")")
+        while (p_end < end && tokens[p_end].val != s_start && tokens[p_end].val != s_rparen)
             ++p_end;
         if (p_end == end)
             err("invalid parameter declaration", tokens[end].line);
-        if (tokens[p_end].val == "start")
+        if (tokens[p_end].val == s_start)
             err(") not found in function declaration", tokens[p_end].line);
         int p_start = ++start;
         --p_end;
-        std::unordered_set <std::string> used_symbol;
-        while (tokens[start].val != ")") {
-            if (tokens[start].val == ",") {
+        std::unordered_set <std::uint32_t> used_symbol;
+        while (tokens[start].val != s_rparen) {
+            if (tokens[start].val == s_comma) {
                 if (start - p_start != 2)
                     err("invalid parameter declaration", tokens[start].line);
-                if (token::vars.find(tokens[p_start].val) == token::vars.end() || tokens[p_start].val == "none")
+                if (!token::is_var(tokens[p_start].val) || tokens[p_start].val == s_none)
                     err("parameter declaration must define type", tokens[start].line);
                 if (tokens[p_start + 1].type != t_symbol)
                     err("parameter identifier invalid", tokens[start].line);
                 if (used_symbol.find(tokens[p_start + 1].val) != used_symbol.end())
                     err("parameter name used twice", tokens[start].line);
                 used_symbol.insert(tokens[p_start + 1].val);
-                fn_obj->f_params.emplace_back(object::str_o_type(tokens[p_start].val), tokens[p_start + 1].val);
+                fn_obj->def->params.emplace_back(object::sym_o_type(tokens[p_start].val), tokens[p_start + 1].val);
                 p_start = start + 1;
             }
             ++start;
         }
-        if (tokens[start].val != ")" ||
-            (start == p_start && !(tokens[start - 1].val == "(" && tokens[start].val == ")")))
+        if (tokens[start].val != s_rparen ||
+            (start == p_start && !(tokens[start - 1].val == s_lparen && tokens[start].val == s_rparen)))
             err("invalid function declaration parentheses", tokens[start].line);
-        if (!(tokens[start - 1].val == "(" && tokens[start].val == ")")) {
+        if (!(tokens[start - 1].val == s_lparen && tokens[start].val == s_rparen)) {
             if (start - p_start != 2)
                 err("invalid parameter declaration", tokens[start].line);
-            if (token::vars.find(tokens[p_start].val) == token::vars.end() || tokens[p_start].val == "none")
+            if (!token::is_var(tokens[p_start].val) || tokens[p_start].val == s_none)
                 err("parameter declaration must define type", tokens[start].line);
             if (tokens[p_start + 1].type != t_symbol)
                 err("parameter identifier invalid", tokens[start].line);
             if (used_symbol.find(tokens[p_start + 1].val) != used_symbol.end())
                 err("parameter name used twice", tokens[start].line);
             used_symbol.insert(tokens[p_start + 1].val);
-            fn_obj->f_params.emplace_back(object::str_o_type(tokens[p_start].val), tokens[p_start + 1].val);
+            fn_obj->def->params.emplace_back(object::sym_o_type(tokens[p_start].val), tokens[p_start + 1].val);
         }
         ++start;
-        if (tokens[start].val != "start")
+        // `memo` after the parameters memoizes the function
+        if (tokens[start].type == t_symbol && tokens[start].val == symbol::intern("memo")) {
+            if (!memo::scalar(fn_obj))
+                err("memo function must take and return num, str or bool", tokens[start].line);
+            fn_obj->def->table = new memo(tokens[beg].val);
+            ++start;
+        }
+        if (tokens[start].val != s_start)
             err("function block must begin after parameters", tokens[start].line);
-        fn_obj->f_body = new ast_node(ast_node::subarray(tokens, start + 2, end - 1));
-        memory::add(tokens[beg].val, fn_obj, true);
-        return tokens[beg].val == "main";
+        if (body.failed)
+            body.error.report();
+        fn_obj->def->body = body.tree;
+        fn_obj->def->source = tokens.sub(body.start, body.end);
+        memory::add(tokens[beg].val, fn_obj);
+        functions.push_back(tokens[beg].val);
+        return tokens[beg].val == s_main;
     } else
         err("invalid function declaration", tokens[start].line);
     return false;
@@ -143,18 +193,60 @@ bool interpreter::declare_fn(int start, int end) {
 
 /// executes the body of the main function to start the program
 void interpreter::execute() {
-    object *root = memory::get("main");
-    if (root->f_params.size() != 0)
+    object *root = memory::get(s_main);
+    if (root->def->params.size() != 0)
         err("main must have no parameters");
-    if (root->f_return != o_none)
+    if (root->def->returns != o_none)
         err("main must have return type none");
-    // push the first scope to memory
-    memory::push();
-    executor *process = new executor(root->f_body, root);
+    // every body is bound and checked before main runs, unless
+    // bodies are only parsed once called
+    if (!options::lazy)
+        for (std::uint32_t id : functions)
+            memory::get(id)->body();
+    // pure functions are memoized once their bodies are bound
+    if (options::memo)
+        memo::analyze(functions);
+    // functions are compiled to native code once they are hot, or on
+    // their first call
+    if (options::jit != "off")
+        jit::threshold = options::jit == "on" ? 1 : options::jit_threshold;
+    // the first collection is due once the least threshold of objects
+    // is allocated
+    gc::minimum = heap::threshold = options::gc_threshold;
+    // push the frame of main
+    std::size_t frame = memory::push(root->body()->frame);
     auto start = std::chrono::high_resolution_clock::now();
-    process->init();
+    runtime::run_on_stack((std::size_t) options::stack_limit << 20, [] {
+        object *root = memory::get(s_main);
+        if (options::engine == "vm")
+            vm::call(root);
+        else if (jit::hot(root))
+            jit::run(root);
+        else
+            executor(root->body(), root).init();
+    });
     auto stop = std::chrono::high_resolution_clock::now();
     // times the runtime
     auto duration = std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
-    memory::pop();
+    memory::pop(frame);
+    // on stderr, so that the output of the program stays the same
+    if (options::quicken_stats)
+        std::cerr << "quickening: " << executor::specialized << " nodes specialized, " << executor::deoptimized
+                  << " deoptimized" << std::endl;
+    if (options::memo_stats)
+        memo::report();
+    if (options::gc_stats)
+        gc::report();
+}
+
+/// prints the syntax tree or the bytecode of every function, in
+/// declaration order
+void interpreter::print() {
+    for (std::uint32_t id : functions) {
+        std::cout << "fn " << symbol::str(id) << "\n";
+        if (options::dump_bytecode)
+            memory::get(id)->code()->print();
+        else
+            memory::get(id)->body()->print(0, 1);
+    }
 }
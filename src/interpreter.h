@@ -6,31 +6,61 @@
 #ifndef QI_INTERPRETER_INTERPRETER_H
 #define QI_INTERPRETER_INTERPRETER_H
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <iostream>
 #include <string>
+#include <thread>
 #include <vector>
 #include <unordered_set>
 
 #include "executor.h"
+#include "memo.h"
 #include "memory.h"
+#include "options.h"
+#include "runtime.h"
 #include "token.h"
 #include "util.h"
 
+/// the parsed body of a function declaration, or the error its parse
+/// raised, which is only reported once the declaration is reached
+class fn_body {
+public:
+    int start, end;
+    ast *tree;
+    bool failed;
+    deferred_error error;
+};
+
 /// the single interpreter which is based directly on the tokens
-/// generated by the lexer
+/// generated by the lexer; every AST node views into its buffer
 class interpreter {
 private:
-    std::vector <token> tokens;
+    friend class program_cache;
+    friend class emitter;
+
+    token_buffer buffer;
+    token_span tokens;
+    std::vector<int> globals;
+    std::vector <std::uint32_t> functions;
+
+    static std::vector <fn_body> find_bodies(token_span tokens, const std::vector <std::pair<int, int>> &blocks);
+
+    void parse_bodies(std::vector <fn_body> &bodies);
 
 public:
-    interpreter(std::vector <token> &tokens);
+    interpreter();
 
-    static void declare_obj(std::vector <token> obj, bool to_global = false);
+    explicit interpreter(std::vector <token> _tokens);
 
-    bool declare_fn(int start, int end);
+    static object *declare_obj(token_span obj, bool defined = false);
+
+    bool declare_fn(int start, int end, const fn_body &body);
 
     void execute();
+
+    void print();
 };
 
 #endif //QI_INTERPRETER_INTERPRETER_H
@@ -0,0 +1,1413 @@
+/*
+ * jit.cpp contains:
+ *   - Definitions for the x86-64 template JIT
+ *   - The runtime entry points of native code
+ */
+
+#include "jit.h"
+
+std::uint32_t jit::threshold = 0;
+std::uint64_t jit::compiled = 0;
+object *jit::next = nullptr;
+// marks a function that cannot be compiled, so that it is never tried
+// again
+native jit::rejected;
+std::vector<std::pair<const native *, char *>> jit::frames;
+
+// the code generated is x86-64; on other hosts options::parse rejects
+// every jit mode but off, so the threshold stays 0 and nothing is run
+#if defined(__x86_64__)
+
+/// compiles a function to native code, or marks it as rejected if its
+/// body runs on the tree walker or uses what the compiler leaves to the
+/// VM
+/// \param fn: the function
+/// \return whether the function was compiled
+bool jit::compile(object *fn) {
+    fn->def->compiled = &rejected;
+    bytecode *code = fn->code();
+    if (!code->compiled)
+        return false;
+    jit pass(fn, code);
+    if (!pass.translate()) {
+        delete pass.out;
+        return false;
+    }
+    fn->def->compiled = pass.out;
+    ++compiled;
+    return true;
+}
+
+/// runs a compiled function whose frame is pushed
+/// \param fn: the function
+/// \return the value of the call
+object *jit::run(object *fn) {
+    // the frame entered is traced until it returns
+    std::size_t base = frames.size();
+    object *ret = fn->def->compiled->entry(0, nullptr);
+    frames.resize(base);
+    return settle(ret);
+}
+
+/// moves a VM frame over to the compiled code of its function, at the
+/// head of a loop
+/// \param fn: the function
+/// \param pc: the instruction at the head of the loop
+/// \param slots: the for loop slots of the VM frame
+/// \return the value of the call
+object *jit::resume(object *fn, std::uint32_t pc, ::value *slots) {
+    std::size_t base = frames.size();
+    object *ret = fn->def->compiled->entry(pc, slots);
+    frames.resize(base);
+    return settle(ret);
+}
+
+/// runs the calls in tail position that native code left to run in
+/// place of its function, one after the other, until one returns
+/// \param ret: the value native code returned, or nullptr if it left a
+///             call to next, which took over its frame
+/// \return the value of the call
+object *jit::settle(object *ret) {
+    while (!ret) {
+        object *fn = next;
+        if (hot(fn)) {
+            std::size_t base = frames.size();
+            ret = fn->def->compiled->entry(0, nullptr);
+            frames.resize(base);
+        } else if (options::engine == "vm")
+            ret = vm::call(fn).box();
+        else
+            ret = executor(fn->body(), fn).init().box();
+    }
+    return ret;
+}
+
+/// sets up the compiler of a function
+/// \param _fn: the function
+/// \param _code: its bytecode
+jit::jit(object *_fn, bytecode *_code) : fn(_fn), code(_code), tree(*_code->tree), depth(0) {
+    out = new native();
+    out->fn = fn;
+    out->code = code;
+    out->entry = nullptr;
+}
+
+/// translates the bytecode, one instruction after the other. The stack
+/// is empty at every jump target, so what each cell holds is known from
+/// the instructions before it
+/// \return whether the body could be compiled
+bool jit::translate() {
+    const std::vector <instruction> &ins = code->code;
+    std::uint32_t count = (std::uint32_t) ins.size();
+    std::vector<bool> targets(count + 1, false);
+    // the heads of loops, where a VM frame can move over
+    std::vector <std::uint32_t> entries;
+    for (std::uint32_t i = 0; i < count; ++i) {
+        const instruction &in = ins[i];
+        // a call of the function itself in tail position jumps back to
+        // the start
+        if (in.op == op_tail_call && tail_callee(in.b) == fn)
+            targets[0] = true;
+        if (in.op == op_jump || in.op == op_jump_false || in.op == op_for_test || in.op == op_for_step) {
+            targets[in.a] = true;
+            if (in.op == op_for_step || (in.op == op_jump && in.a <= i))
+                entries.push_back(in.a);
+        }
+    }
+
+    // a slot is a num local if every declaration of it is a num
+    std::vector <std::optional<o_type>> types = checker::local_types(fn);
+    out->plain.assign(tree.frame, false);
+    for (std::uint32_t s = 0; s < tree.frame && s < types.size(); ++s)
+        out->plain[s] = types[s] && *types[s] == o_num;
+    out->values = 0;
+    out->flags = 8 * tree.frame;
+    out->loops = (out->flags + tree.frame + 7) / 8 * 8;
+    out->live = out->loops + 8 * code->slots;
+    out->cells = out->live + 8;
+    loop_vars.assign(code->slots, ast::no_slot);
+
+    // push rbp; mov rbp, rsp; push rbx; push r12; sub rsp, size
+    for (std::uint8_t b : {0x55, 0x48, 0x89, 0xE5, 0x53, 0x41, 0x54, 0x48, 0x81, 0xEC})
+        byte(b);
+    std::size_t size_at = buf.size();
+    word(0);
+    mov_reg(rbx, rsp);
+    // mov r12d, edi: the instruction to start at
+    for (std::uint8_t b : {0x41, 0x89, 0xFC})
+        byte(b);
+    mov_reg(rdx, rsi);
+    mov_reg(rsi, rbx);
+    mov_imm(rdi, reinterpret_cast<std::uintptr_t>(out));
+    call_fn(&jit::enter);
+    for (std::uint32_t pc : entries) {
+        // cmp r12d, pc
+        for (std::uint8_t b : {0x41, 0x81, 0xFC})
+            byte(b);
+        word(pc);
+        jump_to(c_equal, pc);
+    }
+
+    std::vector<bool> heads(count + 1, false);
+    for (std::uint32_t pc : entries)
+        heads[pc] = true;
+
+    labels.assign(count + 1, -1);
+    bool reachable = true;
+    for (std::uint32_t pc = 0; pc < count; ++pc) {
+        if (targets[pc]) {
+            if (reachable && !stack.empty())
+                return false;
+            stack.clear();
+            reachable = true;
+            labels[pc] = (std::int64_t) buf.size();
+        }
+        if (!reachable)
+            continue;
+        // the start of the body and the heads of loops are safe points,
+        // where the operand stack is empty
+        if (pc == 0 || heads[pc])
+            safe_point();
+        const instruction &in = ins[pc];
+        switch (in.op) {
+            case op_num: {
+                push(k_const, in.a);
+                break;
+            }
+            case op_str: {
+                mov_imm32(rdi, in.a);
+                call_fn(&jit::str);
+                push_obj();
+                break;
+            }
+            case op_none: {
+                push(k_none);
+                break;
+            }
+            case op_pop: {
+                stack.pop_back();
+                break;
+            }
+            case op_jump: {
+                jump_to(c_always, in.a);
+                reachable = false;
+                break;
+            }
+            case op_jump_false: {
+                truth((std::uint32_t) stack.size() - 1);
+                stack.pop_back();
+                if (!stack.empty())
+                    return false;
+                // test al, al
+                byte(0x84);
+                byte(0xC0);
+                jump_to(c_equal, in.a);
+                break;
+            }
+            case op_error: {
+                fail(code->messages[in.a], in.b == bytecode::no_line ? -1 : tree.line(in.b));
+                reachable = false;
+                break;
+            }
+            case op_arity: {
+                mov_imm(rdi, reinterpret_cast<std::uintptr_t>(out));
+                mov_imm32(rsi, in.b);
+                call_fn(&jit::arity);
+                reachable = false;
+                break;
+            }
+            case op_declare: {
+                mov_imm(rdi, reinterpret_cast<std::uintptr_t>(out));
+                mov_imm32(rsi, in.b);
+                mov_reg(rdx, rbx);
+                call_fn(&jit::declare);
+                break;
+            }
+            case op_symbol: {
+                const ast::node &n = tree[in.b];
+                if (n.slot < ast::global_slot) {
+                    // a local named after a library function is only
+                    // told apart from it at run time
+                    if (n.slot >= tree.frame || token::is_method(n.val))
+                        return false;
+                    if (out->plain[n.slot]) {
+                        std::size_t defined = test_flag(n.slot, c_not_equal);
+                        fail("symbol \"" + symbol::str(n.val) + "\" is undefined", tree.line(in.b));
+                        land(defined);
+                        push(k_ref, n.slot);
+                    } else {
+                        mov_imm(rdi, reinterpret_cast<std::uintptr_t>(out));
+                        mov_imm32(rsi, in.b);
+                        call_fn(&jit::local);
+                        push_obj();
+                    }
+                    // a variable skips the arguments of a call
+                    pc = in.a - 1;
+                    break;
+                }
+                // every global is declared once the body runs, so what a
+                // symbol is is known here
+                object *obj = memory::find(n.slot);
+                if (n.slot != ast::no_slot && !obj)
+                    return false;
+                if (obj && obj->type != o_fn) {
+                    mov_imm(rax, reinterpret_cast<std::uintptr_t>(obj));
+                    push_obj();
+                    pc = in.a - 1;
+                } else if (obj && obj->def->params.size() != n.count) {
+                    // the engines report the node type as the line
+                    fail("incorrect number of children for function \"" + symbol::str(n.val) + "\"", n.type);
+                    reachable = false;
+                } else if (!obj) {
+                    if ((n.val == s_floor || n.val == s_ceil) && n.count != 1)
+                        fail(symbol::str(n.val) + " requires 1 argument", tree.line(in.b));
+                    else if (n.val == s_round && n.count != 2)
+                        fail("round requires 2 arguments", tree.line(in.b));
+                    else if (n.val == s_rand && n.count != 0)
+                        fail("rand takes no arguments", tree.line(in.b));
+                    else if (!token::is_method(n.val))
+                        fail("symbol \"" + symbol::str(n.val) + "\" is undefined", tree.line(in.b));
+                    else
+                        break;
+                    reachable = false;
+                }
+                break;
+            }
+            case op_call: {
+                call(in.b);
+                break;
+            }
+            case op_tail_call: {
+                if (!tail_callee(in.b)) {
+                    call(in.b);
+                    break;
+                }
+                tail(in.b);
+                reachable = false;
+                break;
+            }
+            case op_method: {
+                method(in.a, in.b);
+                break;
+            }
+            case op_binary: {
+                binary(in.a, false);
+                break;
+            }
+            case op_num_binary: {
+                binary(in.a, true);
+                break;
+            }
+            case op_not: {
+                std::uint32_t p = (std::uint32_t) stack.size() - 1;
+                if (stack[p].k == k_bool || numeric(stack[p])) {
+                    truth(p);
+                    // xor al, 1
+                    byte(0x34);
+                    byte(0x01);
+                    frame_op({0x88}, rax, cell(p));
+                    stack[p] = {k_bool, 0};
+                } else {
+                    box(p);
+                    load_reg(rdi, cell(p));
+                    call_fn(&jit::negate);
+                    stack.pop_back();
+                    push_obj();
+                }
+                break;
+            }
+            case op_out:
+            case op_outl: {
+                std::uint32_t p = (std::uint32_t) stack.size() - 1;
+                bool newline = in.op == op_outl;
+                if (numeric(stack[p])) {
+                    load_num(p, 0);
+                    mov_imm32(rdi, newline);
+                    call_fn(&jit::print_num);
+                } else if (stack[p].k == k_bool) {
+                    // movzx edi, byte [cell]
+                    frame_op({0x0F, 0xB6}, rdi, cell(p));
+                    mov_imm32(rsi, newline);
+                    call_fn(&jit::print_bool);
+                } else {
+                    box(p);
+                    load_reg(rdi, cell(p));
+                    mov_imm32(rsi, newline);
+                    call_fn(&jit::print);
+                }
+                stack[p] = {k_none, 0};
+                break;
+            }
+            case op_in: {
+                std::uint32_t p = (std::uint32_t) stack.size() - 1;
+                if (stack[p].k == k_ref) {
+                    mov_imm32(rdi, (std::uint32_t) tree.line(in.b));
+                    call_fn(&runtime::read_num);
+                    store_sd(0, var(stack[p].val));
+                } else {
+                    box(p);
+                    load_reg(rdi, cell(p));
+                    mov_imm32(rsi, (std::uint32_t) tree.line(in.b));
+                    call_fn(&runtime::read);
+                }
+                stack[p] = {k_none, 0};
+                break;
+            }
+            case op_return: {
+                // the returned value is a copy; a num is returned in an
+                // object off the free list, which a native caller puts
+                // back once it has read it
+                std::uint32_t p = (std::uint32_t) stack.size() - 1;
+                if (numeric(stack[p])) {
+                    load_num(p, 0);
+                    call_fn(&jit::result);
+                } else if (stack[p].k == k_bool) {
+                    frame_op({0x0F, 0xB6}, rdi, cell(p));
+                    call_fn(&runtime::boolean);
+                } else {
+                    box(p);
+                    load_reg(rdi, cell(p));
+                    call_fn(&runtime::copy);
+                }
+                mov_reg(rdx, rax);
+                leave(l_return);
+                reachable = false;
+                break;
+            }
+            case op_leave: {
+                if (in.a == l_none) {
+                    std::uint32_t p = (std::uint32_t) stack.size() - 1;
+                    box(p);
+                    load_reg(rdx, cell(p));
+                } else {
+                    call_fn(&jit::none);
+                    mov_reg(rdx, rax);
+                }
+                leave(in.a);
+                reachable = false;
+                break;
+            }
+            case op_check_int: {
+                std::uint32_t p = (std::uint32_t) stack.size() - 1;
+                if (numeric(stack[p])) {
+                    load_num(p, 0);
+                    mov_imm32(rdi, (std::uint32_t) tree.line(in.b));
+                    call_fn(&jit::check_int);
+                } else {
+                    box(p);
+                    load_reg(rdi, cell(p));
+                    mov_imm32(rsi, (std::uint32_t) tree.line(in.b));
+                    call_fn(&jit::check_int_obj);
+                }
+                break;
+            }
+            case op_for_enter: {
+                std::uint32_t v = in.b + 2, slot = tree[v].slot;
+                if (slot == ast::no_slot)
+                    return false;
+                if (slot >= ast::global_slot) {
+                    fail("for loop variable already defined", tree.line(v));
+                    reachable = false;
+                    break;
+                }
+                // the loop variable is kept unboxed
+                if (slot >= tree.frame || !out->plain[slot])
+                    return false;
+                loop_vars[in.a] = slot;
+                std::size_t undefined = test_flag(slot, c_equal);
+                fail("for loop variable already defined", tree.line(v));
+                land(undefined);
+                set_flag(slot, 1);
+                mov_double(0, 0);
+                store_sd(0, var(slot));
+                store_sd(0, loop(in.a + 1));
+                mov_double(0, 1);
+                store_sd(0, loop(in.a + 2));
+                break;
+            }
+            case op_for_init: {
+                // the args are checked to be integers
+                std::uint32_t args = tree[in.b].count, p = (std::uint32_t) stack.size() - args,
+                        slot = loop_vars[in.a];
+                for (std::uint32_t q = p; q < stack.size(); ++q)
+                    if (!numeric(stack[q])) {
+                        box(q);
+                        unbox(q);
+                    }
+                load_num(args == 1 ? p : p + 1, 0);
+                store_sd(0, loop(in.a + 1));
+                if (args == 3) {
+                    load_num(p + 2, 0);
+                    store_sd(0, loop(in.a + 2));
+                }
+                if (args == 1)
+                    mov_double(0, 0);
+                else
+                    load_num(p, 0);
+                store_sd(0, var(slot));
+                stack.resize(p);
+                break;
+            }
+            case op_for_test: {
+                // leave the loop unless the variable is below the end
+                std::uint32_t slot = loop_vars[in.b];
+                if (slot == ast::no_slot)
+                    return false;
+                load_sd(0, var(slot));
+                load_sd(1, loop(in.b + 1));
+                ucomisd(1, 0);
+                jump_to(c_below_eq, in.a);
+                break;
+            }
+            case op_for_step: {
+                std::uint32_t slot = loop_vars[in.b];
+                if (slot == ast::no_slot)
+                    return false;
+                load_sd(0, var(slot));
+                load_sd(1, loop(in.b + 2));
+                sse(0x58, 0, 1);
+                store_sd(0, var(slot));
+                jump_to(c_always, in.a);
+                reachable = false;
+                break;
+            }
+            case op_for_exit: {
+                std::uint32_t slot = tree[in.b + 2].slot;
+                if (slot < tree.frame && out->plain[slot])
+                    set_flag(slot, 0);
+                break;
+            }
+        }
+    }
+
+    // the object cells of a call fit in its mask
+    if (depth > 64)
+        return false;
+    for (const std::pair<std::size_t, std::uint32_t> &j : jumps) {
+        if (labels[j.second] < 0)
+            return false;
+        std::int32_t rel = (std::int32_t) (labels[j.second] - (std::int64_t) (j.first + 4));
+        std::memcpy(&buf[j.first], &rel, 4);
+    }
+    std::uint32_t size = std::max(16u, (out->cells + 8 * depth + 15) / 16 * 16);
+    std::memcpy(&buf[size_at], &size, 4);
+
+    // the code is written, then made executable and read only
+    std::size_t page = (std::size_t) sysconf(_SC_PAGESIZE), length = (buf.size() + page - 1) / page * page;
+    void *mem = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED)
+        return false;
+    std::memcpy(mem, buf.data(), buf.size());
+    if (mprotect(mem, length, PROT_READ | PROT_EXEC) != 0) {
+        munmap(mem, length);
+        return false;
+    }
+    out->entry = reinterpret_cast<native::entry_point>(mem);
+    return true;
+}
+
+/// compiles the call of a function or a library function, whose
+/// arguments are on the stack; the symbol was resolved at op_symbol
+/// \param u: the symbol node
+void jit::call(std::uint32_t u) {
+    const ast::node &n = tree[u];
+    std::uint32_t p = (std::uint32_t) stack.size() - n.count;
+    object *callee = memory::find(n.slot);
+    if (!callee && (n.val == s_floor || n.val == s_ceil) && numeric(stack[p])) {
+        load_num(p, 0);
+        double (*round_fn)(double) = std::floor;
+        if (n.val == s_ceil)
+            round_fn = std::ceil;
+        call_fn(round_fn);
+        store_sd(0, cell(p));
+        stack.resize(p);
+        push(k_num);
+        return;
+    }
+    // num args of a function are boxed in objects that are only read
+    // by the call, which are put back on the free list once it returns
+    std::uint32_t spare = 0;
+    for (std::uint32_t q = p; q < stack.size(); ++q) {
+        if (callee && q - p < 32 && numeric(stack[q])) {
+            load_num(q, 0);
+            call_fn(&jit::arg);
+            store_reg(rax, cell(q));
+            stack[q] = {k_obj, 0};
+            spare |= 1u << (q - p);
+        } else
+            box(q);
+    }
+    if (callee) {
+        // the callee may collect, so the objects of the frame are roots
+        roots();
+        mov_imm(rdi, reinterpret_cast<std::uintptr_t>(out));
+        mov_imm(rsi, reinterpret_cast<std::uintptr_t>(callee));
+        lea(rdx, cell(p));
+        // a function that returns a num gives it unboxed, and puts the
+        // num args back on the free list itself
+        if (callee->type == o_fn && callee->def->returns == o_num) {
+            mov_imm(rcx, (std::uint64_t) spare << 32 | u);
+            call_fn(&jit::invoke_num);
+            store_sd(0, cell(p));
+            stack.resize(p);
+            push(k_num);
+            return;
+        }
+        mov_imm32(rcx, u);
+        call_fn(&jit::invoke);
+        if (spare) {
+            mov_reg(rdi, rax);
+            lea(rsi, cell(p));
+            mov_imm32(rdx, spare);
+            call_fn(&jit::returned);
+        }
+    } else {
+        mov_imm32(rdi, n.val);
+        lea(rsi, cell(p));
+        call_fn(&runtime::library);
+    }
+    stack.resize(p);
+    push_obj();
+}
+
+/// \param u: the symbol node of a call in tail position
+/// \return the function called, if it runs in place of the function,
+///         i.e. it returns the type the function returns
+object *jit::tail_callee(std::uint32_t u) const {
+    const ast::node &n = tree[u];
+    object *callee = n.slot >= ast::global_slot ? memory::find(n.slot) : nullptr;
+    if (!callee || callee->type != o_fn || callee->def->returns != fn->def->returns || fn->def->returns == o_none)
+        return nullptr;
+    return callee;
+}
+
+/// compiles a call in tail position, whose args are on the stack. A
+/// call of the function itself reuses the native frame and jumps back
+/// to the start: num args of num parameters are passed unboxed, without
+/// creating objects. A call of another function takes over the memory
+/// frame and is returned as nullptr, for settle to run
+/// \param u: the symbol node
+void jit::tail(std::uint32_t u) {
+    object *callee = tail_callee(u);
+    std::uint32_t p = (std::uint32_t) stack.size() - tree[u].count;
+    bool unboxed = callee == fn;
+    for (std::uint32_t q = p; q < stack.size(); ++q)
+        unboxed = unboxed && out->plain[q - p] && numeric(stack[q]);
+    if (unboxed) {
+        // every arg is read before a parameter is written
+        for (std::uint32_t q = p; q < stack.size(); ++q) {
+            load_num(q, 0);
+            store_sd(0, cell(q));
+        }
+        if (std::find(out->plain.begin(), out->plain.end(), false) != out->plain.end()) {
+            mov_imm32(rdi, tree.frame);
+            mov_imm32(rsi, stack.size() - p);
+            call_fn(&memory::reuse);
+        }
+        for (std::uint32_t s = 0; s < tree.frame; ++s)
+            if (out->plain[s])
+                set_flag(s, s < stack.size() - p);
+        for (std::uint32_t q = p; q < stack.size(); ++q) {
+            load_sd(0, cell(q));
+            store_sd(0, var(q - p));
+        }
+        jump_to(c_always, 0);
+        return;
+    }
+    for (std::uint32_t q = p; q < stack.size(); ++q)
+        box(q);
+    mov_imm(rdi, reinterpret_cast<std::uintptr_t>(out));
+    mov_imm(rsi, reinterpret_cast<std::uintptr_t>(callee));
+    lea(rdx, cell(p));
+    mov_imm32(rcx, u);
+    call_fn(&jit::take_over);
+    if (callee == fn) {
+        // the num locals are read again from the memory frame
+        mov_imm(rdi, reinterpret_cast<std::uintptr_t>(out));
+        mov_reg(rsi, rbx);
+        mov_imm32(rdx, 0);
+        call_fn(&jit::enter);
+        jump_to(c_always, 0);
+        return;
+    }
+    mov_imm32(rax, 0);
+    epilogue();
+}
+
+/// compiles a binary operator. Two nums are computed in registers: an
+/// assignment stores into a num local or a checked num object, and a
+/// comparison leaves a bool in its cell. A num local on the left of an
+/// assignment with any other operand is boxed and written back
+/// \param op: the operator
+/// \param checked: whether the checker proved the operands to be nums
+void jit::binary(std::uint32_t op, bool checked) {
+    std::uint32_t p = (std::uint32_t) stack.size() - 2, base = runtime::compound_base(op);
+    value left = stack[p], right = stack[p + 1];
+    bool assign = op == s_assign || base != s_blank;
+    bool nums = (numeric(left) || (checked && left.k == k_obj)) && (numeric(right) || (checked && right.k == k_obj));
+    if (nums && runtime::num_operator(op)) {
+        if (right.k == k_obj)
+            unbox(p + 1);
+        kind result = k_none;
+        if (assign && left.k == k_obj) {
+            // a num object is changed in place
+            if (op == s_assign)
+                load_num(p + 1, 0);
+            else {
+                load_reg(rdi, cell(p));
+                call_fn(&jit::num_of);
+                load_num(p + 1, 1);
+                arithmetic(base);
+            }
+            load_reg(rdi, cell(p));
+            call_fn(&jit::set_num);
+        } else {
+            if (left.k == k_obj)
+                unbox(p);
+            load_num(p, 0);
+            load_num(p + 1, 1);
+            if (assign) {
+                if (op == s_assign)
+                    sse(0x10, 0, 1);
+                else
+                    arithmetic(base);
+                if (left.k == k_ref)
+                    store_sd(0, var(left.val));
+            } else if (runtime::arithmetic(op)) {
+                arithmetic(op);
+                store_sd(0, cell(p));
+                result = k_num;
+            } else {
+                compare(op);
+                frame_op({0x88}, rax, cell(p));
+                result = k_bool;
+            }
+        }
+        stack.resize(p);
+        push(result);
+        return;
+    }
+    if ((op == s_and || op == s_or) && (numeric(left) || left.k == k_bool) &&
+        (numeric(right) || right.k == k_bool)) {
+        truth(p);
+        frame_op({0x88}, rax, cell(p));
+        truth(p + 1);
+        // mov cl, [cell]; and al, cl or or al, cl
+        frame_op({0x8A}, rcx, cell(p));
+        byte(op == s_and ? 0x20 : 0x08);
+        byte(0xC8);
+        frame_op({0x88}, rax, cell(p));
+        stack.resize(p);
+        push(k_bool);
+        return;
+    }
+    if (!assign || left.k != k_ref)
+        box(p);
+    box(p + 1);
+    mov_imm32(rdi, op);
+    if (assign && left.k == k_ref) {
+        lea(rsi, var(left.val));
+        load_reg(rdx, cell(p + 1));
+        call_fn(&jit::update);
+    } else {
+        load_reg(rsi, cell(p));
+        load_reg(rdx, cell(p + 1));
+        call_fn(&jit::apply);
+    }
+    stack.resize(p);
+    push_obj();
+}
+
+/// compiles a method call on the target below its args; `.at()` with a
+/// num index and `.len()` don't box what they take or give
+/// \param name: the method
+/// \param u: the call node of the method
+void jit::method(std::uint32_t name, std::uint32_t u) {
+    std::uint32_t args = 0;
+    if (name == s_push || name == s_find || name == s_at)
+        args = 1;
+    else if (name == s_fill)
+        args = 3;
+    else if (name == s_sub)
+        args = tree[u].count;
+    std::uint32_t top = (std::uint32_t) stack.size() - args, t = top - 1;
+    if (name == s_at && stack[t].k == k_obj && numeric(stack[top])) {
+        load_num(top, 0);
+        load_reg(rdi, cell(t));
+        call_fn(static_cast<object *(*)(object *, double)>(&runtime::at));
+        stack.resize(t);
+        push_obj();
+        return;
+    }
+    if (name == s_len && stack[t].k == k_obj) {
+        load_reg(rdi, cell(t));
+        call_fn(&runtime::len);
+        store_sd(0, cell(t));
+        stack.resize(t);
+        push(k_num);
+        return;
+    }
+    for (std::uint32_t q = t; q < stack.size(); ++q)
+        box(q);
+    mov_imm32(rdi, name);
+    load_reg(rsi, cell(t));
+    lea(rdx, cell(top));
+    mov_imm32(rcx, args);
+    call_fn(&runtime::method);
+    stack.resize(t);
+    push_obj();
+}
+
+/// leaves the function with the returned value in rdx
+/// \param flag: the flag the function is left with
+void jit::leave(std::uint32_t flag) {
+    mov_imm(rdi, reinterpret_cast<std::uintptr_t>(fn));
+    mov_imm32(rsi, flag);
+    call_fn(&jit::finish);
+    epilogue();
+}
+
+/// returns rax from the native frame
+void jit::epilogue() {
+    // lea rsp, [rbp - 16]; pop r12; pop rbx; pop rbp; ret
+    for (std::uint8_t b : {0x48, 0x8D, 0x65, 0xF0, 0x41, 0x5C, 0x5B, 0x5D, 0xC3})
+        byte(b);
+}
+
+/// stores the mask of the cells that hold objects, for the collector to
+/// trace while the frame calls out
+void jit::roots() {
+    std::uint64_t mask = 0;
+    for (std::uint32_t p = 0; p < stack.size() && p < 64; ++p)
+        if (stack[p].k == k_obj)
+            mask |= std::uint64_t(1) << p;
+    mov_imm(rax, mask);
+    store_reg(rax, out->live);
+}
+
+/// collects if a collection is due, as gc::poll does; the operand stack
+/// is empty, so the frame holds no objects of its own
+void jit::safe_point() {
+    // mov rax, [allocated]; cmp rax, [threshold]
+    mov_imm(rax, reinterpret_cast<std::uintptr_t>(&heap::allocated));
+    for (std::uint8_t b : {0x48, 0x8B, 0x00})
+        byte(b);
+    mov_imm(rcx, reinterpret_cast<std::uintptr_t>(&heap::threshold));
+    for (std::uint8_t b : {0x48, 0x3B, 0x01})
+        byte(b);
+    std::size_t skip = jump(c_below);
+    roots();
+    call_fn(&gc::collect);
+    land(skip);
+}
+
+/// \param p: a position on the operand stack
+/// \return the frame offset of its cell
+std::uint32_t jit::cell(std::uint32_t p) const {
+    return out->cells + 8 * p;
+}
+
+/// \param slot: a num local
+/// \return the frame offset of its value
+std::uint32_t jit::var(std::uint32_t slot) const {
+    return out->values + 8 * slot;
+}
+
+/// \param slot: a num local
+/// \return the frame offset of whether it is declared
+std::uint32_t jit::flag(std::uint32_t slot) const {
+    return out->flags + slot;
+}
+
+/// \param i: a for loop slot
+/// \return its frame offset
+std::uint32_t jit::loop(std::uint32_t i) const {
+    return out->loops + 8 * i;
+}
+
+/// pushes a value on the operand stack
+/// \param k: how the value is held
+/// \param val: the slot of a num local or the index of a constant
+void jit::push(kind k, std::uint32_t val) {
+    stack.push_back({k, val});
+    depth = std::max(depth, (std::uint32_t) stack.size());
+}
+
+/// pushes the object in rax
+void jit::push_obj() {
+    store_reg(rax, cell((std::uint32_t) stack.size()));
+    push(k_obj);
+}
+
+/// \param v: a value of the operand stack
+/// \return whether it is a num held unboxed
+bool jit::numeric(const value &v) const {
+    return v.k == k_num || v.k == k_ref || v.k == k_const;
+}
+
+/// turns a value into an object in its cell; a num local is copied, as
+/// it is only read by what takes an object
+/// \param p: the position of the value
+void jit::box(std::uint32_t p) {
+    switch (stack[p].k) {
+        case k_obj:
+            return;
+        case k_bool:
+            frame_op({0x0F, 0xB6}, rdi, cell(p));
+            call_fn(&runtime::boolean);
+            break;
+        case k_none:
+            call_fn(&jit::none);
+            break;
+        default:
+            load_num(p, 0);
+            call_fn(&runtime::num);
+            break;
+    }
+    store_reg(rax, cell(p));
+    stack[p] = {k_obj, 0};
+}
+
+/// turns an object known to be a num into a num in its cell
+/// \param p: the position of the value
+void jit::unbox(std::uint32_t p) {
+    load_reg(rdi, cell(p));
+    call_fn(&jit::num_of);
+    store_sd(0, cell(p));
+    stack[p] = {k_num, 0};
+}
+
+/// loads an unboxed num into xmm0 or xmm1
+/// \param p: the position of the value
+/// \param xmm: the register
+void jit::load_num(std::uint32_t p, int xmm) {
+    const value &v = stack[p];
+    if (v.k == k_num)
+        load_sd(xmm, cell(p));
+    else if (v.k == k_ref)
+        load_sd(xmm, var(v.val));
+    else
+        mov_double(xmm, code->numbers[v.val]);
+}
+
+/// sets al to whether a value is true in a condition
+/// \param p: the position of the value
+void jit::truth(std::uint32_t p) {
+    if (stack[p].k == k_bool)
+        frame_op({0x8A}, rax, cell(p));
+    else if (numeric(stack[p])) {
+        // a num is true unless it is 0; NaN is true
+        load_num(p, 0);
+        mov_double(1, 0);
+        ucomisd(0, 1);
+        setcc(c_not_equal, rax);
+        setcc(c_parity, rcx);
+        // or al, cl
+        byte(0x08);
+        byte(0xC8);
+    } else {
+        box(p);
+        load_reg(rdi, cell(p));
+        call_fn(&jit::truth_of);
+    }
+}
+
+/// computes an arithmetic operator on xmm0 and xmm1 into xmm0; the
+/// operators without an instruction call the runtime
+/// \param op: the operator
+void jit::arithmetic(std::uint32_t op) {
+    if (op == s_plus)
+        sse(0x58, 0, 1);
+    else if (op == s_minus)
+        sse(0x5C, 0, 1);
+    else if (op == s_star)
+        sse(0x59, 0, 1);
+    else if (op == s_slash)
+        sse(0x5E, 0, 1);
+    else {
+        mov_imm32(rdi, op);
+        call_fn(&runtime::num_value);
+    }
+}
+
+/// sets al to a comparison of xmm0 and xmm1, false if either is NaN
+/// unless the comparison is `!=`
+/// \param op: the comparison
+void jit::compare(std::uint32_t op) {
+    switch (op) {
+        case s_less:
+            ucomisd(1, 0);
+            setcc(c_above, rax);
+            break;
+        case s_less_eq:
+            ucomisd(1, 0);
+            setcc(c_above_eq, rax);
+            break;
+        case s_greater:
+            ucomisd(0, 1);
+            setcc(c_above, rax);
+            break;
+        case s_greater_eq:
+            ucomisd(0, 1);
+            setcc(c_above_eq, rax);
+            break;
+        case s_eq_eq:
+            ucomisd(0, 1);
+            setcc(c_equal, rax);
+            setcc(c_no_parity, rcx);
+            // and al, cl
+            byte(0x20);
+            byte(0xC8);
+            break;
+        default:
+            ucomisd(0, 1);
+            setcc(c_not_equal, rax);
+            setcc(c_parity, rcx);
+            byte(0x08);
+            byte(0xC8);
+            break;
+    }
+}
+
+/// raises an error where the code gets here
+/// \param message: the error message
+/// \param line: the line of the error, or -1 for none
+void jit::fail(const std::string &message, int line) {
+    out->messages.push_back(message);
+    mov_imm(rdi, reinterpret_cast<std::uintptr_t>(&out->messages.back()));
+    mov_imm32(rsi, (std::uint32_t) line);
+    call_fn(&jit::raise);
+}
+
+/// compares the flag of a num local with 0 and jumps if the condition
+/// holds
+/// \param slot: the num local
+/// \param cc: the condition
+/// \return the jump, to land
+std::size_t jit::test_flag(std::uint32_t slot, cond cc) {
+    // cmp byte [flag], 0
+    frame_op({0x80}, 7, flag(slot));
+    byte(0);
+    return jump(cc);
+}
+
+/// \param slot: a num local
+/// \param val: whether it is declared
+void jit::set_flag(std::uint32_t slot, std::uint8_t val) {
+    // mov byte [flag], val
+    frame_op({0xC6}, 0, flag(slot));
+    byte(val);
+}
+
+void jit::byte(std::uint8_t b) {
+    buf.push_back(b);
+}
+
+void jit::word(std::uint32_t w) {
+    for (int i = 0; i < 4; ++i)
+        byte((std::uint8_t) (w >> (8 * i)));
+}
+
+void jit::quad(std::uint64_t q) {
+    for (int i = 0; i < 8; ++i)
+        byte((std::uint8_t) (q >> (8 * i)));
+}
+
+/// emits an instruction on a register and a frame cell, [rbx + disp]
+/// \param opcode: the prefixes and opcode
+/// \param r: the register, or the opcode extension
+/// \param disp: the frame offset
+void jit::frame_op(std::initializer_list<std::uint8_t> opcode, std::uint8_t r, std::uint32_t disp) {
+    for (std::uint8_t b : opcode)
+        byte(b);
+    byte((std::uint8_t) (0x80 | (r & 7) << 3 | rbx));
+    word(disp);
+}
+
+void jit::load_reg(reg r, std::uint32_t disp) {
+    frame_op({0x48, 0x8B}, r, disp);
+}
+
+void jit::store_reg(reg r, std::uint32_t disp) {
+    frame_op({0x48, 0x89}, r, disp);
+}
+
+void jit::lea(reg r, std::uint32_t disp) {
+    frame_op({0x48, 0x8D}, r, disp);
+}
+
+void jit::load_sd(int xmm, std::uint32_t disp) {
+    frame_op({0xF2, 0x0F, 0x10}, (std::uint8_t) xmm, disp);
+}
+
+void jit::store_sd(int xmm, std::uint32_t disp) {
+    frame_op({0xF2, 0x0F, 0x11}, (std::uint8_t) xmm, disp);
+}
+
+void jit::mov_imm(reg r, std::uint64_t val) {
+    byte(0x48);
+    byte((std::uint8_t) (0xB8 + r));
+    quad(val);
+}
+
+void jit::mov_imm32(reg r, std::uint32_t val) {
+    byte((std::uint8_t) (0xB8 + r));
+    word(val);
+}
+
+void jit::mov_reg(reg dst, reg src) {
+    byte(0x48);
+    byte(0x89);
+    byte((std::uint8_t) (0xC0 | src << 3 | dst));
+}
+
+/// \param xmm: xmm0 or xmm1
+/// \param val: the num to load
+void jit::mov_double(int xmm, double val) {
+    std::uint64_t bits;
+    std::memcpy(&bits, &val, 8);
+    mov_imm(rax, bits);
+    // movq xmm, rax
+    for (std::uint8_t b : {0x66, 0x48, 0x0F, 0x6E})
+        byte(b);
+    byte((std::uint8_t) (0xC0 | xmm << 3));
+}
+
+/// emits a scalar double instruction on two registers
+/// \param op: the opcode, e.g. 0x58 for addsd
+void jit::sse(std::uint8_t op, int dst, int src) {
+    byte(0xF2);
+    byte(0x0F);
+    byte(op);
+    byte((std::uint8_t) (0xC0 | dst << 3 | src));
+}
+
+void jit::ucomisd(int a, int b) {
+    for (std::uint8_t c : {0x66, 0x0F, 0x2E})
+        byte(c);
+    byte((std::uint8_t) (0xC0 | a << 3 | b));
+}
+
+/// \param cc: the condition
+/// \param r: al or cl
+void jit::setcc(cond cc, reg r) {
+    byte(0x0F);
+    byte((std::uint8_t) (0x90 | cc));
+    byte((std::uint8_t) (0xC0 | r));
+}
+
+/// emits a jump whose target is set later
+/// \param cc: the condition, or c_always
+/// \return the offset of its displacement
+std::size_t jit::jump(cond cc) {
+    if (cc == c_always)
+        byte(0xE9);
+    else {
+        byte(0x0F);
+        byte((std::uint8_t) (0x80 | cc));
+    }
+    word(0);
+    return buf.size() - 4;
+}
+
+/// points a jump at the next instruction emitted
+/// \param at: the offset of its displacement
+void jit::land(std::size_t at) {
+    std::int32_t rel = (std::int32_t) (buf.size() - (at + 4));
+    std::memcpy(&buf[at], &rel, 4);
+}
+
+/// emits a jump to the code of an instruction
+/// \param cc: the condition, or c_always
+/// \param pc: the instruction
+void jit::jump_to(cond cc, std::uint32_t pc) {
+    jumps.emplace_back(jump(cc), pc);
+}
+
+object *jit::none() {
+    return new object();
+}
+
+/// \param val: a num arg of a call
+/// \return the arg in an object off the free list
+object *jit::arg(double val) {
+    object *obj = memory::acquire();
+    obj->type = o_num;
+    obj->store = val;
+    return obj;
+}
+
+/// \param val: a num returned by native code
+/// \return the num in an object off the free list
+object *jit::result(double val) {
+    object *obj = memory::acquire();
+    obj->type = o_num;
+    obj->store = val;
+    return obj;
+}
+
+/// puts the num args of a returned call back on the free list
+/// \param res: the value of the call
+/// \param args: the args
+/// \param spare: a bit for every arg created by arg
+/// \return the value of the call
+object *jit::returned(object *res, object **args, std::uint32_t spare) {
+    for (std::uint32_t i = 0; spare; ++i, spare >>= 1)
+        if (spare & 1)
+            memory::recycle(args[i]);
+    return res;
+}
+
+object *jit::str(std::uint32_t id) {
+    return runtime::str(symbol::str(id));
+}
+
+double jit::num_of(object *obj) {
+    return std::get<double>(obj->store);
+}
+
+void jit::set_num(object *obj, double val) {
+    obj->store = val;
+}
+
+bool jit::truth_of(object *obj) {
+    return runtime::truth(obj);
+}
+
+object *jit::negate(object *obj) {
+    return obj->_not();
+}
+
+object *jit::apply(std::uint32_t op, object *left, object *right) {
+    return runtime::binary(op, left, right);
+}
+
+/// runs an assignment to a num local through the object method of the
+/// operator, on a copy whose value is written back
+/// \param op: the assignment
+/// \param var: the value of the local
+/// \param right: the right operand
+/// \return the value of the assignment
+object *jit::update(std::uint32_t op, double *var, object *right) {
+    object *tmp = runtime::num(*var);
+    object *res = runtime::binary(op, tmp, right);
+    *var = std::get<double>(tmp->store);
+    return res;
+}
+
+/// calls a function from native code, as the VM does: the parameters
+/// are copies of the args, and the callee runs natively if it is hot
+/// \param code: the calling code
+/// \param callee: the function
+/// \param args: the args
+/// \param u: the symbol node of the call
+/// \return the value of the call
+::value jit::dispatch(const native *code, object *callee, object **args, std::uint32_t u) {
+    const ast &tree = *code->code->tree;
+    std::string key;
+    if (callee->def->table)
+        if (object *res = callee->def->table->find(args, callee->def->params.size(), key))
+            return ::value::of(res);
+    runtime::check_stack(tree.line(u));
+    std::size_t frame = memory::push(callee->body()->frame, callee->def->params.size());
+    for (int i = 0; i < callee->def->params.size(); ++i) {
+        object *param = memory::acquire();
+        param->assign(args[i]);
+        if (param->type != callee->def->params[i].type)
+            err("parameter types don't match", tree.line(tree.child(u, i)));
+        memory::local(i) = param;
+    }
+    ::value val;
+    if (options::engine == "vm")
+        val = vm::call(callee);
+    else if (hot(callee))
+        val = ::value::of(run(callee));
+    else
+        val = executor(callee->body(), callee).init();
+    memory::pop(frame, code->fn->def->params.size(), val.is_obj() ? val.obj() : nullptr);
+    // a memo table keeps its values as objects
+    if (callee->def->table) {
+        val = ::value::of(val.box());
+        callee->def->table->store(std::move(key), val.obj());
+    }
+    return val;
+}
+
+/// calls a function from native code, which takes its value as an
+/// object
+/// \param code: the calling code
+/// \param callee: the function
+/// \param args: the args
+/// \param u: the symbol node of the call
+/// \return the value of the call
+object *jit::invoke(const native *code, object *callee, object **args, std::uint32_t u) {
+    return dispatch(code, callee, args, u).box();
+}
+
+/// calls a function that returns a num from native code, and puts the
+/// num args back on the free list, as returned does. A num that native
+/// code returned is an object off the free list that nothing else
+/// refers to, which goes back on it once it is read
+/// \param code: the calling code
+/// \param callee: the function
+/// \param args: the args
+/// \param call: the symbol node of the call, and above it a bit for
+///              every arg created by arg
+/// \return the num the call returned
+double jit::invoke_num(const native *code, object *callee, object **args, std::uint64_t call) {
+    ::value val = dispatch(code, callee, args, (std::uint32_t) call);
+    returned(nullptr, args, (std::uint32_t) (call >> 32));
+    double res = val.number();
+    if (val.is_obj() && !callee->def->table)
+        memory::recycle(val.obj());
+    return res;
+}
+
+/// passes the args of a call in tail position to the parameters of the
+/// callee, as invoke does, in the memory frame of the function, which
+/// the callee takes over. The args may be locals of the frame, so they
+/// are copied before the frame is cleared
+/// \param code: the calling code
+/// \param callee: the function
+/// \param args: the args
+/// \param u: the symbol node of the call
+void jit::take_over(const native *code, object *callee, object **args, std::uint32_t u) {
+    const ast &tree = *code->code->tree;
+    for (int i = 0; i < callee->def->params.size(); ++i) {
+        object *param = memory::acquire();
+        param->assign(args[i]);
+        if (param->type != callee->def->params[i].type)
+            err("parameter types don't match", tree.line(tree.child(u, i)));
+        args[i] = param;
+    }
+    memory::reuse(callee->body()->frame, callee->def->params.size());
+    for (int i = 0; i < callee->def->params.size(); ++i)
+        memory::local(i) = args[i];
+    next = callee;
+}
+
+/// \param code: the running code
+/// \param u: the symbol node of a local that is not a num local
+/// \return the object of the local
+object *jit::local(const native *code, std::uint32_t u) {
+    const ast &tree = *code->code->tree;
+    object *obj = memory::find(tree[u].slot);
+    if (!obj)
+        err("symbol \"" + symbol::str(tree[u].val) + "\" is undefined", tree.line(u));
+    return obj;
+}
+
+/// declares a variable, as the VM does; a num local is declared in the
+/// native frame
+/// \param code: the running code
+/// \param u: the declaration node
+/// \param frame: the native frame
+void jit::declare(const native *code, std::uint32_t u, char *frame) {
+    const ast &tree = *code->code->tree;
+    std::uint32_t count = tree[u].count, slot = count ? tree[u + 1].slot : ast::no_slot;
+    bool plain = slot < code->plain.size() && code->plain[slot];
+    bool *flags = reinterpret_cast<bool *>(frame + code->flags);
+    // a type keyword without an identifier, e.g. `none`, is passed alone
+    // and rejected by the declaration
+    token decl[2] = {tree.val(u), count ? tree.val(u + 1) : token()};
+    bool defined = count && (plain ? flags[slot] : memory::find(slot) != nullptr);
+    object *obj = interpreter::declare_obj(token_span(decl, nullptr, count ? 2 : 1), defined);
+    if (plain) {
+        reinterpret_cast<double *>(frame + code->values)[slot] = std::get<double>(obj->store);
+        flags[slot] = true;
+    } else
+        memory::local(slot) = obj;
+}
+
+void jit::print(object *obj, bool newline) {
+    std::cout << obj->str();
+    if (newline)
+        std::cout << std::endl;
+}
+
+void jit::print_num(double val, bool newline) {
+    std::cout << runtime::num_str(val);
+    if (newline)
+        std::cout << std::endl;
+}
+
+void jit::print_bool(bool val, bool newline) {
+    std::cout << (val ? "true" : "false");
+    if (newline)
+        std::cout << std::endl;
+}
+
+/// checks a range arg, as object::is_int does
+/// \param val: the arg
+/// \param line: the line of the arg
+void jit::check_int(double val, int line) {
+    if (val != static_cast<int>(val))
+        err("range arg must be integers", line);
+}
+
+void jit::check_int_obj(object *obj, int line) {
+    if (!obj->is_int())
+        err("range arg must be integers", line);
+}
+
+/// \param message: the error message
+/// \param line: the line of the error, or -1 for none
+void jit::raise(const std::string *message, int line) {
+    if (line < 0)
+        runtime::fail(*message);
+    runtime::fail(*message, line);
+}
+
+/// reports the wrong operand count of an operation, as the VM does
+/// \param code: the running code
+/// \param u: the node of the operation
+void jit::arity(const native *code, std::uint32_t u) {
+    const ast &tree = *code->code->tree;
+    std::cout << tree[u].count << std::endl;
+    runtime::fail("incorrect number of children for operation \"" + symbol::str(tree[u].val) + "\"", tree.line(u));
+}
+
+object *jit::finish(object *fn, std::uint32_t flag, object *ret) {
+    return executor::leave(fn, (leave_flag) flag, ::value::of(ret)).obj();
+}
+
+/// fills a new native frame: every num local from the memory frame, and
+/// the for loop slots from the VM frame that moves over, if any; the
+/// frame is traced from here on
+/// \param code: the code entered
+/// \param frame: the native frame
+/// \param slots: the for loop slots of the VM frame, or nullptr
+void jit::enter(const native *code, char *frame, ::value *slots) {
+    // a call in tail position of the function itself enters its frame
+    // again
+    if (frames.empty() || frames.back().second != frame)
+        frames.emplace_back(code, frame);
+    double *values = reinterpret_cast<double *>(frame + code->values);
+    bool *flags = reinterpret_cast<bool *>(frame + code->flags);
+    for (std::uint32_t s = 0; s < code->plain.size(); ++s)
+        if (code->plain[s]) {
+            object *obj = memory::local(s);
+            flags[s] = obj != nullptr;
+            values[s] = obj ? std::get<double>(obj->store) : 0;
+        }
+    double *loops = reinterpret_cast<double *>(frame + code->loops);
+    for (std::uint32_t i = 0; i < code->code->slots; ++i)
+        loops[i] = slots && !slots[i].is_none() ? slots[i].number() : 0;
+}
+
+#else
+
+bool jit::compile(object *fn) {
+    fn->def->compiled = &rejected;
+    return false;
+}
+
+object *jit::run(object *fn) {
+    runtime::fail("the jit needs an x86-64 host");
+}
+
+object *jit::resume(object *fn, std::uint32_t pc, ::value *slots) {
+    runtime::fail("the jit needs an x86-64 host");
+}
+
+#endif
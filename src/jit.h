@@ -0,0 +1,314 @@
+/*
+ * jit.h contains:
+ *   - Declarations for native function bodies
+ *   - Declarations for the x86-64 template JIT
+ */
+
+#ifndef QI_INTERPRETER_JIT_H
+#define QI_INTERPRETER_JIT_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <initializer_list>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "ast.h"
+#include "bytecode.h"
+#include "checker.h"
+#include "executor.h"
+#include "gc.h"
+#include "heap.h"
+#include "interpreter.h"
+#include "memo.h"
+#include "memory.h"
+#include "object.h"
+#include "options.h"
+#include "runtime.h"
+#include "symbol.h"
+#include "token.h"
+#include "util.h"
+#include "vm.h"
+
+/// a function body compiled to x86-64 code. Its frame on the native
+/// stack holds every num local unboxed, with a byte for whether it is
+/// declared, the end and step of every for loop, a mask of the cells
+/// that hold objects, and the cells of the operand stack
+class native {
+public:
+    /// enters the code at an instruction: 0 for a call, or the head of a
+    /// loop for a VM frame that moves over, with the slots of its loops
+    using entry_point = object *(*)(std::uint32_t pc, ::value *slots);
+
+    object *fn;
+    bytecode *code;
+    entry_point entry;
+    // whether a local slot holds an unboxed num
+    std::vector<bool> plain;
+    // frame offsets of the num locals, of their flags, of the for loop
+    // slots, of the mask of object cells and of the operand stack cells
+    std::uint32_t values, flags, loops, live, cells;
+    // the messages of errors raised by the code, which never move
+    std::deque <std::string> messages;
+};
+
+/// the template JIT compiles the bytecode of a hot function to x86-64
+/// code, instruction by instruction, in an executable buffer. Calls and
+/// loop passes are counted per function; once they reach the threshold
+/// the function is compiled, and a VM frame in a hot loop moves over to
+/// the code at the head of the loop. A num local whose slot only ever
+/// holds a num lives unboxed in the native frame, and the compiler
+/// tracks what each cell of the operand stack holds, so that num
+/// operators, comparisons and for loops run without creating objects;
+/// everything else calls into the runtime. Bodies left to the tree
+/// walker are never compiled
+class jit {
+private:
+    /// how the compiler holds a value of the operand stack: an object,
+    /// a num or a bool in its cell, a num local read where it is used,
+    /// a num constant, or a none that is only created if it is used
+    enum kind : std::uint8_t {
+        k_obj,
+        k_num,
+        k_bool,
+        k_ref,
+        k_const,
+        k_none
+    };
+
+    struct value {
+        kind k;
+        std::uint32_t val;
+    };
+
+    /// the x86-64 registers, by their encoding
+    enum reg : std::uint8_t {
+        rax, rcx, rdx, rbx, rsp, rbp, rsi, rdi
+    };
+
+    /// the condition codes of jumps and sets
+    enum cond : std::uint8_t {
+        c_below = 0x2,
+        c_below_eq = 0x6,
+        c_above = 0x7,
+        c_above_eq = 0x3,
+        c_equal = 0x4,
+        c_not_equal = 0x5,
+        c_parity = 0xA,
+        c_no_parity = 0xB,
+        c_always = 0xFF
+    };
+
+    object *fn;
+    bytecode *code;
+    const ast &tree;
+    native *out;
+    std::vector <std::uint8_t> buf;
+    std::vector <value> stack;
+    std::uint32_t depth;
+    // the code offset of each jump target, and the jumps to patch
+    std::vector <std::int64_t> labels;
+    std::vector <std::pair<std::size_t, std::uint32_t>> jumps;
+    // the loop variable slot of each for loop, by its first slot
+    std::vector <std::uint32_t> loop_vars;
+
+    jit(object *_fn, bytecode *_code);
+
+    bool translate();
+
+    void call(std::uint32_t u);
+
+    object *tail_callee(std::uint32_t u) const;
+
+    void tail(std::uint32_t u);
+
+    void binary(std::uint32_t op, bool checked);
+
+    void method(std::uint32_t name, std::uint32_t u);
+
+    void leave(std::uint32_t flag);
+
+    void epilogue();
+
+    void roots();
+
+    void safe_point();
+
+    std::uint32_t cell(std::uint32_t p) const;
+
+    std::uint32_t var(std::uint32_t slot) const;
+
+    std::uint32_t flag(std::uint32_t slot) const;
+
+    std::uint32_t loop(std::uint32_t i) const;
+
+    void push(kind k, std::uint32_t val = 0);
+
+    void push_obj();
+
+    bool numeric(const value &v) const;
+
+    void box(std::uint32_t p);
+
+    void unbox(std::uint32_t p);
+
+    void load_num(std::uint32_t p, int xmm);
+
+    void truth(std::uint32_t p);
+
+    void arithmetic(std::uint32_t op);
+
+    void compare(std::uint32_t op);
+
+    void fail(const std::string &message, int line);
+
+    std::size_t test_flag(std::uint32_t slot, cond cc);
+
+    void set_flag(std::uint32_t slot, std::uint8_t val);
+
+    void byte(std::uint8_t b);
+
+    void word(std::uint32_t w);
+
+    void quad(std::uint64_t q);
+
+    void frame_op(std::initializer_list<std::uint8_t> opcode, std::uint8_t r, std::uint32_t disp);
+
+    void load_reg(reg r, std::uint32_t disp);
+
+    void store_reg(reg r, std::uint32_t disp);
+
+    void lea(reg r, std::uint32_t disp);
+
+    void load_sd(int xmm, std::uint32_t disp);
+
+    void store_sd(int xmm, std::uint32_t disp);
+
+    void mov_imm(reg r, std::uint64_t val);
+
+    void mov_imm32(reg r, std::uint32_t val);
+
+    void mov_reg(reg dst, reg src);
+
+    void mov_double(int xmm, double val);
+
+    void sse(std::uint8_t op, int dst, int src);
+
+    void ucomisd(int a, int b);
+
+    void setcc(cond cc, reg r);
+
+    /// emits a call of a function through rax
+    /// \param f: the function
+    template <typename F>
+    void call_fn(F f) {
+        mov_imm(rax, reinterpret_cast<std::uintptr_t>(f));
+        // call rax
+        byte(0xFF);
+        byte(0xD0);
+    }
+
+    std::size_t jump(cond cc);
+
+    void land(std::size_t at);
+
+    void jump_to(cond cc, std::uint32_t pc);
+
+    // called from the native code
+    static object *none();
+
+    static object *arg(double val);
+
+    static object *returned(object *res, object **args, std::uint32_t spare);
+
+    static object *str(std::uint32_t id);
+
+    static double num_of(object *obj);
+
+    static void set_num(object *obj, double val);
+
+    static bool truth_of(object *obj);
+
+    static object *negate(object *obj);
+
+    static object *apply(std::uint32_t op, object *left, object *right);
+
+    static object *update(std::uint32_t op, double *var, object *right);
+
+    static object *result(double val);
+
+    static ::value dispatch(const native *code, object *callee, object **args, std::uint32_t u);
+
+    static object *invoke(const native *code, object *callee, object **args, std::uint32_t u);
+
+    static double invoke_num(const native *code, object *callee, object **args, std::uint64_t call);
+
+    static void take_over(const native *code, object *callee, object **args, std::uint32_t u);
+
+    static object *local(const native *code, std::uint32_t u);
+
+    static void declare(const native *code, std::uint32_t u, char *frame);
+
+    static void print(object *obj, bool newline);
+
+    static void print_num(double val, bool newline);
+
+    static void print_bool(bool val, bool newline);
+
+    static void check_int(double val, int line);
+
+    static void check_int_obj(object *obj, int line);
+
+    [[noreturn]] static void raise(const std::string *message, int line);
+
+    [[noreturn]] static void arity(const native *code, std::uint32_t u);
+
+    static object *finish(object *fn, std::uint32_t flag, object *ret);
+
+    static void enter(const native *code, char *frame, ::value *slots);
+
+    static object *settle(object *ret);
+
+    // the function a call in tail position left to run, once native code
+    // returns nullptr
+    static object *next;
+
+public:
+    // the calls and loop passes after which a function is compiled, or
+    // 0 if nothing is
+    static std::uint32_t threshold;
+    static std::uint64_t compiled;
+    static native rejected;
+    // the native frames running, which the collector traces: at a call
+    // or a safe point, a frame holds objects in the cells of its mask
+    static std::vector<std::pair<const native *, char *>> frames;
+
+    static bool compile(object *fn);
+
+    static object *run(object *fn);
+
+    static object *resume(object *fn, std::uint32_t pc, ::value *slots);
+
+    /// counts a call or a loop pass of a function, and compiles it once
+    /// the count reaches the threshold
+    /// \param fn: the function
+    /// \return whether the function runs on native code
+    static bool hot(object *fn) {
+        if (!threshold)
+            return false;
+        if (!fn->def->compiled && ++fn->def->heat >= threshold)
+            compile(fn);
+        return fn->def->compiled && fn->def->compiled->entry;
+    }
+};
+
+#endif //QI_INTERPRETER_JIT_H
@@ -0,0 +1,181 @@
+/*
+ * keywords.h contains:
+ *   - Compile-time properties of the pre-assigned symbols
+ *   - Compile-time perfect hash from keyword strings to symbol ids
+ */
+
+#ifndef QI_INTERPRETER_KEYWORDS_H
+#define QI_INTERPRETER_KEYWORDS_H
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+#include "symbol.h"
+
+/// categories a pre-assigned symbol belongs to, as bit flags
+enum k_category : unsigned char {
+    k_none = 0,
+    k_builtin = 1,
+    k_control = 2,
+    k_var = 4,
+    k_method = 8
+};
+
+/// properties of a pre-assigned symbol; ops and pre only apply to
+/// builtins
+struct keyword {
+    std::string_view name;
+    signed char ops, pre;
+    unsigned char category;
+};
+
+// precedence of blocks and brackets, which are never split on
+constexpr signed char k_pre_block = 24;
+
+/// the pre-assigned symbols, in `s_id` order
+constexpr keyword keywords[s_count] = {
+        {"",         0, 0,           k_none},
+        {"GROUP",    0, 0,           k_none},
+        {"EOF",      0, 0,           k_none},
+        {"LB",       0, 0,           k_none},
+        {"+",        2, 5,           k_builtin},
+        {"-",        2, 5,           k_builtin},
+        {"*",        2, 6,           k_builtin},
+        {"**",       2, 7,           k_builtin},
+        {"/",        2, 6,           k_builtin},
+        {"//",       2, 6,           k_builtin},
+        {"==",       2, 3,           k_builtin},
+        {"!=",       2, 3,           k_builtin},
+        {"<",        2, 3,           k_builtin},
+        {"<=",       2, 3,           k_builtin},
+        {">",        2, 3,           k_builtin},
+        {">=",       2, 3,           k_builtin},
+        {"^",        2, 9,           k_builtin},
+        {"|",        2, 10,          k_builtin},
+        {"&",        2, 10,          k_builtin},
+        {">>",       2, 7,           k_builtin},
+        {"<<",       2, 7,           k_builtin},
+        {"%",        2, 6,           k_builtin},
+        {"=",        2, 1,           k_builtin},
+        {"-=",       2, 1,           k_builtin},
+        {"+=",       2, 1,           k_builtin},
+        {"*=",       2, 1,           k_builtin},
+        {"**=",      2, 1,           k_builtin},
+        {"/=",       2, 1,           k_builtin},
+        {"//=",      2, 1,           k_builtin},
+        {"%=",       2, 1,           k_builtin},
+        {">>=",      2, 1,           k_builtin},
+        {"<<=",      2, 1,           k_builtin},
+        {"&=",       2, 1,           k_builtin},
+        {"|=",       2, 1,           k_builtin},
+        {"^=",       1, 2,           k_builtin},
+        {",",        2, 2,           k_builtin},
+        {"and",      2, 11,          k_builtin},
+        {"not",      1, 4,           k_builtin},
+        {"or",       2, 12,          k_builtin},
+        {"if",       2, k_pre_block, k_builtin | k_control},
+        {"elsif",    2, k_pre_block, k_builtin | k_control},
+        {"else",     1, k_pre_block, k_builtin | k_control},
+        {"start",    0, k_pre_block, k_builtin},
+        {"end",      0, k_pre_block, k_builtin},
+        {"break",    0, k_pre_block, k_builtin},
+        {"continue", 0, k_pre_block, k_builtin},
+        {"while",    2, k_pre_block, k_builtin | k_control},
+        {"for",      2, k_pre_block, k_builtin | k_control},
+        {"of",       2, -1,          k_builtin},
+        {"in",       1, 0,           k_builtin},
+        {"out",      1, 0,           k_builtin},
+        {"outl",     1, 0,           k_builtin},
+        {"return",   1, 0,           k_builtin},
+        {"fn",       4, k_pre_block, k_builtin},
+        {"num",      1, 0,           k_builtin | k_var},
+        {"bool",     1, 0,           k_builtin | k_var},
+        {"str",      1, 0,           k_builtin | k_var},
+        {"arr",      1, 0,           k_builtin | k_var},
+        {"map",      1, 0,           k_builtin | k_var},
+        {"set",      1, 0,           k_builtin | k_var},
+        {"queue",    1, 0,           k_builtin | k_var},
+        {"stack",    1, 0,           k_builtin | k_var},
+        {"(",        0, k_pre_block, k_builtin},
+        {")",        0, k_pre_block, k_builtin},
+        {".",        2, 8,           k_builtin},
+        {"none",     0, 0,           k_var},
+        {"floor",    0, 0,           k_method},
+        {"ceil",     0, 0,           k_method},
+        {"round",    0, 0,           k_method},
+        {"rand",     0, 0,           k_method},
+        {"main",     0, 0,           k_none},
+        {"range",    0, 0,           k_none},
+        {"push",     0, 0,           k_none},
+        {"pop",      0, 0,           k_none},
+        {"len",      0, 0,           k_none},
+        {"empty",    0, 0,           k_none},
+        {"find",     0, 0,           k_none},
+        {"reverse",  0, 0,           k_none},
+        {"fill",     0, 0,           k_none},
+        {"at",       0, 0,           k_none},
+        {"next",     0, 0,           k_none},
+        {"last",     0, 0,           k_none},
+        {"sub",      0, 0,           k_none},
+        {"clear",    0, 0,           k_none},
+        {"sort",     0, 0,           k_none},
+        {"0",        0, 0,           k_none}
+};
+
+/// perfect hash over the keyword names: a seed is searched for at
+/// compile time so that every keyword lands in its own slot, and a
+/// lookup is one hash, one table load and one string compare
+class keyword_hash {
+public:
+    static constexpr std::size_t size = 1024;
+
+    std::uint32_t seed;
+    std::array<unsigned char, size> slots;
+
+    /// seeded FNV-1a, folded to a table slot
+    /// \param seed: the hash seed
+    /// \param s: the string to hash
+    /// \return the slot of s
+    static constexpr std::size_t slot(std::uint32_t seed, std::string_view s) {
+        std::uint32_t h = 2166136261u ^ seed;
+        for (char c : s)
+            h = (h ^ (unsigned char) c) * 16777619u;
+        return (h ^ (h >> 15)) & (size - 1);
+    }
+
+    /// searches for the first seed without collisions
+    /// \return the generated table
+    static constexpr keyword_hash generate() {
+        keyword_hash table{};
+        for (std::uint32_t seed = 1;; ++seed) {
+            bool collision = false;
+            table.seed = seed;
+            for (unsigned char &id : table.slots)
+                id = (unsigned char) s_count;
+            for (std::uint32_t id = 0; id < s_count && !collision; ++id) {
+                unsigned char &target = table.slots[slot(seed, keywords[id].name)];
+                collision = target != s_count;
+                target = (unsigned char) id;
+            }
+            if (!collision)
+                return table;
+        }
+    }
+
+    /// \param s: a scanned word or operator
+    /// \return the pre-assigned symbol id of s, or s_count if s is not
+    ///         a pre-assigned symbol
+    constexpr std::uint32_t find(std::string_view s) const {
+        std::uint32_t id = slots[slot(seed, s)];
+        return id != s_count && keywords[id].name == s ? id : s_count;
+    }
+};
+
+constexpr keyword_hash keyword_table = keyword_hash::generate();
+
+static_assert(s_count < 256, "keyword ids must fit in a table slot");
+static_assert(keyword_table.find("elsif") == s_elsif && keyword_table.find(">>=") == s_shift_right_eq,
+              "keyword table must map names to their ids");
+
+#endif //QI_INTERPRETER_KEYWORDS_H
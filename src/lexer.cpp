@@ -1,88 +1,128 @@
 /*
  * lexer.cpp contains:
+ *   - Definitions for the character class tables
  *   - Definitions for the lexer
- *   - Definitions for the tokenizing regex
  */
 
 #include "lexer.h"
 
-const std::string lexer::r_num = "[0-9.]",
-        lexer::r_lb = "\n",
-        lexer::r_comment = "$",
-        lexer::r_symbol = "[a-zA-Z_0-9]",
-        lexer::r_op = "\\+|-|\\*|\\/|=|>|<|>=|<=|&|\\||%|!|\\^|\\.|\\,";
+/// builds the table that decides which scanner starts at a character
+/// \return the character class of every byte
+static constexpr std::array<unsigned char, 256> gen_classes() {
+    std::array<unsigned char, 256> table{};
+    for (int c = 'a'; c <= 'z'; ++c)
+        table[c] = c_word;
+    for (int c = 'A'; c <= 'Z'; ++c)
+        table[c] = c_word;
+    for (int c = '0'; c <= '9'; ++c)
+        table[c] = c_num;
+    for (char c : std::string_view("+-*/=><&|%!^,"))
+        table[(unsigned char) c] = c_op;
+    table['_'] = c_word;
+    table['.'] = c_num;
+    table[' '] = c_space;
+    table['"'] = c_quote;
+    table['\n'] = c_lb;
+    table['$'] = c_comment;
+    table['('] = c_paren;
+    table[')'] = c_paren;
+    table[0] = c_end;
+    table[(unsigned char) EOF] = c_eof;
+    return table;
+}
+
+/// builds the table of character sets a token can be extended with
+/// \return the set flags of every byte
+static constexpr std::array<unsigned char, 256> gen_flags() {
+    std::array<unsigned char, 256> table{};
+    for (int c = 'a'; c <= 'z'; ++c)
+        table[c] |= f_symbol;
+    for (int c = 'A'; c <= 'Z'; ++c)
+        table[c] |= f_symbol;
+    for (int c = '0'; c <= '9'; ++c)
+        table[c] |= f_num | f_symbol;
+    for (char c : std::string_view("+-*/=><&|%!^.,"))
+        table[(unsigned char) c] |= f_op;
+    table['_'] |= f_symbol;
+    table['.'] |= f_num;
+    return table;
+}
+
+const std::array<unsigned char, 256> lexer::classes = gen_classes(),
+        lexer::flags = gen_flags();
 
 /// constructs the lexer
 /// \param _stream: the character stream
 lexer::lexer(fstream _stream) {
     line = 1;
     stream = _stream;
+    src = stream.view();
 }
 
-/// checks if the given character matches the given regular
-/// expression and returns true accordingly
-/// \param c: the character to check
-/// \param expr: the regex definition
-/// \return whether c can be matched by expr
-bool lexer::matches(const char &c, const std::string &expr) const {
-    std::string target;
-    std::regex reg_expr(expr);
-    target.push_back(c);
-    return std::regex_match(target, reg_expr);
+/// reads a char of the framed stream: the file, then EOF, then 0
+/// \param i: the index into the file
+/// \return the char at i
+char lexer::at(std::size_t i) const {
+    return i < src.size() ? src[i] : (i == src.size() ? (char) EOF : 0);
 }
 
-/// scans a stream while it matches the given regular expression
-/// \param expr: the regex definition
-/// \return scanned character set
-std::string lexer::scan_regex(const std::string &expr) {
-    std::string ret;
-    ret.push_back(stream.curr());
-    while (matches(stream.next(), expr)) {
-        ret.push_back(stream.next());
-        stream.move();
-    }
-    return ret;
+/// \param c: a character
+/// \return the character class of c
+c_class lexer::kind(char c) {
+    return (c_class) classes[(unsigned char) c];
+}
+
+/// \param c: a character
+/// \param flag: a character set
+/// \return whether c belongs to the character set
+bool lexer::has(char c, c_flag flag) {
+    return flags[(unsigned char) c] & flag;
+}
+
+/// adds a scanned word as a builtin token if it is a builtin keyword,
+/// and as a symbol token otherwise
+/// \param tokens: the token sequence
+/// \param val: the scanned word
+void lexer::add_word(std::vector <token> &tokens, std::string_view val) const {
+    std::uint32_t id = keyword_table.find(val);
+    if (token::is_builtin(id))
+        tokens.emplace_back(id, line, t_builtin, token::arity(id));
+    else
+        tokens.emplace_back(id != s_count ? id : symbol::intern(val), line, t_symbol);
 }
 
 /// scans an entire string, adding everything to the string until the
 /// string delimiter character is reached
+/// \param i: the index of the opening delimiter; left at the closing
+///           delimiter
 /// \param delim: the string delimiter character
 /// \return: the scanned string
-std::string lexer::scan_str(const char &delim) {
+std::string lexer::scan_str(std::size_t &i, const char &delim) {
     std::string ret;
-    while (stream.next() != 0) {
-        char prev = stream.curr();
-        stream.move();
+    while (at(i + 1) != 0) {
+        char prev = at(i), curr = at(++i);
         // allow escaped delimeters to be part of the string
-        if (stream.curr() == delim && prev != '\\')
+        if (curr == delim && prev != '\\')
             return ret;
-        else if (stream.curr() == delim) {
+        else if (curr == delim) {
             ret.pop_back();
-            ret.push_back(stream.curr());
-        } else if (prev == '\\' && stream.curr() == 'n') {
+            ret.push_back(curr);
+        } else if (prev == '\\' && curr == 'n') {
             ret.pop_back();
             ret.push_back('\n');
-        } else ret.push_back(stream.curr());
+        } else ret.push_back(curr);
     }
     err("unclosed string", line);
     return ret;
 }
 
-/// scans linebreaks and increases line number for association with
-/// the tokens being created
-void lexer::scan_lb() {
-    while (matches(stream.next(), r_lb)) {
-        ++line;
-        stream.move();
-    }
-}
-
 /// reads until the end of the line if a comment start character is
 /// seen, ignoring all characters
-void lexer::scan_comment() {
-    while (stream.next() != 0) {
-        stream.move();
-        if (matches(stream.curr(), r_lb)) {
+/// \param i: the index of the comment character; left at the end of
+///           the line
+void lexer::scan_comment(std::size_t &i) {
+    while (at(i + 1) != 0) {
+        if (at(++i) == '\n') {
             ++line;
             return;
         }
@@ -93,41 +133,62 @@ void lexer::scan_comment() {
 /// \return a resultant vector of tokens
 std::vector <token> lexer::tokenize() {
     std::vector <token> tokens;
-    while (stream.next()) {
-        stream.move();
-        char curr = stream.curr();
-        if (curr == EOF)
-            tokens.emplace_back("EOF", line, t_eof);
-        else if (curr == ' ')
-            continue;
-        else if (curr == '"')
-            tokens.emplace_back(scan_str(), line, t_str);
-        else if (matches(curr, r_num))
-            tokens.emplace_back(scan_regex(r_num), line, t_num);
-        else if (matches(curr, r_lb)) {
-            ++line;
-            scan_lb();
-            tokens.emplace_back("LB", line, t_lb);
-        } else if (curr == r_comment.front())
-            scan_comment();
-        else if (matches(curr, r_symbol)) {
-            std::string val = scan_regex(r_symbol);
-            if (token::builtins.find(val) != token::builtins.end())
-                tokens.emplace_back(val, line, t_builtin, token::builtins[val].first);
-            else
-                tokens.emplace_back(val, line, t_symbol);
-        } else if (curr == '(' || curr == ')') {
-            std::string val;
-            val.push_back(curr);
-            tokens.emplace_back(val, line, t_builtin, token::builtins[val].first);
-        } else if (matches(curr, r_op)) {
-            std::string val = scan_regex(r_op);
-            if (token::builtins.find(val) != token::builtins.end())
-                tokens.emplace_back(val, line, t_builtin, token::builtins[val].first);
-            else
-                err("unrecognized operator", line);
-        } else {
-            err("unrecognized symbol", line);
+    for (std::size_t i = 0; kind(at(i)) != c_end; ++i) {
+        std::size_t start = i;
+        switch (kind(at(i))) {
+            case c_eof: {
+                tokens.emplace_back(s_eof, line, t_eof);
+                break;
+            }
+            case c_space: {
+                break;
+            }
+            case c_quote: {
+                tokens.emplace_back(symbol::intern(scan_str(i)), line, t_str);
+                break;
+            }
+            case c_num: {
+                while (has(at(i + 1), f_num))
+                    ++i;
+                tokens.emplace_back(symbol::intern(src.substr(start, i - start + 1)), line, t_num);
+                break;
+            }
+            case c_lb: {
+                ++line;
+                while (at(i + 1) == '\n')
+                    ++line, ++i;
+                tokens.emplace_back(s_lb, line, t_lb);
+                break;
+            }
+            case c_comment: {
+                scan_comment(i);
+                break;
+            }
+            case c_word: {
+                while (has(at(i + 1), f_symbol))
+                    ++i;
+                add_word(tokens, src.substr(start, i - start + 1));
+                break;
+            }
+            case c_paren: {
+                std::uint32_t id = at(i) == '(' ? s_lparen : s_rparen;
+                tokens.emplace_back(id, line, t_builtin, token::arity(id));
+                break;
+            }
+            case c_op: {
+                while (has(at(i + 1), f_op))
+                    ++i;
+                std::uint32_t id = keyword_table.find(src.substr(start, i - start + 1));
+                if (token::is_builtin(id))
+                    tokens.emplace_back(id, line, t_builtin, token::arity(id));
+                else
+                    err("unrecognized operator", line);
+                break;
+            }
+            default: {
+                err("unrecognized symbol", line);
+                break;
+            }
         }
     }
     return tokens;
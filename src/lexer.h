@@ -1,40 +1,71 @@
 /*
  * lexer.h contains:
+ *   - Character classes for the lexer
  *   - Declarations for the lexer
  */
 
 #ifndef QI_INTERPRETER_LEXER_H
 #define QI_INTERPRETER_LEXER_H
 
+#include <array>
 #include <iostream>
-#include <regex>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "fstream.h"
+#include "keywords.h"
 #include "token.h"
 #include "util.h"
 
-/// reads in a stream of characters and parses the characters into
-/// pre-defined tokens
+/// the class of a character decides which scanner handles a token
+/// that starts with it
+enum c_class : unsigned char {
+    c_invalid,
+    c_end,
+    c_eof,
+    c_space,
+    c_quote,
+    c_num,
+    c_lb,
+    c_comment,
+    c_word,
+    c_paren,
+    c_op
+};
+
+/// character set flags, used while a scanner extends a token
+enum c_flag : unsigned char {
+    f_num = 1,
+    f_symbol = 2,
+    f_op = 4
+};
+
+/// reads in the source text and splits it into pre-defined tokens
+/// with a table-driven scanner: every character is classified once
+/// through a 256-entry table instead of being matched against a
+/// regular expression
 class lexer {
 private:
     fstream stream;
+    std::string_view src;
     int line;
-    static const std::string r_num, r_lb, r_comment, r_symbol, r_op;
+    static const std::array<unsigned char, 256> classes, flags;
 
-public:
-    explicit lexer(fstream _stream);
+    char at(std::size_t i) const;
+
+    static c_class kind(char c);
 
-    bool matches(const char &c, const std::string &expr) const;
+    static bool has(char c, c_flag flag);
 
-    std::string scan_regex(const std::string &expr);
+    void add_word(std::vector <token> &tokens, std::string_view val) const;
 
-    std::string scan_str(const char &delim = '"');
+    std::string scan_str(std::size_t &i, const char &delim = '"');
 
-    void scan_lb();
+    void scan_comment(std::size_t &i);
 
-    void scan_comment();
+public:
+    explicit lexer(fstream _stream);
 
     std::vector <token> tokenize();
 };
@@ -1,25 +1,58 @@
 /*
  * main.cpp contains:
  *   - Arg parser
- *   - Static initialization
  *   - File stream, lexing and the runtime
+ *   - Loading and saving the program cache
+ *   - Translating the program to C++
  *   - Starting program execution
  */
 
 #include "main.h"
 
 int main(int argc, char *argv[]) {
-    // validate arg count
-    if (argc != 2)
-        err("invalid arg count");
-    token::init();
+    // validate args
+    options::parse(argc, argv);
 
-    fstream stream((std::string(argv[1])));
-    lexer tokenizer(stream);
-    std::vector <token> tokens = tokenizer.tokenize();
+    fstream stream(options::file_name);
+    // an unchanged program starts from its cache, without lexing or
+    // parsing
+    std::uint64_t key = 0;
+    std::unique_ptr <interpreter> runtime;
+    if (options::cache && !options::dump_tokens) {
+        key = program_cache::hash(stream.view());
+        runtime = program_cache::load(key, stream.view().size());
+    }
 
-    interpreter runtime(tokens);
-    runtime.execute();
+    if (!runtime) {
+        std::vector <token> tokens;
+        if (options::lexer == "regex")
+            tokens = regex_lexer(stream).tokenize();
+        else
+            tokens = lexer(stream).tokenize();
+
+        // print the token stream instead of running the program
+        if (options::dump_tokens) {
+            for (const token &t : tokens)
+                std::cout << t.str() << "\n";
+            return 0;
+        }
+
+        runtime = std::make_unique<interpreter>(std::move(tokens));
+        if (options::cache)
+            program_cache::save(*runtime, key, stream.view().size());
+    }
+
+    // print the syntax trees or bytecode instead of running the program
+    if (options::dump_ast || options::dump_bytecode) {
+        runtime->print();
+        return 0;
+    }
+    // print the program as C++ instead of running it
+    if (options::emit_cpp) {
+        emitter::emit(*runtime);
+        return 0;
+    }
+    runtime->execute();
 
     return 0;
 }
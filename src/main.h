@@ -2,15 +2,22 @@
 #define QI_INTERPRETER_MAIN_H
 
 #include <iostream>
+#include <memory>
 #include <vector>
 
+#include "ast.h"
 #include "ast_node.h"
+#include "cache.h"
+#include "emitter.h"
 #include "fstream.h"
 #include "interpreter.h"
 #include "lexer.h"
 #include "memory.h"
 #include "object.h"
+#include "options.h"
+#include "regex_lexer.h"
 #include "token.h"
 #include "util.h"
+#include "vm.h"
 
 #endif //QI_INTERPRETER_MAIN_H
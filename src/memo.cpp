@@ -0,0 +1,178 @@
+/*
+ * memo.cpp contains:
+ *   - Definitions for the memo tables of pure functions
+ *   - The purity analysis of function bodies
+ */
+
+#include "memo.h"
+
+std::vector<memo *> memo::tables;
+
+/// creates the empty memo table of a function
+/// \param _name: the symbol of the function, for its stats
+memo::memo(std::uint32_t _name) : name(_name), hits(0), misses(0) {
+    tables.push_back(this);
+}
+
+/// looks up the value of a call: the key holds the type and the value of
+/// every arg, with nums by their bits
+/// \param args: the args of the call
+/// \param count: the number of args
+/// \param key: set to the key of the call, to store its value under
+/// \return a copy of the value of an earlier call with the same args, or
+///         nullptr if there was none
+object *memo::find(object **args, std::size_t count, std::string &key) {
+    for (std::size_t i = 0; i < count; ++i)
+        append(key, value::of(args[i]));
+    return lookup(key);
+}
+
+/// looks up the value of a call whose args are values, as find does
+/// \param args: the args of the call
+/// \param count: the number of args
+/// \param key: set to the key of the call, to store its value under
+/// \return a copy of the value of an earlier call, or nullptr
+object *memo::find(const value *args, std::size_t count, std::string &key) {
+    for (std::size_t i = 0; i < count; ++i)
+        append(key, args[i]);
+    return lookup(key);
+}
+
+/// adds an arg to the key of a call
+/// \param key: the key
+/// \param arg: the arg
+void memo::append(std::string &key, value arg) {
+    o_type type = arg.type();
+    key += (char) type;
+    if (type == o_num) {
+        double val = arg.number();
+        key.append((const char *) &val, sizeof(val));
+    } else if (type == o_bool)
+        key += (char) arg.boolean();
+    else if (type == o_str) {
+        const std::string &val = std::get<std::string>(arg.obj()->store);
+        std::uint32_t size = (std::uint32_t) val.size();
+        key.append((const char *) &size, sizeof(size));
+        key += val;
+    }
+}
+
+/// \param key: the key of a call
+/// \return a copy of the value kept under the key, or nullptr
+object *memo::lookup(const std::string &key) {
+    auto it = values.find(key);
+    if (it == values.end()) {
+        ++misses;
+        return nullptr;
+    }
+    ++hits;
+    order.splice(order.begin(), order, it->second.second);
+    object *ret = new object(it->second.first->type);
+    ret->assign(it->second.first);
+    return ret;
+}
+
+/// keeps the value of a call, and drops the least recently used call
+/// once the table is over its size
+/// \param key: the key find set
+/// \param val: the value of the call
+void memo::store(std::string &&key, object *val) {
+    object *copy = new object(val->type);
+    copy->assign(val);
+    auto [it, added] = values.emplace(std::move(key), std::make_pair(copy, order.end()));
+    if (!added) {
+        // a call reached itself with the same args, and returned first
+        delete it->second.first;
+        it->second.first = copy;
+        return;
+    }
+    order.push_front(&it->first);
+    it->second.second = order.begin();
+    if (values.size() > (std::size_t) options::memo_size) {
+        auto last = values.find(*order.back());
+        delete last->second.first;
+        order.pop_back();
+        values.erase(last);
+    }
+}
+
+/// \param fn: a function
+/// \return whether it takes and returns only nums, strs and bools, whose
+///         values key its calls
+bool memo::scalar(object *fn) {
+    auto is_scalar = [](o_type t) {
+        return t == o_num || t == o_str || t == o_bool;
+    };
+    if (!is_scalar(fn->def->returns))
+        return false;
+    for (const f_param &param : fn->def->params)
+        if (!is_scalar(param.type))
+            return false;
+    return true;
+}
+
+/// finds which functions only compute their values from their args: a
+/// body that never reads input, prints, reads or writes a global or
+/// calls `rand`, and only calls pure functions. Every function is taken
+/// to be pure unless its own body is not, and a function that is not
+/// makes every function that calls it impure, until nothing changes;
+/// functions that call each other are so pure or impure together
+/// \param functions: the symbols of the functions
+/// \return whether each function is pure
+std::unordered_map<object *, bool> memo::pure(const std::vector<std::uint32_t> &functions) {
+    std::unordered_map<object *, bool> known;
+    // the functions that call each function, and the impure functions
+    // whose callers are left to mark
+    std::unordered_map<object *, std::vector<object *>> callers;
+    std::vector<object *> impure;
+    for (std::uint32_t id : functions) {
+        object *fn = memory::get(id);
+        const ast *tree = fn->def->body;
+        bool result = tree && tree->bound;
+        for (std::uint32_t u = 0; result && u < tree->nodes.size(); ++u) {
+            const ast::node &n = (*tree)[u];
+            if (n.op == n_in || n.op == n_out || n.op == n_outl || n.op == n_rand)
+                result = false;
+            else if (n.op == n_symbol && n.slot != ast::no_slot && n.slot >= ast::global_slot) {
+                object *obj = memory::find(n.slot);
+                if (obj && obj->type == o_fn)
+                    callers[obj].push_back(fn);
+                else
+                    result = false;
+            }
+        }
+        known[fn] = result;
+        if (!result)
+            impure.push_back(fn);
+    }
+    while (!impure.empty()) {
+        object *fn = impure.back();
+        impure.pop_back();
+        for (object *caller : callers[fn])
+            if (known[caller]) {
+                known[caller] = false;
+                impure.push_back(caller);
+            }
+    }
+    return known;
+}
+
+/// gives every pure function that takes and returns scalars a memo
+/// table; bodies that are not bound yet, e.g. with `--lazy`, are never
+/// taken to be pure
+/// \param functions: the symbols of the functions
+void memo::analyze(const std::vector<std::uint32_t> &functions) {
+    std::unordered_map<object *, bool> known = pure(functions);
+    for (std::uint32_t id : functions) {
+        object *fn = memory::get(id);
+        if (!fn->def->table && scalar(fn) && known[fn])
+            fn->def->table = new memo(id);
+    }
+}
+
+/// prints the hits, misses and size of every memo table, on stderr
+void memo::report() {
+    for (const memo *table : tables)
+        std::cerr << "memo: " << symbol::str(table->name) << " " << table->hits << " hits, " << table->misses
+                  << " misses, " << table->values.size() << " calls kept" << std::endl;
+}
@@ -0,0 +1,68 @@
+/*
+ * memo.h contains:
+ *   - Declarations for the memo tables of pure functions
+ */
+
+#ifndef QI_INTERPRETER_MEMO_H
+#define QI_INTERPRETER_MEMO_H
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "ast.h"
+#include "memory.h"
+#include "object.h"
+#include "options.h"
+#include "symbol.h"
+#include "util.h"
+#include "value.h"
+
+/// the memo table of a function keeps the values of its calls, keyed on
+/// the values of their args, so that a call with the args of an earlier
+/// call returns its value without running the body. A function is
+/// memoized if its declaration is marked `memo`, or with `--memo` if it
+/// is pure: it takes and returns scalars, never reads input, prints,
+/// reads a global or calls `rand`, and only calls pure functions. The
+/// table keeps the most recently used calls, up to `--memo-size`
+class memo {
+private:
+    friend class gc;
+
+    // the keys, from the most to the least recently used
+    std::list<const std::string *> order;
+    std::unordered_map<std::string, std::pair<object *, std::list<const std::string *>::iterator>> values;
+
+    static std::vector<memo *> tables;
+
+    static std::unordered_map<object *, bool> pure(const std::vector<std::uint32_t> &functions);
+
+    static void append(std::string &key, value arg);
+
+    object *lookup(const std::string &key);
+
+public:
+    std::uint32_t name;
+    std::uint64_t hits, misses;
+
+    explicit memo(std::uint32_t _name);
+
+    object *find(object **args, std::size_t count, std::string &key);
+
+    object *find(const value *args, std::size_t count, std::string &key);
+
+    void store(std::string &&key, object *val);
+
+    static bool scalar(object *fn);
+
+    static void analyze(const std::vector<std::uint32_t> &functions);
+
+    static void report();
+};
+
+#endif //QI_INTERPRETER_MEMO_H
@@ -1,84 +1,122 @@
 /*
  * memory.cpp contains:
  *   - Definitions for the memory class
- *   - Global memory scope definition
- *   - Memory stack definition
+ *   - Global slots and the frame stack
  */
 
 #include "memory.h"
 
-memory *memory::global = new memory();
-std::stack<memory *> memory::stack = std::stack<memory *>();
+std::unordered_map<std::uint32_t, std::uint32_t> memory::table;
+std::vector<object *> memory::globals;
+std::vector<object *> memory::frames;
+std::size_t memory::base = 0;
+std::vector<object *> memory::spare;
+std::size_t memory::params = 0;
 
-/// checks if a symbol is defined in memory
-/// \param id: the symbol name
-/// \return whether a symbol exists in memory
-bool memory::has(std::string id) {
-    return (memory::global->table.find(id) != memory::global->table.end()) ||
-           (!memory::stack.empty() && memory::stack.top()->table.find(id) != memory::stack.top()->table.end());
+/// checks if a symbol is defined as a global
+/// \param id: the symbol id
+/// \return whether a global of the symbol exists
+bool memory::has(std::uint32_t id) {
+    return memory::table.find(id) != memory::table.end();
 }
 
 /// check whether a symbol name is valid and can be added to the
-/// memory without causing any naming collisions
-/// \param id: the symbol name
-/// \return whether this symbol name can be added to memory
-bool memory::valid(std::string id) {
-    return !has(id) && id != "main" &&
-           token::builtins.find(id) == token::builtins.end() &&
-           token::vars.find(id) == token::vars.end() &&
-           token::control.find(id) == token::control.end() &&
-           token::methods.find(id) == token::methods.end();
+/// memory without colliding with a global or a keyword
+/// \param id: the symbol id
+/// \return whether this symbol name can be declared
+bool memory::valid(std::uint32_t id) {
+    return !has(id) && id != s_main &&
+           !token::is(id, (k_category) (k_builtin | k_control | k_var | k_method));
 }
 
-/// add a symbol and the respective object to memory
-/// \param id: the symbol name
+/// add a global and its object to memory, in the next global slot
+/// \param id: the symbol id
 /// \param obj: the object
-/// \param to_global: whether this should be to the global memory
-void memory::add(std::string id, object *obj, bool to_global) {
-    if (to_global)
-        memory::global->table[id] = obj;
-    else {
-        if (memory::stack.empty())
-            err("no memory scope on the stack");
-        memory::stack.top()->table[id] = obj;
-    }
-}
-
-/// removes a symbol from the memory
-/// \param id: the symbol name
-void memory::remove(std::string id) {
-    if (memory::stack.top()->table.find(id) == memory::stack.top()->table.end())
-        err("tried removing non-existing variable");
-    memory::stack.top()->table.erase(id);
+void memory::add(std::uint32_t id, object *obj) {
+    auto [it, added] = memory::table.emplace(id, (std::uint32_t) memory::globals.size());
+    if (added)
+        memory::globals.push_back(obj);
+    else
+        memory::globals[it->second] = obj;
 }
 
-/// get the object mapped to the symbol name
-/// \param id: the symbol name
+/// get the object of a global
+/// \param id: the symbol id
 /// \return the mapped object
-object *memory::get(std::string id) {
-    if (memory::global->table.find(id) != memory::global->table.end())
-        return memory::global->table[id];
-    else if (!memory::stack.empty() && memory::stack.top()->table.find(id) != memory::stack.top()->table.end())
-        return memory::stack.top()->table[id];
-    else {
+object *memory::get(std::uint32_t id) {
+    auto it = memory::table.find(id);
+    if (it == memory::table.end()) {
         err("obj does not exist in memory");
         return (new object());
     }
+    return memory::globals[it->second];
 }
 
-/// pushes a new memory stack
-void memory::push() {
-    memory::stack.push(new memory());
+/// \param id: the symbol id
+/// \return the slot of the global of the symbol, or no slot
+std::uint32_t memory::slot(std::uint32_t id) {
+    auto it = memory::table.find(id);
+    return it == memory::table.end() ? ast::no_slot : ast::global_slot + it->second;
 }
 
-/// pops the last memory stack
-void memory::pop() {
-    if (memory::stack.empty())
-        err("attempted to pop empty memory stack");
-    memory *top = memory::stack.top();
-    memory::stack.pop();
-    delete top;
+/// removes every global and frame
+void memory::clear() {
+    memory::table.clear();
+    memory::globals.clear();
+    memory::frames.clear();
+    memory::spare.clear();
+    memory::base = 0;
+    memory::params = 0;
 }
 
-/// empty constructor for memory objects
-memory::memory() {}
+/// pushes the frame of a call, with every slot undeclared
+/// \param size: the number of slots of the function
+/// \param count: the number of parameters of the function
+/// \return the frame of the caller, to pop back to
+std::size_t memory::push(std::uint32_t size, std::size_t count) {
+    std::size_t prev = memory::base;
+    memory::base = memory::frames.size();
+    memory::frames.resize(memory::base + size, nullptr);
+    memory::params = count;
+    return prev;
+}
+
+/// pops the frame of the last call, whose parameter objects are kept
+/// for the next calls
+/// \param prev: the frame of the caller
+/// \param count: the number of parameters of the caller
+/// \param ret: the value of the call, which is kept with the caller
+void memory::pop(std::size_t prev, std::size_t count, const object *ret) {
+    release(ret);
+    memory::frames.resize(memory::base);
+    memory::base = prev;
+    memory::params = count;
+}
+
+/// turns the frame of the last call into the frame of a call in tail
+/// position, with every slot undeclared; the caller stays the same, and
+/// the parameter objects of the frame are kept for the next calls
+/// \param size: the number of slots of the function called
+/// \param count: the number of parameters of the function called
+void memory::reuse(std::uint32_t size, std::size_t count) {
+    release(nullptr);
+    memory::frames.resize(memory::base);
+    memory::frames.resize(memory::base + size, nullptr);
+    memory::params = count;
+}
+
+/// puts the parameter objects of the last frame on the free list. Every
+/// object in a frame belongs to it alone: an arg is copied into its
+/// parameter, and whatever keeps a value, e.g. a container, a variable
+/// or a `return`, keeps a copy of it. The only object that outlives the
+/// frame is the value of a body that ends in an expression, which is the
+/// value of the call
+/// \param ret: the value of the call, or nullptr
+void memory::release(const object *ret) {
+    std::size_t end = std::min(memory::base + memory::params, memory::frames.size());
+    for (std::size_t i = memory::base; i < end; ++i) {
+        object *obj = memory::frames[i];
+        if (obj && obj != ret && obj->type != o_fn)
+            recycle(obj);
+    }
+}
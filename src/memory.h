@@ -6,38 +6,88 @@
 #ifndef QI_INTERPRETER_MEMORY_H
 #define QI_INTERPRETER_MEMORY_H
 
+#include <algorithm>
+#include <cstdint>
 #include <string>
-#include <stack>
 #include <unordered_map>
+#include <vector>
 
+#include "ast.h"
 #include "object.h"
 #include "util.h"
 
-/// the memory object is functionally a symbol table lookup with
-/// utilities for adding, removing, and checking if certain symbols
-/// exist in the symbol table
+/// the memory holds the globals in a vector of slots, and the locals
+/// of every running function in a frame of slots on one flat stack.
+/// Every symbol of a function body is resolved to its slot before the
+/// body first runs, so that no variable access hashes; the symbol
+/// table of the globals is only used to resolve symbols. The objects
+/// of the parameters of a returned call and of the variables of finished
+/// loops are kept on a free list, which the next calls and loops take
+/// theirs from, so that once the stacks have grown neither allocates
 class memory {
 public:
-    static memory *global;
-    static std::stack<memory *> stack;
+    static std::unordered_map<std::uint32_t, std::uint32_t> table;
+    static std::vector<object *> globals;
+    static std::vector<object *> frames;
+    static std::size_t base;
+    static std::vector<object *> spare;
+    // the number of parameters of the running function
+    static std::size_t params;
 
-    std::unordered_map<std::string, object *> table;
+    static bool has(std::uint32_t id);
 
-    static bool has(std::string id);
+    static bool valid(std::uint32_t id);
 
-    static bool valid(std::string id);
+    static void add(std::uint32_t id, object *obj);
 
-    static void add(std::string id, object *obj, bool to_global = false);
+    static object *get(std::uint32_t id);
 
-    static void remove(std::string id);
+    static std::uint32_t slot(std::uint32_t id);
 
-    static object *get(std::string id);
+    static void clear();
 
-    static void push();
+    /// \param slot: the slot a symbol was resolved to
+    /// \return the object in the slot, or nullptr if the symbol is not
+    ///         declared
+    static object *find(std::uint32_t slot) {
+        if (slot < ast::global_slot)
+            return frames[base + slot];
+        return slot == ast::no_slot ? nullptr : globals[slot - ast::global_slot];
+    }
 
-    static void pop();
+    /// \param slot: a local slot of the running function
+    /// \return the slot, to read or declare its variable
+    static object *&local(std::uint32_t slot) {
+        return frames[base + slot];
+    }
 
-    memory();
+    /// \return an object for a parameter or a loop variable: one off
+    ///         the free list if there is one, or else a new object
+    static object *acquire() {
+        if (spare.empty())
+            return new object();
+        object *obj = spare.back();
+        spare.pop_back();
+        return obj;
+    }
+
+    /// puts an object that nothing refers to any more on the free list;
+    /// a container is dropped now rather than once the object is reused
+    /// \param obj: the object
+    static void recycle(object *obj) {
+        obj->type = o_none;
+        obj->store = 0.0;
+        spare.push_back(obj);
+    }
+
+    static std::size_t push(std::uint32_t size, std::size_t count = 0);
+
+    static void pop(std::size_t prev, std::size_t count = 0, const object *ret = nullptr);
+
+    static void reuse(std::uint32_t size, std::size_t count = 0);
+
+private:
+    static void release(const object *ret);
 };
 
 #endif //QI_INTERPRETER_MEMORY_H
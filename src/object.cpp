@@ -6,6 +6,7 @@
  */
 
 #include "object.h"
+#include "runtime.h"
 
 /// takes in an object type and returns it as a string
 /// \param t: the type as o_type
@@ -37,40 +38,44 @@ std::string object::o_type_str(o_type t) {
     }
 }
 
-/// takes in a string and returns it as an object_type
-/// \param t: the type as a string
+/// takes in a type keyword and returns it as an object_type
+/// \param s: the type as a symbol id
 /// \return the type as o_type
-o_type object::str_o_type(std::string s) {
-    if (s == "none")
-        return o_none;
-    if (s == "fn")
-        return o_fn;
-    if (s == "num")
-        return o_num;
-    if (s == "bool")
-        return o_bool;
-    if (s == "str")
-        return o_str;
-    if (s == "arr")
-        return o_arr;
-    if (s == "map")
-        return o_map;
-    if (s == "set")
-        return o_set;
-    if (s == "queue")
-        return o_queue;
-    if (s == "stack")
-        return o_stack;
-    else return o_none;
+o_type object::sym_o_type(std::uint32_t s) {
+    switch (s) {
+        case s_none:
+            return o_none;
+        case s_fn:
+            return o_fn;
+        case s_num:
+            return o_num;
+        case s_bool:
+            return o_bool;
+        case s_str:
+            return o_str;
+        case s_arr:
+            return o_arr;
+        case s_map:
+            return o_map;
+        case s_set:
+            return o_set;
+        case s_queue:
+            return o_queue;
+        case s_stack:
+            return o_stack;
+        default:
+            return o_none;
+    }
 }
 
 /// `f_param` empty constructor
 f_param::f_param() {
     type = o_none;
+    symbol = s_blank;
 }
 
 /// `f_param` parameterized constructor
-f_param::f_param(o_type _type, std::string _symbol) {
+f_param::f_param(o_type _type, std::uint32_t _symbol) {
     type = _type;
     symbol = _symbol;
 }
@@ -78,7 +83,7 @@ f_param::f_param(o_type _type, std::string _symbol) {
 /// generates a string representation of the function parameter
 /// \return the repr of the function representation
 std::string f_param::str() {
-    return object::o_type_str(type) + " " + symbol;
+    return object::o_type_str(type) + " " + ::symbol::str(symbol);
 }
 
 void quick_sortnum(std::vector<object*> arr, int low, int high) {
@@ -162,24 +167,38 @@ std::size_t obj_hash::operator()(object *o) const {
     return 0;
 }
 
+/// `function` constructor, for a function without a body yet
+function::function() {
+    returns = o_none;
+    body = nullptr;
+    code = nullptr;
+    heat = 0;
+    compiled = nullptr;
+    table = nullptr;
+}
+
 /// `object` empty constructor
 object::object() {
     type = o_none;
+    marked = false;
+    def = nullptr;
 }
 
-/// `object` parameter constructor
+/// `object` parameter constructor; a function gets its definition
 object::object(o_type _type) {
     type = _type;
+    marked = false;
+    def = type == o_fn ? new function() : nullptr;
 }
 
 /// set the parameters for when the object is a function
 void object::set_params(std::vector <f_param> &_f_params) {
-    f_params = _f_params;
+    def->params = _f_params;
 }
 
 /// set the function body for when the object is a function
-void object::set_body(ast_node *_f_body) {
-    f_body = _f_body;
+void object::set_body(ast *_f_body) {
+    def->body = _f_body;
 }
 
 /// generates a string representation of the object, recursively when
@@ -190,13 +209,13 @@ std::string object::str() {
         case o_fn: {
             std::stringstream ss;
             ss << "<fn:";
-            for (f_param &param : f_params)
+            for (f_param &param : def->params)
                 ss << " " << param.str();
-            ss << ", returns " << object::o_type_str(f_return) << ">\n";
+            ss << ", returns " << object::o_type_str(def->returns) << ">\n";
             return ss.str();
         }
         case o_num: {
-            return is_int() ? std::to_string((int) std::get<double>(store)) : std::to_string(std::get<double>(store));
+            return runtime::num_str(std::get<double>(store));
         }
         case o_bool: {
             return std::get<bool>(store) ? "true" : "false";
@@ -207,10 +226,10 @@ std::string object::str() {
         case o_arr: {
             std::stringstream ss;
             ss << "{";
-            if (!(std::get < std::vector < object * >> (store).empty())) {
-                for (int i = 0; i < std::get < std::vector < object * >> (store).size() - 1; ++i)
-                    ss << std::get < std::vector < object * >> (store)[i]->str() << ", ";
-                ss << std::get < std::vector < object * >> (store).back()->str();
+            if (!(as_arr().empty())) {
+                for (int i = 0; i < as_arr().size() - 1; ++i)
+                    ss << as_arr()[i]->str() << ", ";
+                ss << as_arr().back()->str();
             }
             ss << "}";
             return ss.str();
@@ -247,27 +266,26 @@ object *object::push(object *o) {
     switch (type) {
         case o_arr: {
             object *copy = new object(o->type);
-            copy->equal(o);
-            std::get < std::vector < object * >> (store).push_back(copy);
+            copy->assign(o);
+            as_arr().push_back(copy);
             break;
         }
         case o_queue: {
             object *copy = new object(o->type);
-            copy->equal(o);
-            std::get < std::queue < object * >> (store).push(copy);
+            copy->assign(o);
+            as_queue().push(copy);
             break;
         }
         case o_stack: {
             object *copy = new object(o->type);
-            copy->equal(o);
-            std::get < std::stack < object * >> (store).push(copy);
+            copy->assign(o);
+            as_stack().push(copy);
             break;
         }
         case o_set: {
             object *copy = new object(o->type);
-            copy->equal(o);
-            std::get < std::unordered_set < object * , obj_hash, obj_equals >> (store)
-                    .insert(copy);
+            copy->assign(o);
+            as_set().insert(copy);
             break;
         }
         default: {
@@ -286,14 +304,14 @@ object *object::pop() {
             break;
         }
         case o_arr: {
-            std::get < std::vector < object * >> (store).pop_back();
+            as_arr().pop_back();
             break;
         }
         case o_queue: {
-            std::get < std::stack < object * >> (store).pop();
+            as_stack().pop();
         }
         case o_stack: {
-            std::get < std::stack < object * >> (store).pop();
+            as_stack().pop();
         }
         default: {
             err("pop() is not supported on this object");
@@ -314,17 +332,17 @@ object *object::len() {
         }
         case o_arr: {
             object *ret = new object(o_num);
-            ret->set((double) (std::get < std::vector < object * >> (store).size()));
+            ret->set((double) (as_arr().size()));
             return ret;
         }
         case o_queue: {
             object *ret = new object(o_num);
-            ret->set((double) (std::get < std::queue < object * >> (store).size()));
+            ret->set((double) (as_queue().size()));
             return ret;
         }
         case o_stack: {
             object *ret = new object(o_num);
-            ret->set((double) (std::get < std::stack < object * >> (store).size()));
+            ret->set((double) (as_stack().size()));
             return ret;
         }
         default: {
@@ -361,7 +379,7 @@ object *object::find(object *o) {
             double size = std::get<double>(len()->store);
             ret->set((double) -1);
             for (int i = 0; i < size; ++i) {
-                if (std::get<bool>(std::get < std::vector < object * >> (store)[i]->equals(o)->store)) {
+                if (std::get<bool>(as_arr()[i]->equals(o)->store)) {
                     ret->set((double) i);
                     break;
                 }
@@ -370,15 +388,12 @@ object *object::find(object *o) {
         }
         case o_set: {
             object *r1 = new object(o_bool);
-            r1->set((std::get < std::unordered_set < object * , obj_hash, obj_equals >> (store)).find(o) !=
-                            std::get < std::unordered_set < object * , obj_hash, obj_equals >> (store).end());
+            r1->set(as_set().find(o) != as_set().end());
             return r1;
         }
         case o_map: {
             object *r2 = new object(o_bool);
-            r2->set((std::get < std::unordered_map < object * , object *, obj_hash, obj_equals >> (store)).find(o) !=
-                            std::get < std::unordered_map < object * , object * , obj_hash, obj_equals
-                            >> (store).end());
+            r2->set(as_map().find(o) != as_map().end());
             return r2;
         }
         default: {
@@ -398,8 +413,7 @@ object *object::reverse() {
             break;
         }
         case o_arr: {
-            std::reverse(std::get < std::vector < object * >> (store).begin(),
-                         std::get < std::vector < object * >> (store).end());
+            std::reverse(as_arr().begin(), as_arr().end());
             break;
         }
         default: {
@@ -427,9 +441,9 @@ object *object::fill(object *start, object *end, object *o) {
     if (!(0 <= i && i < size && 0 <= j && j < size))
         err("fill() out of bounds");
     while (i <= j) {
-        object *curr = std::get < std::vector < object * >> (store)[i];
+        object *curr = as_arr()[i];
         curr->type = o->type;
-        curr->equal(o);
+        curr->assign(o);
         i++;
     }
     return new object();
@@ -455,17 +469,17 @@ object *object::at(object *index) {
             if (!index->is_int())
                 err("index must be integer");
             int i = (int) std::get<double>(index->store);
-            if (!(i >= 0 && i < std::get < std::vector < object * >> (store).size()))
+            if (!(i >= 0 && i < as_arr().size()))
                 err("arr index out of bounds");
-            return std::get < std::vector < object * >> (store)[i];
+            return as_arr()[i];
         }
         case o_map: {
-            if (std::get < std::unordered_map < object * , object *, obj_hash, obj_equals >> (store).find(index) !=
-                    std::get < std::unordered_map < object *, object *, obj_hash, obj_equals >> (store).end())
-                return std::get < std::unordered_map < object * , object *, obj_hash, obj_equals >> (store)[index];
-            object *val = new object();
-            std::get < std::unordered_map < object * , object *, obj_hash, obj_equals >> (
-                    store)[index] = val;
+            if (as_map().find(index) != as_map().end())
+                return as_map()[index];
+            // the key is a copy, as the elements of containers are
+            object *key = new object(), *val = new object();
+            key->assign(index);
+            as_map()[key] = val;
             return val;
         }
         default: {
@@ -482,13 +496,13 @@ object *object::next() {
         case o_queue: {
             if (!std::get<bool>(empty()->store))
                 err("queue is empty");
-            return std::get < std::queue < object * >> (store).front();
+            return as_queue().front();
             break;
         }
         case o_stack: {
             if (!std::get<bool>(empty()->store))
                 err("stack is empty");
-            return std::get < std::stack < object * >> (store).top();
+            return as_stack().top();
             break;
         }
         default: {
@@ -509,14 +523,14 @@ object *object::last() {
             return ret;
         }
         case o_arr: {
-            if (std::get < std::vector < object * >> (store).empty())
+            if (as_arr().empty())
                 err("arr is empty");
-            return std::get < std::vector < object * >> (store).back();
+            return as_arr().back();
         }
         case o_queue: {
-            if (std::get < std::queue < object * >> (store).empty())
+            if (as_queue().empty())
                 err("queue is empty");
-            return std::get < std::queue < object * >> (store).back();
+            return as_queue().back();
         }
         default: {
             err("last() is not supported on this object");
@@ -559,7 +573,7 @@ object *object::add(object *o) {
 
 object *object::sub() {
     object *ret = new object(type);
-    ret->equal(this);
+    ret->assign(this);
     return ret;
 }
 
@@ -605,7 +619,7 @@ object *object::sub(object *start, object *end, object *step) {
             object *ret = new object(o_arr);
             std::vector < object * > tmp;
             for (; i < j; i += k)
-                tmp.push_back(std::get < std::vector < object * >> (store)[i]);
+                tmp.push_back(as_arr()[i]);
             ret->set(tmp);
             return ret;
         }
@@ -623,25 +637,25 @@ object *object::clear() {
             break;
         }
         case o_arr: {
-            std::get < std::vector < object * >> (store).clear();
+            as_arr().clear();
             break;
         }
         case o_queue: {
-            while (!std::get < std::queue < object * >> (store).empty())
-                std::get < std::queue < object * >> (store).pop();
+            while (!as_queue().empty())
+                as_queue().pop();
             break;
         }
         case o_stack: {
-            while (!std::get < std::stack < object * >> (store).empty())
-                std::get < std::stack < object * >> (store).pop();
+            while (!as_stack().empty())
+                as_stack().pop();
             break;
         }
         case o_set: {
-            std::get < std::unordered_set < object * , obj_hash, obj_equals >> (store).clear();
+            as_set().clear();
             break;
         }
         case o_map: {
-            std::get < std::unordered_map < object * , object *, obj_hash, obj_equals >> (store).clear();
+            as_map().clear();
             break;
         }
         default: {
@@ -663,13 +677,13 @@ object *object::sort() {
             break;
         }
         case o_arr: {
-            switch(std::get<std::vector<object*>>(store)[0]->type) {
+            switch(as_arr()[0]->type) {
                 case o_num : {
-                    quick_sortnum(std::get<std::vector<object*>>(store), 0, std::get<std::vector<object*>>(store).size()-1);
+                    quick_sortnum(as_arr(), 0, as_arr().size()-1);
                     break;
                 }
                 case o_str : {
-                    quick_sortstr(std::get<std::vector<object*>>(store), 0, std::get<std::vector<object*>>(store).size()-1);
+                    quick_sortstr(as_arr(), 0, as_arr().size()-1);
                     break;
                 }
                 default : {
@@ -870,9 +884,8 @@ object *object::equals(object *o) {
                 bool equals = true;
                 if (len() != o->len()) equals = false;
                 else {
-                    for (int i = 0; i < std::get < std::vector < object * >> (store).size(); ++i)
-                        if (std::get < std::vector < object * >> (store)[i] != std::get < std::vector <
-                                                                               object * >> (o->store)[i])
+                    for (int i = 0; i < as_arr().size(); ++i)
+                        if (as_arr()[i] != o->as_arr()[i])
                             equals = false;
                 }
                 ret->set(equals);
@@ -906,82 +919,86 @@ object *object::less_than_equal_to(object *o) {
 }
 
 object *object::add_equal(object *o) {
-    equal(add(o));
+    assign(add(o));
     return new object();
 }
 
 object *object::subtract_equal(object *o) {
-    equal(subtract(o));
+    assign(subtract(o));
     return new object();
 }
 
 object *object::multiply_equal(object *o) {
-    equal(multiply(o));
+    assign(multiply(o));
     return new object();
 }
 
 object *object::power_equal(object *o) {
-    equal(power(o));
+    assign(power(o));
     return new object();
 }
 
 object *object::divide_equal(object *o) {
-    equal(divide(o));
+    assign(divide(o));
     return new object();
 }
 
 object *object::truncate_divide_equal(object *o) {
-    equal(truncate_divide(o));
+    assign(truncate_divide(o));
     return new object();
 }
 
 object *object::modulo_equal(object *o) {
-    equal(modulo(o));
+    assign(modulo(o));
     return new object();
 }
 
 object *object::b_xor_equal(object *o) {
-    equal(b_xor(o));
+    assign(b_xor(o));
     return new object();
 }
 
 object *object::b_or_equal(object *o) {
-    equal(b_or(o));
+    assign(b_or(o));
     return new object();
 }
 
 object *object::b_and_equal(object *o) {
-    equal(b_and(o));
+    assign(b_and(o));
     return new object();
 }
 
 object *object::b_right_shift_equal(object *o) {
-    equal(b_right_shift(o));
+    assign(b_right_shift(o));
     return new object();
 }
 
 object *object::b_left_shift_equal(object *o) {
-    equal(b_left_shift(o));
+    assign(b_left_shift(o));
     return new object();
 }
 
-object *object::equal(object *o) {
+/// copies an object into this one: a none takes its type, a bool takes
+/// its truth, and an arr copies its elements
+/// \param o: the object copied
+void object::assign(object *o) {
     if (type == o_bool)
         store = o->to_bool()->store;
     else {
-        if (type == o_none)
+        if (type == o_none) {
             type = o->type;
-        else if (type != o->type || type == o_fn)
+            def = o->def;
+        } else if (type != o->type || type == o_fn)
             err("cannot assign differently typed variables");
 
         switch (type) {
             case o_arr: {
                 store = std::vector<object *>();
                 object *obj;
-                for (int i = 0; i < std::get < std::vector < object * >> (o->store).size(); ++i) {
+                for (int i = 0; i < o->as_arr().size(); ++i) {
                     obj = new object();
-                    obj->equal(std::get < std::vector < object * >> (o->store)[i]);
-                    std::get < std::vector < object * >> (store).push_back(obj);
+                    obj->assign(o->as_arr()[i]);
+                    as_arr().push_back(obj);
                 }
                 break;
             }
@@ -991,6 +1008,13 @@ object *object::equal(object *o) {
             }
         }
     }
+}
+
+/// `=`: assigns an object as assign does
+/// \param o: the object assigned
+/// \return none
+object *object::equal(object *o) {
+    assign(o);
     return new object();
 }
 
@@ -1071,7 +1095,6 @@ object *object::rand() {
     return ret;
 }
 
-void object::set(
-        std::variant<double, std::string, bool, std::vector<object *>, std::queue<object *>, std::stack<object *>, std::unordered_set<object *, obj_hash, obj_equals>, std::unordered_map<object *, object *, obj_hash, obj_equals>> _store) {
+void object::set(object_store _store) {
     store = _store;
 }
\ No newline at end of file
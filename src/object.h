@@ -3,6 +3,8 @@
  *   - Declarations for the object class
  *   - Object hash and object comparator
  *   - Function parameter class
+ *   - Function class, the part of a function object no other value has
+ *   - Boxed containers of the object store
  *   - Object types as enumerators
  */
 
@@ -21,7 +23,7 @@
 #include <unordered_map>
 #include <unordered_set>
 
-#include "ast_node.h"
+#include "ast.h"
 #include "util.h"
 
 /// the different object types
@@ -42,17 +44,23 @@ enum o_type {
 class f_param {
 public:
     o_type type;
-    std::string symbol;
+    std::uint32_t symbol;
 
     f_param();
 
-    f_param(o_type _type, std::string _symbol);
+    f_param(o_type _type, std::uint32_t _symbol);
 
     std::string str();
 };
 
 class object;
 
+class bytecode;
+
+class native;
+
+class memo;
+
 /// obj_equals used in unordered_set/map
 struct obj_equals {
 public:
@@ -65,35 +73,122 @@ public:
     std::size_t operator()(object *o) const;
 };
 
-/// the object that everything in the language is constructed from
+/// a container of an object store, kept behind a pointer so that it does
+/// not widen the store of every num; copying it copies the container
+template <typename T>
+class boxed {
+private:
+    T *ptr;
+
+public:
+    boxed() : ptr(new T()) {}
+
+    boxed(T &&val) : ptr(new T(std::move(val))) {}
+
+    boxed(const T &val) : ptr(new T(val)) {}
+
+    boxed(const boxed &o) : ptr(new T(*o.ptr)) {}
+
+    boxed(boxed &&o) noexcept: ptr(o.ptr) {
+        o.ptr = nullptr;
+    }
+
+    boxed &operator=(boxed o) noexcept {
+        std::swap(ptr, o.ptr);
+        return *this;
+    }
+
+    ~boxed() {
+        delete ptr;
+    }
+
+    T &operator*() const {
+        return *ptr;
+    }
+};
+
+/// the value of an object: a num, a str or a bool in place, or a
+/// container behind a pointer
+using object_store = std::variant<double, std::string, bool, boxed<std::vector<object *>>, boxed<std::queue<object *>>, boxed<std::stack<object *>>, boxed<std::unordered_set<object *, obj_hash, obj_equals>>, boxed<std::unordered_map<object *, object *, obj_hash, obj_equals>>>;
+
+/// what a function object holds besides its type: its signature, its
+/// body, and what the engines keep for it
+class function {
+public:
+    std::vector <f_param> params;
+    o_type returns;
+    ast *body;
+    token_span source;
+    bytecode *code;
+    // calls and loop passes counted towards compiling the function to
+    // native code, and the native code once it is compiled
+    std::uint32_t heat;
+    native *compiled;
+    // the values of earlier calls, if the function is memoized
+    memo *table;
+
+    function();
+};
+
+/// the object that everything in the language is constructed from. A
+/// function keeps its definition apart and containers are boxed, so
+/// that a num, a bool or a str fits in a cache line
 class object {
 public:
-    std::variant<double, std::string, bool, std::vector<object *>, std::queue<object *>, std::stack<object *>, std::unordered_set<object *, obj_hash, obj_equals>, std::unordered_map<object *, object *, obj_hash, obj_equals>> store;
+    object_store store;
     o_type type;
+    // set by the collector on the objects it reaches
+    bool marked;
+    // the definition of a function object, or nullptr
+    function *def;
 
-    std::vector <f_param> f_params;
-    o_type f_return;
-    ast_node *f_body;
+    // objects are allocated from the object heap
+    static void *operator new(std::size_t size);
+
+    static void operator delete(void *p);
 
     static std::string
     o_type_str(o_type
                t);
 
-    static o_type str_o_type(std::string s);
+    static o_type sym_o_type(std::uint32_t s);
 
     object();
 
     object(o_type _type);
 
-    void
-    set(std::variant<double, std::string, bool, std::vector<object *>, std::queue<object *>, std::stack<object *>, std::unordered_set<object *, obj_hash, obj_equals>, std::unordered_map<object *, object *, obj_hash, obj_equals>> _store);
+    void set(object_store _store);
 
     void set_params(std::vector <f_param> &_f_params);
 
-    void set_body(ast_node *_f_body);
+    void set_body(ast *_f_body);
+
+    ast *body();
+
+    bytecode *code();
 
     bool is_int();
 
+    std::vector<object *> &as_arr() {
+        return *std::get<boxed<std::vector<object *>>>(store);
+    }
+
+    std::queue<object *> &as_queue() {
+        return *std::get<boxed<std::queue<object *>>>(store);
+    }
+
+    std::stack<object *> &as_stack() {
+        return *std::get<boxed<std::stack<object *>>>(store);
+    }
+
+    std::unordered_set<object *, obj_hash, obj_equals> &as_set() {
+        return *std::get<boxed<std::unordered_set<object *, obj_hash, obj_equals>>>(store);
+    }
+
+    std::unordered_map<object *, object *, obj_hash, obj_equals> &as_map() {
+        return *std::get<boxed<std::unordered_map<object *, object *, obj_hash, obj_equals>>>(store);
+    }
+
     object *push(object *o);
 
     object *pop();
@@ -186,6 +281,8 @@ public:
 
     object *b_left_shift_equal(object *o);
 
+    void assign(object *o);
+
     object *equal(object *o);
 
     object *to_bool();
@@ -207,4 +304,10 @@ public:
     std::string str();
 };
 
+// the layout guard: a num, a bool or a str object fits in a cache line,
+// which only holds while containers stay boxed and functions keep their
+// definitions apart
+static_assert(sizeof(object_store) <= 40, "a container of the object store is not boxed");
+static_assert(sizeof(object) <= 64, "an object does not fit in a cache line");
+
 #endif //QI_INTERPRETER_OBJECT_H
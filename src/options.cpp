@@ -0,0 +1,130 @@
+/*
+ * options.cpp contains:
+ *   - Definitions for the command line options
+ *   - The option parser
+ */
+
+#include "options.h"
+
+// static vars
+std::string options::file_name;
+std::string options::lexer = "dfa";
+std::string options::parser = "pratt";
+bool options::dump_tokens = false;
+bool options::dump_ast = false;
+bool options::dump_bytecode = false;
+bool options::emit_cpp = false;
+std::string options::engine = "vm";
+std::string options::types = "static";
+bool options::quicken = true;
+bool options::quicken_stats = false;
+std::string options::jit = "off";
+int options::jit_threshold = 1000;
+// the size of each call stack in MB
+int options::stack_limit = 1536;
+bool options::memo = false;
+// the calls kept by the memo table of each function
+int options::memo_size = 4096;
+bool options::memo_stats = false;
+// the least objects allocated between two collections
+int options::gc_threshold = 1000000;
+bool options::gc_stats = false;
+bool options::lazy = false;
+bool options::cache = false;
+std::string options::cache_dir;
+int options::jobs = (int) std::max(1u, std::thread::hardware_concurrency());
+
+/// \param arg: the value of a count option
+/// \param digits: the most digits it may have
+/// \param what: what it counts, for the error
+/// \return the count, which is positive
+static int count_arg(const std::string &arg, std::size_t digits, const std::string &what) {
+    if (arg.empty() || arg.size() > digits || arg.find_first_not_of("0123456789") != std::string::npos ||
+        std::stoi(arg) == 0)
+        err("invalid " + what + " \"" + arg + "\"");
+    return std::stoi(arg);
+}
+
+/// parses the command line; the only positional argument is the
+/// program file
+/// \param argc: arg count
+/// \param argv: arg values
+void options::parse(int argc, char *argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--tokens")
+            options::dump_tokens = true;
+        else if (arg == "--ast")
+            options::dump_ast = true;
+        else if (arg == "--bytecode")
+            options::dump_bytecode = true;
+        else if (arg == "--emit-cpp")
+            options::emit_cpp = true;
+        else if (arg == "--quicken-stats")
+            options::quicken_stats = true;
+        else if (arg == "--memo")
+            options::memo = true;
+        else if (arg == "--memo-stats")
+            options::memo_stats = true;
+        else if (arg == "--gc-stats")
+            options::gc_stats = true;
+        else if (arg == "--lazy")
+            options::lazy = true;
+        else if (arg == "--cache")
+            options::cache = true;
+        else if (arg.rfind("--cache=", 0) == 0) {
+            options::cache = true;
+            options::cache_dir = arg.substr(8);
+            if (options::cache_dir.empty())
+                err("invalid cache directory");
+        } else if (arg.rfind("--lexer=", 0) == 0) {
+            options::lexer = arg.substr(8);
+            if (options::lexer != "dfa" && options::lexer != "regex")
+                err("unknown lexer \"" + options::lexer + "\"");
+        } else if (arg.rfind("--engine=", 0) == 0) {
+            options::engine = arg.substr(9);
+            if (options::engine != "tree" && options::engine != "vm")
+                err("unknown engine \"" + options::engine + "\"");
+        } else if (arg.rfind("--types=", 0) == 0) {
+            options::types = arg.substr(8);
+            if (options::types != "static" && options::types != "dynamic")
+                err("unknown type checking \"" + options::types + "\"");
+        } else if (arg.rfind("--quicken=", 0) == 0) {
+            std::string mode = arg.substr(10);
+            if (mode != "on" && mode != "off")
+                err("unknown quickening \"" + mode + "\"");
+            options::quicken = mode == "on";
+        } else if (arg.rfind("--jit=", 0) == 0) {
+            options::jit = arg.substr(6);
+            if (options::jit != "off" && options::jit != "on" && options::jit != "threshold")
+                err("unknown jit mode \"" + options::jit + "\"");
+#if !defined(__x86_64__)
+            // native code is only generated for x86-64
+            if (options::jit != "off")
+                err("jit mode \"" + options::jit + "\" needs an x86-64 host");
+#endif
+        } else if (arg.rfind("--jit-threshold=", 0) == 0) {
+            options::jit_threshold = count_arg(arg.substr(16), 9, "jit threshold");
+        } else if (arg.rfind("--stack-limit=", 0) == 0) {
+            options::stack_limit = count_arg(arg.substr(14), 7, "stack limit");
+        } else if (arg.rfind("--memo-size=", 0) == 0) {
+            options::memo_size = count_arg(arg.substr(12), 9, "memo size");
+        } else if (arg.rfind("--gc-threshold=", 0) == 0) {
+            options::gc_threshold = count_arg(arg.substr(15), 9, "gc threshold");
+        } else if (arg.rfind("--parser=", 0) == 0) {
+            options::parser = arg.substr(9);
+            if (options::parser != "pratt" && options::parser != "scan")
+                err("unknown parser \"" + options::parser + "\"");
+        } else if (arg == "--jobs" || arg.rfind("--jobs=", 0) == 0) {
+            std::string count = arg == "--jobs" ? (i + 1 < argc ? argv[++i] : "") : arg.substr(7);
+            options::jobs = count_arg(count, 4, "job count");
+        } else if (arg.rfind("--", 0) == 0)
+            err("unknown option \"" + arg + "\"");
+        else if (options::file_name.empty())
+            options::file_name = arg;
+        else
+            err("invalid arg count");
+    }
+    if (options::file_name.empty())
+        err("invalid arg count");
+}
@@ -0,0 +1,46 @@
+/*
+ * options.h contains:
+ *   - Declarations for the command line options
+ */
+
+#ifndef QI_INTERPRETER_OPTIONS_H
+#define QI_INTERPRETER_OPTIONS_H
+
+#include <algorithm>
+#include <string>
+#include <thread>
+
+#include "util.h"
+
+/// command line options, parsed once at startup; every option has a
+/// default so that `qi file.qi` runs the program as before
+class options {
+public:
+    static std::string file_name;
+    static std::string lexer;
+    static std::string parser;
+    static bool dump_tokens;
+    static bool dump_ast;
+    static bool dump_bytecode;
+    static bool emit_cpp;
+    static std::string engine;
+    static std::string types;
+    static bool quicken;
+    static bool quicken_stats;
+    static std::string jit;
+    static int jit_threshold;
+    static int stack_limit;
+    static bool memo;
+    static int memo_size;
+    static bool memo_stats;
+    static int gc_threshold;
+    static bool gc_stats;
+    static int jobs;
+    static bool lazy;
+    static bool cache;
+    static std::string cache_dir;
+
+    static void parse(int argc, char *argv[]);
+};
+
+#endif //QI_INTERPRETER_OPTIONS_H
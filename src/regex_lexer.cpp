@@ -0,0 +1,133 @@
+/*
+ * regex_lexer.cpp contains:
+ *   - Definitions for the regex lexer
+ *   - Definitions for the tokenizing regex
+ */
+
+#include "regex_lexer.h"
+
+const std::string regex_lexer::r_num = "[0-9.]",
+        regex_lexer::r_lb = "\n",
+        regex_lexer::r_comment = "$",
+        regex_lexer::r_symbol = "[a-zA-Z_0-9]",
+        regex_lexer::r_op = "\\+|-|\\*|\\/|=|>|<|>=|<=|&|\\||%|!|\\^|\\.|\\,";
+
+/// constructs the regex lexer
+/// \param _stream: the character stream
+regex_lexer::regex_lexer(fstream _stream) {
+    line = 1;
+    stream = _stream;
+}
+
+/// checks if the given character matches the given regular
+/// expression and returns true accordingly
+/// \param c: the character to check
+/// \param expr: the regex definition
+/// \return whether c can be matched by expr
+bool regex_lexer::matches(const char &c, const std::string &expr) const {
+    std::string target;
+    std::regex reg_expr(expr);
+    target.push_back(c);
+    return std::regex_match(target, reg_expr);
+}
+
+/// scans a stream while it matches the given regular expression
+/// \param expr: the regex definition
+/// \return scanned character set
+std::string regex_lexer::scan_regex(const std::string &expr) {
+    std::string ret;
+    ret.push_back(stream.curr());
+    while (matches(stream.next(), expr)) {
+        ret.push_back(stream.next());
+        stream.move();
+    }
+    return ret;
+}
+
+/// scans an entire string, adding everything to the string until the
+/// string delimiter character is reached
+/// \param delim: the string delimiter character
+/// \return: the scanned string
+std::string regex_lexer::scan_str(const char &delim) {
+    std::string ret;
+    while (stream.next() != 0) {
+        char prev = stream.curr();
+        stream.move();
+        // allow escaped delimeters to be part of the string
+        if (stream.curr() == delim && prev != '\\')
+            return ret;
+        else if (stream.curr() == delim) {
+            ret.pop_back();
+            ret.push_back(stream.curr());
+        } else if (prev == '\\' && stream.curr() == 'n') {
+            ret.pop_back();
+            ret.push_back('\n');
+        } else ret.push_back(stream.curr());
+    }
+    err("unclosed string", line);
+    return ret;
+}
+
+/// scans linebreaks and increases line number for association with
+/// the tokens being created
+void regex_lexer::scan_lb() {
+    while (matches(stream.next(), r_lb)) {
+        ++line;
+        stream.move();
+    }
+}
+
+/// reads until the end of the line if a comment start character is
+/// seen, ignoring all characters
+void regex_lexer::scan_comment() {
+    while (stream.next() != 0) {
+        stream.move();
+        if (matches(stream.curr(), r_lb)) {
+            ++line;
+            return;
+        }
+    }
+}
+
+/// tokenizes the file stream
+/// \return a resultant vector of tokens
+std::vector <token> regex_lexer::tokenize() {
+    std::vector <token> tokens;
+    while (stream.next()) {
+        stream.move();
+        char curr = stream.curr();
+        if (curr == EOF)
+            tokens.emplace_back(s_eof, line, t_eof);
+        else if (curr == ' ')
+            continue;
+        else if (curr == '"')
+            tokens.emplace_back(symbol::intern(scan_str()), line, t_str);
+        else if (matches(curr, r_num))
+            tokens.emplace_back(symbol::intern(scan_regex(r_num)), line, t_num);
+        else if (matches(curr, r_lb)) {
+            ++line;
+            scan_lb();
+            tokens.emplace_back(s_lb, line, t_lb);
+        } else if (curr == r_comment.front())
+            scan_comment();
+        else if (matches(curr, r_symbol)) {
+            std::uint32_t val = symbol::intern(scan_regex(r_symbol));
+            if (token::is_builtin(val))
+                tokens.emplace_back(val, line, t_builtin, token::arity(val));
+            else
+                tokens.emplace_back(val, line, t_symbol);
+        } else if (curr == '(' || curr == ')') {
+            std::uint32_t val = curr == '(' ? s_lparen : s_rparen;
+            tokens.emplace_back(val, line, t_builtin, token::arity(val));
+        } else if (matches(curr, r_op)) {
+            std::uint32_t val = symbol::intern(scan_regex(r_op));
+            if (token::is_builtin(val))
+                tokens.emplace_back(val, line, t_builtin, token::arity(val));
+            else
+                err("unrecognized operator", line);
+        } else {
+            err("unrecognized symbol", line);
+        }
+    }
+    return tokens;
+}
@@ -0,0 +1,43 @@
+/*
+ * regex_lexer.h contains:
+ *   - Declarations for the regex lexer, kept as the reference
+ *     implementation for the table-driven lexer
+ */
+
+#ifndef QI_INTERPRETER_REGEX_LEXER_H
+#define QI_INTERPRETER_REGEX_LEXER_H
+
+#include <iostream>
+#include <regex>
+#include <string>
+#include <vector>
+
+#include "fstream.h"
+#include "token.h"
+#include "util.h"
+
+/// reads in a stream of characters and parses the characters into
+/// pre-defined tokens
+class regex_lexer {
+private:
+    fstream stream;
+    int line;
+    static const std::string r_num, r_lb, r_comment, r_symbol, r_op;
+
+public:
+    explicit regex_lexer(fstream _stream);
+
+    bool matches(const char &c, const std::string &expr) const;
+
+    std::string scan_regex(const std::string &expr);
+
+    std::string scan_str(const char &delim = '"');
+
+    void scan_lb();
+
+    void scan_comment();
+
+    std::vector <token> tokenize();
+};
+
+#endif //QI_INTERPRETER_REGEX_LEXER_H
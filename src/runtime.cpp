@@ -0,0 +1,459 @@
+/*
+ * runtime.cpp contains:
+ *   - Definitions for the runtime shared by the engines and by
+ *     programs compiled to C++
+ */
+
+#include "runtime.h"
+
+/// the object method of every binary operator, by symbol id
+const std::array<runtime::binary_op, s_count> runtime::operators = [] {
+    std::array<binary_op, s_count> table{};
+    table[s_assign] = &object::equal;
+    table[s_plus] = &object::add;
+    table[s_minus] = &object::subtract;
+    table[s_star] = &object::multiply;
+    table[s_star_star] = &object::power;
+    table[s_slash] = &object::divide;
+    table[s_slash_slash] = &object::truncate_divide;
+    table[s_percent] = &object::modulo;
+    table[s_caret] = &object::b_xor;
+    table[s_bar] = &object::b_or;
+    table[s_amp] = &object::b_and;
+    table[s_shift_right] = &object::b_right_shift;
+    table[s_shift_left] = &object::b_left_shift;
+    table[s_greater] = &object::greater_than;
+    table[s_less] = &object::less_than;
+    table[s_eq_eq] = &object::equals;
+    table[s_not_eq] = &object::not_equals;
+    table[s_greater_eq] = &object::greater_than_equal_to;
+    table[s_less_eq] = &object::less_than_equal_to;
+    table[s_plus_eq] = &object::add_equal;
+    table[s_minus_eq] = &object::subtract_equal;
+    table[s_star_eq] = &object::multiply_equal;
+    table[s_star_star_eq] = &object::power_equal;
+    table[s_slash_eq] = &object::divide_equal;
+    table[s_slash_slash_eq] = &object::truncate_divide_equal;
+    table[s_percent_eq] = &object::modulo_equal;
+    table[s_caret_eq] = &object::b_xor_equal;
+    table[s_bar_eq] = &object::b_or_equal;
+    table[s_amp_eq] = &object::b_and_equal;
+    table[s_shift_right_eq] = &object::b_right_shift_equal;
+    // `<<=` shifts right, as it always has
+    table[s_shift_left_eq] = &object::b_right_shift_equal;
+    table[s_and] = &object::_and;
+    table[s_or] = &object::_or;
+    return table;
+}();
+
+/// raises an error without a line; unlike err, the compiler knows
+/// that it never returns
+/// \param message: the error message
+void runtime::fail(const std::string &message) {
+    err(message);
+    std::abort();
+}
+
+/// raises an error at a line
+/// \param message: the error message
+/// \param line: the line of the error
+void runtime::fail(const std::string &message, int line) {
+    err(message, line);
+    std::abort();
+}
+
+char *runtime::stack_floor = nullptr;
+
+/// runs a program on a native stack of its own, which is reserved up
+/// front and only backed by memory as calls reach its pages, so deep
+/// recursion on the tree walker, native code and compiled programs is
+/// bounded by the size rather than by the stack limit of the process.
+/// The VM, the default engine, keeps its calls off the native stack;
+/// the tree walker takes about 1 KB of it per call, which is about 1.5
+/// million calls deep with the default size. If the stack cannot be
+/// reserved, the program runs on the process stack
+/// \param size: the size of the stack in bytes
+/// \param body: runs the program
+void runtime::run_on_stack(std::size_t size, void (*body)()) {
+    std::size_t page = (std::size_t) sysconf(_SC_PAGESIZE);
+    size = (size + page - 1) / page * page;
+    // calls refuse to run once less than this is left, for what runs
+    // between two calls
+    std::size_t margin = std::min(size / 4, (std::size_t) 1 << 20);
+    void *mem = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK,
+                     -1, 0);
+    if (mem == MAP_FAILED) {
+        rlimit limit{};
+        getrlimit(RLIMIT_STACK, &limit);
+        std::size_t room = limit.rlim_cur == RLIM_INFINITY ? size : std::min(size, (std::size_t) limit.rlim_cur);
+        stack_floor = static_cast<char *>(__builtin_frame_address(0)) - room + margin;
+        body();
+        return;
+    }
+    // a guard page at the bottom catches what overruns the margin
+    mprotect(mem, page, PROT_NONE);
+    ucontext_t caller{}, callee{};
+    getcontext(&callee);
+    callee.uc_stack.ss_sp = mem;
+    callee.uc_stack.ss_size = size;
+    callee.uc_link = &caller;
+    makecontext(&callee, body, 0);
+    char *prev = stack_floor;
+    stack_floor = static_cast<char *>(mem) + page + margin;
+    swapcontext(&caller, &callee);
+    stack_floor = prev;
+    munmap(mem, size);
+}
+
+/// creates the object of a variable declaration, with the default
+/// value of its type
+/// \param keyword: the type keyword of the declaration, e.g. s_num
+/// \return the declared object
+object *runtime::make(std::uint32_t keyword) {
+    o_type t_obj = object::sym_o_type(keyword);
+    object_store store;
+    if (keyword == s_num)
+        store = (double) 0;
+    else if (keyword == s_bool)
+        store = false;
+    else if (keyword == s_str)
+        store = "";
+    else if (keyword == s_arr)
+        store = std::vector<object *>();
+    else if (keyword == s_queue)
+        store = std::queue<object *>();
+    else if (keyword == s_stack)
+        store = std::stack<object *>();
+    else if (keyword == s_set)
+        store = std::unordered_set<object *, obj_hash, obj_equals>();
+    else if (keyword == s_map)
+        store = std::unordered_map<object *, object *, obj_hash, obj_equals>();
+    else
+        err("unimplemented var type");
+
+    object *tmp = new object(t_obj);
+    tmp->set(store);
+    return tmp;
+}
+
+/// reads a line of input into a variable, for `in`
+/// \param var: the variable
+/// \param line: the line of the `in`
+void runtime::read(object *var, int line) {
+    std::string in;
+    std::getline(std::cin, in);
+    switch (var->type) {
+        case o_num: {
+            std::size_t offset = 0;
+            double self = std::stod(in, &offset);
+            if (offset != in.size())
+                err("invalid number in input", line);
+            var->set(self);
+            break;
+        }
+        case o_str: {
+            var->set(in);
+            break;
+        }
+        default: {
+            err("unsupported input type", line);
+            break;
+        }
+    }
+}
+
+/// reads a line of input as a num, as read does for a num variable
+/// \param line: the line of the `in`
+/// \return the num
+double runtime::read_num(int line) {
+    std::string in;
+    std::getline(std::cin, in);
+    std::size_t offset = 0;
+    double self = std::stod(in, &offset);
+    if (offset != in.size())
+        err("invalid number in input", line);
+    return self;
+}
+
+/// reads a line of input as a str
+/// \return the line
+std::string runtime::read_str() {
+    std::string in;
+    std::getline(std::cin, in);
+    return in;
+}
+
+/// \param op: a compound assignment, e.g. `+=`
+/// \return the operator it applies before assigning, or s_blank if op
+///         is not a compound assignment
+std::uint32_t runtime::compound_base(std::uint32_t op) {
+    switch (op) {
+        case s_plus_eq:
+            return s_plus;
+        case s_minus_eq:
+            return s_minus;
+        case s_star_eq:
+            return s_star;
+        case s_star_star_eq:
+            return s_star_star;
+        case s_slash_eq:
+            return s_slash;
+        case s_slash_slash_eq:
+            return s_slash_slash;
+        case s_percent_eq:
+            return s_percent;
+        case s_caret_eq:
+            return s_caret;
+        case s_bar_eq:
+            return s_bar;
+        case s_amp_eq:
+            return s_amp;
+        case s_shift_right_eq:
+            return s_shift_right;
+        // `<<=` shifts right, as the object method does
+        case s_shift_left_eq:
+            return s_shift_right;
+        default:
+            return s_blank;
+    }
+}
+
+/// \param op: an operator
+/// \return whether the operator has a num fast path
+bool runtime::arithmetic(std::uint32_t op) {
+    return op == s_plus || op == s_minus || op == s_star || op == s_star_star || op == s_slash ||
+           op == s_slash_slash || op == s_percent;
+}
+
+/// \param op: an operator
+/// \return whether the operator compares two values
+bool runtime::comparison(std::uint32_t op) {
+    return op == s_less || op == s_greater || op == s_less_eq || op == s_greater_eq || op == s_eq_eq ||
+           op == s_not_eq;
+}
+
+/// \param op: an operator
+/// \return whether num_binary computes the operator on two nums
+bool runtime::num_operator(std::uint32_t op) {
+    return op == s_assign || arithmetic(compound_base(op)) || arithmetic(op) || comparison(op);
+}
+
+/// \param op: an arithmetic operator
+/// \param a: the left num
+/// \param b: the right num
+/// \return the result of the operator, as the object methods compute it
+double runtime::num_value(std::uint32_t op, double a, double b) {
+    switch (op) {
+        case s_plus:
+            return a + b;
+        case s_minus:
+            return a - b;
+        case s_star:
+            return a * b;
+        case s_star_star:
+            return pow(a, b);
+        case s_slash:
+            return a / b;
+        case s_slash_slash:
+            return (double) std::floor(a / b);
+        default:
+            return fmod(a, b);
+    }
+}
+
+/// \param op: a comparison
+/// \param a: the left num
+/// \param b: the right num
+/// \return the result of the comparison
+bool runtime::num_compare(std::uint32_t op, double a, double b) {
+    switch (op) {
+        case s_less:
+            return a < b;
+        case s_greater:
+            return a > b;
+        case s_less_eq:
+            return a <= b;
+        case s_greater_eq:
+            return a >= b;
+        case s_eq_eq:
+            return a == b;
+        default:
+            return a != b;
+    }
+}
+
+/// runs an operator that the checker proved to take two nums, or that
+/// a quickened node found to take two nums
+/// \param op: the operator
+/// \param left: the left num
+/// \param right: the right num
+/// \return the result, or none for an assignment
+object *runtime::num_binary(std::uint32_t op, object *left, object *right) {
+    return apply(op, value::of(left), value::of(right)).box();
+}
+
+/// runs a binary operator on two values. Nums, and the bools of `and`,
+/// `or`, `==` and `!=`, are computed without creating an object for the
+/// operands or the result; an assignment to a num or a bool object
+/// stores in place. Anything else runs the object method
+/// \param op: the operator
+/// \param left: the left operand
+/// \param right: the right operand
+/// \return the result, or none for an assignment
+value runtime::apply(std::uint32_t op, value left, value right) {
+    o_type lt = left.type(), rt = right.type();
+    if (lt == o_num && rt == o_num && num_operator(op)) {
+        double a = left.number(), b = right.number();
+        std::uint32_t base = compound_base(op);
+        if (op == s_assign || base != s_blank) {
+            // a num that is not a variable has nothing to assign to
+            if (left.is_obj())
+                left.obj()->store = op == s_assign ? b : num_value(base, a, b);
+            return value();
+        }
+        if (arithmetic(op))
+            return value::num(num_value(op, a, b));
+        return value::boolean(num_compare(op, a, b));
+    }
+    if (op == s_and || op == s_or)
+        return value::boolean(op == s_and ? truth(left) && truth(right) : truth(left) || truth(right));
+    if (lt == o_bool && rt == o_bool) {
+        if (op == s_eq_eq || op == s_not_eq)
+            return value::boolean((left.boolean() == right.boolean()) == (op == s_eq_eq));
+        if (op == s_assign) {
+            if (left.is_obj())
+                left.obj()->store = right.boolean();
+            return value();
+        }
+    }
+    return value::of(binary(op, left.box(), right.box()));
+}
+
+/// runs a comparison whose result is only tested, without creating a
+/// bool object for two nums
+/// \param op: a comparison
+/// \param left: the left operand
+/// \param right: the right operand
+/// \return the result of the comparison
+bool runtime::compare(std::uint32_t op, object *left, object *right) {
+    if (left->type == o_num && right->type == o_num)
+        return num_compare(op, std::get<double>(left->store), std::get<double>(right->store));
+    return std::get<bool>(binary(op, left, right)->store);
+}
+
+/// `.at()` with a num index, without creating an object for the index
+/// of an arr
+/// \param target: the object indexed
+/// \param index: the index
+/// \return the element
+object *runtime::at(object *target, double index) {
+    if (target->type == o_arr) {
+        const std::vector<object *> &items = target->as_arr();
+        if (index >= 0 && index < (double) items.size() && index == (int) index)
+            return items[(std::size_t) index];
+    }
+    return target->at(num(index));
+}
+
+/// `.len()` as a num
+/// \param target: the object
+/// \return the length
+double runtime::len(object *target) {
+    if (target->type == o_arr)
+        return (double) target->as_arr().size();
+    if (target->type == o_str)
+        return (double) std::get<std::string>(target->store).size();
+    return std::get<double>(target->len()->store);
+}
+
+/// calls a builtin method on its target
+/// \param name: the method, e.g. s_push
+/// \param target: the object the method is called on
+/// \param args: the arguments, as many as the method takes
+/// \param count: the number of arguments, which only `sub` varies
+/// \return the value of the method
+object *runtime::method(std::uint32_t name, object *target, object **args, std::size_t count) {
+    switch (name) {
+        case s_push:
+            return target->push(args[0]);
+        case s_pop:
+            return target->pop();
+        case s_len:
+            return target->len();
+        case s_empty:
+            return target->empty();
+        case s_find:
+            return target->find(args[0]);
+        case s_reverse:
+            return target->reverse();
+        case s_fill:
+            return target->fill(args[0], args[1], args[2]);
+        case s_at:
+            return target->at(args[0]);
+        case s_next:
+            return target->next();
+        case s_last:
+            return target->last();
+        case s_sub:
+            return count == 0 ? target->sub() : count == 1 ? target->sub(args[0]) : count == 2 ?
+                    target->sub(args[0], args[1]) : target->sub(args[0], args[1], args[2]);
+        case s_clear:
+            return target->clear();
+        default:
+            return target->sort();
+    }
+}
+
+/// calls a library function whose argument count is checked
+/// \param name: s_floor, s_ceil, s_round or s_rand
+/// \param args: the arguments
+/// \return the value of the function
+object *runtime::library(std::uint32_t name, object **args) {
+    if (name == s_floor)
+        return args[0]->floor();
+    if (name == s_ceil)
+        return args[0]->ceil();
+    if (name == s_round)
+        return args[0]->round(args[1]);
+    return object::rand();
+}
+
+/// copies a value, as a parameter or a returned value is copied
+/// \param val: the value
+/// \return the copy
+object *runtime::copy(object *val) {
+    object *ret = new object(val->type);
+    ret->assign(val);
+    return ret;
+}
+
+/// \param val: a num
+/// \return a new num object
+object *runtime::num(double val) {
+    object *ret = new object(o_num);
+    ret->store = val;
+    return ret;
+}
+
+/// \param val: a bool
+/// \return a new bool object
+object *runtime::boolean(bool val) {
+    object *ret = new object(o_bool);
+    ret->store = val;
+    return ret;
+}
+
+/// \param val: a str
+/// \return a new str object
+object *runtime::str(const std::string &val) {
+    object *ret = new object(o_str);
+    ret->store = val;
+    return ret;
+}
+
+/// \param val: a num
+/// \return the num as `out` prints it: without decimals if it is an
+///         integer
+std::string runtime::num_str(double val) {
+    return val == static_cast<int>(val) ? std::to_string((int) val) : std::to_string(val);
+}
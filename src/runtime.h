@@ -0,0 +1,129 @@
+/*
+ * runtime.h contains:
+ *   - Declarations for the runtime shared by the engines and by
+ *     programs compiled to C++
+ */
+
+#ifndef QI_INTERPRETER_RUNTIME_H
+#define QI_INTERPRETER_RUNTIME_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+#include "keywords.h"
+#include "object.h"
+#include "symbol.h"
+#include "util.h"
+#include "value.h"
+
+/// the parts of running a program that are not methods of an object:
+/// declaring variables, reading input, the num fast paths and the num
+/// format. The tree walker, the VM and programs compiled with
+/// `--emit-cpp` all run on it, which keeps their output the same; a
+/// compiled program only links this, the object class and the error
+/// util
+class runtime {
+public:
+    using binary_op = object *(object::*)(object *);
+
+    static const std::array<binary_op, s_count> operators;
+
+    [[noreturn]] static void fail(const std::string &message);
+
+    [[noreturn]] static void fail(const std::string &message, int line);
+
+    // the lowest address calls may take the native stack to
+    static char *stack_floor;
+
+    static void run_on_stack(std::size_t size, void (*body)());
+
+    static object *make(std::uint32_t keyword);
+
+    static void read(object *var, int line);
+
+    static double read_num(int line);
+
+    static std::string read_str();
+
+    static std::uint32_t compound_base(std::uint32_t op);
+
+    static bool arithmetic(std::uint32_t op);
+
+    static bool comparison(std::uint32_t op);
+
+    static bool num_operator(std::uint32_t op);
+
+    static double num_value(std::uint32_t op, double a, double b);
+
+    static bool num_compare(std::uint32_t op, double a, double b);
+
+    static object *num_binary(std::uint32_t op, object *left, object *right);
+
+    static value apply(std::uint32_t op, value left, value right);
+
+    static bool compare(std::uint32_t op, object *left, object *right);
+
+    static object *at(object *target, double index);
+
+    static double len(object *target);
+
+    static object *method(std::uint32_t name, object *target, object **args, std::size_t count);
+
+    static object *library(std::uint32_t name, object **args);
+
+    static object *copy(object *val);
+
+    static object *num(double val);
+
+    static object *boolean(bool val);
+
+    static object *str(const std::string &val);
+
+    static std::string num_str(double val);
+
+    /// \param op: a binary operator of the operator table
+    /// \param left: the left operand
+    /// \param right: the right operand
+    /// \return the result of the object method of the operator
+    static object *binary(std::uint32_t op, object *left, object *right) {
+        return (left->*operators[op])(right);
+    }
+
+    /// raises a stack overflow before a call if the native stack is
+    /// nearly used up
+    /// \param line: the line of the call
+    static void check_stack(int line) {
+        if (static_cast<char *>(__builtin_frame_address(0)) < stack_floor)
+            fail("stack overflow", line);
+    }
+
+    /// \param obj: any object
+    /// \return whether the object is true in a condition
+    static bool truth(object *obj) {
+        return std::get<bool>(obj->to_bool()->store);
+    }
+
+    /// \param val: any value
+    /// \return whether the value is true in a condition, without creating
+    /// an object for a num or a bool
+    static bool truth(value val) {
+        if (val.type() == o_bool)
+            return val.boolean();
+        if (val.type() == o_num)
+            return val.number() != 0;
+        return val.is_obj() && truth(val.obj());
+    }
+};
+
+#endif //QI_INTERPRETER_RUNTIME_H
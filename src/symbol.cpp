@@ -0,0 +1,48 @@
+/*
+ * symbol.cpp contains:
+ *   - Definitions for the symbol interner
+ */
+
+#include "symbol.h"
+#include "keywords.h"
+
+// static vars
+std::deque <std::string> symbol::names = [] {
+    std::deque <std::string> builtin_names;
+    for (const keyword &k : keywords)
+        builtin_names.emplace_back(k.name);
+    return builtin_names;
+}();
+std::unordered_map <std::string_view, std::uint32_t> symbol::ids =
+        std::unordered_map<std::string_view, std::uint32_t>();
+
+/// finds the id of a string, assigning the next free id to strings
+/// that haven't been seen before; pre-assigned symbols are found
+/// through the keyword table
+/// \param name: the string
+/// \return the symbol id
+std::uint32_t symbol::intern(std::string_view name) {
+    std::uint32_t keyword = keyword_table.find(name);
+    if (keyword != s_count)
+        return keyword;
+    auto it = symbol::ids.find(name);
+    if (it != symbol::ids.end())
+        return it->second;
+    // deque keeps references stable, so the key can view the stored name
+    symbol::names.emplace_back(name);
+    auto id = (std::uint32_t) (symbol::names.size() - 1);
+    symbol::ids.emplace(symbol::names.back(), id);
+    return id;
+}
+
+/// \param id: a symbol id
+/// \return the string the id was interned from
+const std::string &symbol::str(std::uint32_t id) {
+    return symbol::names[id];
+}
+
+/// \return the number of symbols interned so far, which is one past
+///         the last id
+std::uint32_t symbol::count() {
+    return (std::uint32_t) symbol::names.size();
+}
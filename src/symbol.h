@@ -0,0 +1,125 @@
+/*
+ * symbol.h contains:
+ *   - Pre-assigned symbol ids for keywords, operators and builtins
+ *   - Declarations for the symbol interner
+ */
+
+#ifndef QI_INTERPRETER_SYMBOL_H
+#define QI_INTERPRETER_SYMBOL_H
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+/// ids of the symbols the interpreter itself refers to; they are
+/// interned in this order before any source is read, so every
+/// keyword, operator and builtin has a fixed id
+enum s_id : std::uint32_t {
+    s_blank,
+    s_group,
+    s_eof,
+    s_lb,
+    s_plus,
+    s_minus,
+    s_star,
+    s_star_star,
+    s_slash,
+    s_slash_slash,
+    s_eq_eq,
+    s_not_eq,
+    s_less,
+    s_less_eq,
+    s_greater,
+    s_greater_eq,
+    s_caret,
+    s_bar,
+    s_amp,
+    s_shift_right,
+    s_shift_left,
+    s_percent,
+    s_assign,
+    s_minus_eq,
+    s_plus_eq,
+    s_star_eq,
+    s_star_star_eq,
+    s_slash_eq,
+    s_slash_slash_eq,
+    s_percent_eq,
+    s_shift_right_eq,
+    s_shift_left_eq,
+    s_amp_eq,
+    s_bar_eq,
+    s_caret_eq,
+    s_comma,
+    s_and,
+    s_not,
+    s_or,
+    s_if,
+    s_elsif,
+    s_else,
+    s_start,
+    s_end,
+    s_break,
+    s_continue,
+    s_while,
+    s_for,
+    s_of,
+    s_in,
+    s_out,
+    s_outl,
+    s_return,
+    s_fn,
+    s_num,
+    s_bool,
+    s_str,
+    s_arr,
+    s_map,
+    s_set,
+    s_queue,
+    s_stack,
+    s_lparen,
+    s_rparen,
+    s_dot,
+    s_none,
+    s_floor,
+    s_ceil,
+    s_round,
+    s_rand,
+    s_main,
+    s_range,
+    s_push,
+    s_pop,
+    s_len,
+    s_empty,
+    s_find,
+    s_reverse,
+    s_fill,
+    s_at,
+    s_next,
+    s_last,
+    s_sub,
+    s_clear,
+    s_sort,
+    s_zero,
+    s_count
+};
+
+/// the symbol interner maps every distinct string in a program to a
+/// 32-bit id, so that the rest of the interpreter compares and hashes
+/// integers instead of strings
+class symbol {
+private:
+    static std::deque <std::string> names;
+    static std::unordered_map <std::string_view, std::uint32_t> ids;
+
+public:
+    static std::uint32_t intern(std::string_view name);
+
+    static const std::string &str(std::uint32_t id);
+
+    static std::uint32_t count();
+};
+
+#endif //QI_INTERPRETER_SYMBOL_H
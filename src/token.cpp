@@ -1,115 +1,17 @@
 /*
  * token.cpp contains:
  *   - Definitions for the token class
+ *   - Definitions for the token span and the token buffer
  */
 
 #include "token.h"
 
-// static vars
-std::unordered_map <std::string, std::pair<int, int>> token::builtins =
-        std::unordered_map < std::string, std::pair<int, int>>
-();
-std::unordered_set <std::string> token::control = std::unordered_set<std::string>();
-std::unordered_set <std::string> token::vars = std::unordered_set<std::string>();
-std::unordered_set <std::string> token::methods = std::unordered_set<std::string>();
-int token::pre_none = 12;
-
-/// initializes all static variables
-void token::init() {
-    // structure: first -> ops, second -> precedence
-    token::builtins.insert({"+", {2, 5}});
-    token::builtins.insert({"-", {2, 5}});
-    token::builtins.insert({"*", {2, 6}});
-    token::builtins.insert({"**", {2, 7}});
-    token::builtins.insert({"/", {2, 6}});
-    token::builtins.insert({"//", {2, 6}});
-    token::builtins.insert({"==", {2, 3}});
-    token::builtins.insert({"!=", {2, 3}});
-    token::builtins.insert({"<", {2, 3}});
-    token::builtins.insert({"<=", {2, 3}});
-    token::builtins.insert({">", {2, 3}});
-    token::builtins.insert({">=", {2, 3}});
-    token::builtins.insert({"^", {2, 9}});
-    token::builtins.insert({"|", {2, 10}});
-    token::builtins.insert({"&", {2, 10}});
-    token::builtins.insert({">>", {2, 7}});
-    token::builtins.insert({"<<", {2, 7}});
-    token::builtins.insert({"%", {2, 6}});
-    token::builtins.insert({"=", {2, 1}});
-    token::builtins.insert({"-=", {2, 1}});
-    token::builtins.insert({"+=", {2, 1}});
-    token::builtins.insert({"*=", {2, 1}});
-    token::builtins.insert({"**=", {2, 1}});
-    token::builtins.insert({"/=", {2, 1}});
-    token::builtins.insert({"//=", {2, 1}});
-    token::builtins.insert({"%=", {2, 1}});
-    token::builtins.insert({">>=", {2, 1}});
-    token::builtins.insert({"<<=", {2, 1}});
-    token::builtins.insert({"&=", {2, 1}});
-    token::builtins.insert({"|=", {2, 1}});
-    token::builtins.insert({"^=", {1, 2}});
-    token::builtins.insert({",", {2, 2}});
-    token::builtins.insert({"and", {2, 11}});
-    token::builtins.insert({"not", {1, 4}});
-    token::builtins.insert({"or", {2, 12}});
-    token::builtins.insert({"if", {2, 2 * token::pre_none}});
-    token::builtins.insert({"elsif", {2, 2 * token::pre_none}});
-    token::builtins.insert({"else", {1, 2 * token::pre_none}});
-    token::builtins.insert({"start", {0, 2 * token::pre_none}});
-    token::builtins.insert({"end", {0, 2 * token::pre_none}});
-    token::builtins.insert({"break", {0, 2 * token::pre_none}});
-    token::builtins.insert({"continue", {0, 2 * token::pre_none}});
-    token::builtins.insert({"while", {2, 2 * token::pre_none}});
-    token::builtins.insert({"for", {2, 2 * token::pre_none}});
-    token::builtins.insert({"of", {2, -1}});
-    token::builtins.insert({"in", {1, 0}});
-    token::builtins.insert({"out", {1, 0}});
-    token::builtins.insert({"outl", {1, 0}});
-    token::builtins.insert({"return", {1, 0}});
-    token::builtins.insert({"fn", {4, 2 * token::pre_none}});
-    token::builtins.insert({"num", {1, 0}});
-    token::builtins.insert({"bool", {1, 0}});
-    token::builtins.insert({"str", {1, 0}});
-    token::builtins.insert({"arr", {1, 0}});
-    token::builtins.insert({"map", {1, 0}});
-    token::builtins.insert({"set", {1, 0}});
-    token::builtins.insert({"queue", {1, 0}});
-    token::builtins.insert({"stack", {1, 0}});
-    token::builtins.insert({"(", {0, 2 * token::pre_none}});
-    token::builtins.insert({")", {0, 2 * token::pre_none}});
-    token::builtins.insert({".", {2, 8}});
-
-    // control structure keywords
-    token::control.insert("if");
-    token::control.insert("elsif");
-    token::control.insert("else");
-    token::control.insert("for");
-    token::control.insert("while");
-
-    // variable types
-    token::vars.insert("num");
-    token::vars.insert("bool");
-    token::vars.insert("str");
-    token::vars.insert("arr");
-    token::vars.insert("map");
-    token::vars.insert("set");
-    token::vars.insert("queue");
-    token::vars.insert("stack");
-    token::vars.insert("none");
-
-    // builtin functions
-    token::methods.insert("floor");
-    token::methods.insert("ceil");
-    token::methods.insert("round");
-    token::methods.insert("rand");
-}
-
 /// parameterized constructor
-/// \param _val: val
+/// \param _val: symbol id of the val
 /// \param _line: line number
 /// \param _type: token type
 /// \param _ops: number of sub ops
-token::token(std::string _val, int _line, t_type _type, int _ops) {
+token::token(std::uint32_t _val, int _line, t_type _type, int _ops) {
     val = _val;
     line = _line;
     type = _type;
@@ -120,11 +22,107 @@ token::token(std::string _val, int _line, t_type _type, int _ops) {
 /// \return the string reprsentation of the token
 std::string token::str() const {
     std::stringstream ret;
-    ret << "<token: \"" << val << "\", " << line << ", " << type << ", " << ops << ">";
+    ret << "<token: \"" << symbol::str(val) << "\", " << line << ", " << (int) type << ", " << ops << ">";
     return ret.str();
 }
 
 /// overloaded assignment operator
 /// \param other: the object to copy
 /// \return reference to this token
-token &token::operator=(const token &other) = default;
\ No newline at end of file
+token &token::operator=(const token &other) = default;
+
+/// empty token span
+token_span::token_span() {
+    data = nullptr;
+    jumps = nullptr;
+    len = 0;
+}
+
+/// parameterized constructor
+/// \param _data: the first token
+/// \param _jumps: the partner distances of the tokens, or nullptr if
+///                the tokens have no partners
+/// \param _len: the number of tokens
+token_span::token_span(const token *_data, const int *_jumps, int _len) {
+    data = _data;
+    jumps = _jumps;
+    len = _len;
+}
+
+/// \return the number of tokens in the span
+int token_span::size() const {
+    return len;
+}
+
+/// \return whether the span has no tokens
+bool token_span::empty() const {
+    return len == 0;
+}
+
+/// \param i: the index into the span
+/// \return the token at i
+const token &token_span::operator[](int i) const {
+    return data[i];
+}
+
+/// \return the first token
+const token &token_span::front() const {
+    return data[0];
+}
+
+/// \return the last token
+const token &token_span::back() const {
+    return data[len - 1];
+}
+
+/// returns the sub-span within the range start to end, inclusive
+/// \param start: the start index
+/// \param end: the end index
+/// \return tokens[start:end + 1]
+token_span token_span::sub(int start, int end) const {
+    return {data + start, jumps ? jumps + start : nullptr, std::max(end - start + 1, 0)};
+}
+
+/// finds the partner of a bracket or block keyword within this span
+/// \param i: the index of a `(`, `)`, `start` or `end`
+/// \return the index of its partner, or -1 if it is unpaired within
+///         the span
+int token_span::partner(int i) const {
+    if (!jumps || jumps[i] == 0)
+        return -1;
+    int j = i + jumps[i];
+    return (j >= 0 && j < len) ? j : -1;
+}
+
+token_buffer::token_buffer() = default;
+
+/// takes ownership of the tokens and pairs up brackets and blocks
+/// \param _tokens: the token sequence from the lexer
+token_buffer::token_buffer(std::vector <token> _tokens) {
+    tokens = std::move(_tokens);
+    jumps.assign(tokens.size(), 0);
+    std::vector<int> brackets, blocks;
+    for (int i = 0; i < (int) tokens.size(); ++i) {
+        std::vector<int> *open = nullptr;
+        // nothing is paired across an EOF token, since the parser
+        // never scans past one
+        if (tokens[i].type == t_eof)
+            brackets.clear(), blocks.clear();
+        else if (tokens[i].val == s_lparen || tokens[i].val == s_start)
+            (tokens[i].val == s_lparen ? brackets : blocks).push_back(i);
+        else if (tokens[i].val == s_rparen)
+            open = &brackets;
+        else if (tokens[i].val == s_end)
+            open = &blocks;
+        if (open && !open->empty()) {
+            jumps[open->back()] = i - open->back();
+            jumps[i] = open->back() - i;
+            open->pop_back();
+        }
+    }
+}
+
+/// \return a span over every token
+token_span token_buffer::span() const {
+    return {tokens.data(), jumps.data(), (int) tokens.size()};
+}
@@ -2,19 +2,23 @@
  * token.h contains:
  *   - Token types as enumerators
  *   - Declaration for the token class
+ *   - Declarations for the token span and the token buffer
  */
 
 #ifndef QI_INTERPRETER_TOKEN_H
 #define QI_INTERPRETER_TOKEN_H
 
+#include <algorithm>
+#include <cstdint>
 #include <string>
 #include <sstream>
-#include <unordered_map>
-#include <unordered_set>
 #include <utility>
 #include <vector>
 
-enum t_type {
+#include "keywords.h"
+#include "symbol.h"
+
+enum t_type : unsigned char {
     t_none,
     t_group,
     t_builtin,
@@ -25,24 +29,100 @@ enum t_type {
     t_eof
 };
 
-/// token object
+/// token object; the value is held as an interned symbol id
 class token {
 public:
-    static std::unordered_map <std::string, std::pair<int, int>> builtins;
-    static std::unordered_set <std::string> control, vars, methods;
-    static int pre_none;
+    static constexpr int pre_none = 12;
 
-    std::string val;
+    std::uint32_t val;
+    int line;
     t_type type;
-    int ops, line;
+    short ops;
+
+    /// \param id: a symbol id
+    /// \return whether the symbol is in the given keyword category
+    static constexpr bool is(std::uint32_t id, k_category category) {
+        return id < s_count && (keywords[id].category & category);
+    }
+
+    static constexpr bool is_builtin(std::uint32_t id) {
+        return is(id, k_builtin);
+    }
+
+    static constexpr bool is_control(std::uint32_t id) {
+        return is(id, k_control);
+    }
+
+    static constexpr bool is_var(std::uint32_t id) {
+        return is(id, k_var);
+    }
+
+    static constexpr bool is_method(std::uint32_t id) {
+        return is(id, k_method);
+    }
+
+    /// \param id: the symbol id of a builtin
+    /// \return the number of operands of the builtin
+    static constexpr int arity(std::uint32_t id) {
+        return keywords[id].ops;
+    }
 
-    static void init();
+    /// \param id: the symbol id of a builtin
+    /// \return the precedence of the builtin
+    static constexpr int precedence(std::uint32_t id) {
+        return keywords[id].pre;
+    }
 
-    explicit token(std::string _val = "", int _line = -1, t_type _type = t_none, int _ops = 0);
+    explicit token(std::uint32_t _val = s_blank, int _line = -1, t_type _type = t_none, int _ops = 0);
 
     std::string str() const;
 
     token &operator=(const token &other);
 };
 
+/// a read-only view of a contiguous range of the token buffer, so the
+/// parser can hand sub-ranges to child nodes without copying tokens;
+/// `jumps` runs alongside the tokens and holds, for each bracket and
+/// block keyword, the distance to its partner (0 if unpaired)
+class token_span {
+private:
+    const token *data;
+    const int *jumps;
+    int len;
+
+public:
+    token_span();
+
+    token_span(const token *_data, const int *_jumps, int _len);
+
+    int size() const;
+
+    bool empty() const;
+
+    const token &operator[](int i) const;
+
+    const token &front() const;
+
+    const token &back() const;
+
+    token_span sub(int start, int end) const;
+
+    int partner(int i) const;
+};
+
+/// owns the token sequence of a program together with the partner of
+/// every `(`/`)` and `start`/`end`, which are matched once up front
+class token_buffer {
+private:
+    std::vector <token> tokens;
+    std::vector<int> jumps;
+
+public:
+    token_buffer();
+
+    explicit token_buffer(std::vector <token> _tokens);
+
+    token_span span() const;
+};
+
 #endif //QI_INTERPRETER_TOKEN_H
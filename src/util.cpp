@@ -2,10 +2,15 @@
  * util.cpp contains:
  *   - Print util definition
  *   - Error util (overloaded) definition
+ *   - Deferred error definitions
  */
 
 #include "util.h"
 
+// whether errors on this thread are deferred; a deferred error has
+// line -1 without a line number and -2 without a message
+static thread_local bool deferred = false;
+
 void out() {
     std::cout << "[empty info]" << std::endl;
 }
@@ -15,16 +20,52 @@ void out(std::string message) {
 }
 
 void err() {
+    if (deferred)
+        throw deferred_error{"", -2, ""};
     std::cout << "\033[1;31m" << "[empty error]" << "\033[0m" << std::endl;
     exit(1);
 }
 
 void err(std::string message) {
+    if (deferred)
+        throw deferred_error{message, -1, ""};
     std::cout << "\033[1;31m" << "[error]" << "\033[0m" << " " << message << std::endl;
     exit(1);
 }
 
 void err(std::string message, int line_number) {
+    if (deferred)
+        throw deferred_error{message, line_number, ""};
     std::cout << "\033[1;31m" << "[error, line: " << line_number << "]" << "\033[0m" << " " << message << std::endl;
     exit(1);
+}
+
+/// prints output, then the error
+/// \param message: the error message
+/// \param line_number: the line of the error
+/// \param output: printed before the error
+void err(std::string message, int line_number, const std::string &output) {
+    if (deferred)
+        throw deferred_error{message, line_number, output};
+    std::cout << output;
+    err(message, line_number);
+}
+
+/// prints the error as `err` would have when it was raised, and exits
+void deferred_error::report() const {
+    if (line == -2)
+        err();
+    else if (line == -1)
+        err(message);
+    err(message, line, output);
+    exit(1);
+}
+
+error_scope::error_scope() {
+    outer = deferred;
+    deferred = true;
+}
+
+error_scope::~error_scope() {
+    deferred = outer;
 }
\ No newline at end of file
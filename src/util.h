@@ -2,6 +2,7 @@
  * util.h contains:
  *   - Print util
  *   - Error util (overloaded)
+ *   - Deferred errors, for work done off the main thread
  */
 
 #ifndef QI_INTERPRETER_UTIL_H
@@ -21,4 +22,29 @@ void err(std::string message);
 
 void err(std::string message, int line_number);
 
+void err(std::string message, int line_number, const std::string &output);
+
+/// an error raised while errors are deferred on the current thread;
+/// output is anything that would have been printed before it
+class deferred_error {
+public:
+    std::string message;
+    int line;
+    std::string output;
+
+    [[noreturn]] void report() const;
+};
+
+/// defers errors on the current thread for as long as it is alive:
+/// instead of printing and exiting, `err` throws a deferred_error
+class error_scope {
+private:
+    bool outer;
+
+public:
+    error_scope();
+
+    ~error_scope();
+};
+
 #endif //QI_INTERPRETER_UTIL_H
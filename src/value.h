@@ -0,0 +1,185 @@
+/*
+ * value.h contains:
+ *   - Declarations and definitions for the NaN-boxed value
+ */
+
+#ifndef QI_INTERPRETER_VALUE_H
+#define QI_INTERPRETER_VALUE_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "object.h"
+
+/// a value of the language in 64 bits. A num is its double; a bool, a
+/// none and a pointer to an object are NaNs whose top 16 bits tag them,
+/// which no arithmetic produces, so that nums, bools and none are passed
+/// around without an object. Anything else, and every variable, is an
+/// object the value points to
+class value {
+private:
+    std::uint64_t bits;
+
+    static constexpr std::uint64_t tag_obj = 0xFFF9000000000000;
+    static constexpr std::uint64_t tag_bool = 0xFFFA000000000000;
+    static constexpr std::uint64_t tag_none = 0xFFFB000000000000;
+    static constexpr std::uint64_t payload = 0x0000FFFFFFFFFFFF;
+
+    explicit value(std::uint64_t _bits) : bits(_bits) {}
+
+    /// \return the tag of a value that is not a num
+    std::uint64_t tag() const {
+        return bits & ~payload;
+    }
+
+public:
+    /// a none
+    value() : bits(tag_none) {}
+
+    /// \param val: a num; a NaN with the bits of a tag becomes the NaN
+    /// that arithmetic produces
+    /// \return the num
+    static value num(double val) {
+        std::uint64_t b;
+        std::memcpy(&b, &val, sizeof(b));
+        if ((b >> 48) - (tag_obj >> 48) < 3)
+            b = 0xFFF8000000000000;
+        return value(b);
+    }
+
+    /// \param val: a bool
+    /// \return the bool
+    static value boolean(bool val) {
+        return value(tag_bool | (std::uint64_t) val);
+    }
+
+    /// \param obj: an object, which the value refers to and does not copy
+    /// \return the value of the object
+    static value of(object *obj) {
+        return value(tag_obj | reinterpret_cast<std::uintptr_t>(obj));
+    }
+
+    bool is_num() const {
+        return (bits >> 48) - (tag_obj >> 48) >= 3;
+    }
+
+    bool is_bool() const {
+        return tag() == tag_bool;
+    }
+
+    bool is_none() const {
+        return bits == tag_none;
+    }
+
+    bool is_obj() const {
+        return tag() == tag_obj;
+    }
+
+    /// \return the object of a value that refers to one
+    object *obj() const {
+        return reinterpret_cast<object *>(bits & payload);
+    }
+
+    /// \return the type of the value, or of the object it refers to
+    o_type type() const {
+        if (is_num())
+            return o_num;
+        if (is_obj())
+            return obj()->type;
+        return is_bool() ? o_bool : o_none;
+    }
+
+    /// \return the num of a value whose type is num
+    double number() const {
+        if (is_obj())
+            return std::get<double>(obj()->store);
+        double val;
+        std::memcpy(&val, &bits, sizeof(val));
+        return val;
+    }
+
+    /// \return the bool of a value whose type is bool
+    bool boolean() const {
+        if (is_obj())
+            return std::get<bool>(obj()->store);
+        return bits & 1;
+    }
+
+    /// \return the object the value refers to, or a new object holding
+    /// a num, a bool or a none
+    object *box() const {
+        if (is_obj())
+            return obj();
+        object *ret = new object(type());
+        if (is_num())
+            ret->store = number();
+        else if (is_bool())
+            ret->store = boolean();
+        return ret;
+    }
+
+    /// assigns the value to an object, as `=` does
+    /// \param target: the object assigned to
+    void assign(object *target) const {
+        if (is_obj()) {
+            target->assign(obj());
+            return;
+        }
+        // a num or a bool of the type of the target, or any of them to an
+        // undeclared object, is stored without an object for the value
+        if (!is_none() && (target->type == type() || target->type == o_none)) {
+            target->type = type();
+            if (is_num())
+                target->store = number();
+            else
+                target->store = boolean();
+            return;
+        }
+        object tmp(type());
+        if (is_num())
+            tmp.store = number();
+        else if (is_bool())
+            tmp.store = boolean();
+        target->assign(&tmp);
+    }
+
+    /// \return a new object with a copy of the value, as a parameter or
+    /// a returned value is copied
+    object *copy() const {
+        object *ret = new object(type());
+        assign(ret);
+        return ret;
+    }
+
+    /// \return the value as a returned value is kept: a num, a bool or a
+    /// none in place, and a copy of any other object
+    value own() const {
+        if (!is_obj())
+            return *this;
+        switch (obj()->type) {
+            case o_num:
+                return num(number());
+            case o_bool:
+                return boolean(boolean());
+            case o_none:
+                return value();
+            default:
+                return of(copy());
+        }
+    }
+
+    /// \return the value as `out` prints it
+    std::string str() const {
+        if (is_obj())
+            return obj()->str();
+        object tmp(type());
+        if (is_num())
+            tmp.store = number();
+        else if (is_bool())
+            tmp.store = boolean();
+        return tmp.str();
+    }
+};
+
+#endif //QI_INTERPRETER_VALUE_H
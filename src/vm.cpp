@@ -0,0 +1,384 @@
+/*
+ * vm.cpp contains:
+ *   - Definitions for the bytecode VM
+ */
+
+#include "vm.h"
+
+std::vector<value> vm::stack;
+std::vector<vm::frame> vm::frames;
+std::vector<std::string> vm::keys;
+
+/// calls a function whose parameters are already declared: its body
+/// is compiled on the first call, and runs on the tree walker if it
+/// couldn't be compiled
+/// \param fn: the function
+/// \return the value of the call
+value vm::call(object *fn) {
+    if (jit::hot(fn))
+        return value::of(jit::run(fn));
+    bytecode *code = fn->code();
+    if (!code->compiled)
+        return executor(fn->body(), fn).init();
+    return run(code, fn);
+}
+
+/// runs a compiled body in a new frame on top of the operand stack,
+/// along with every compiled body it calls
+/// \param code: the compiled body
+/// \param fn: the function
+/// \return the value of the call
+value vm::run(bytecode *code, object *fn) {
+    // the frames above entry belong to this run; a call that leaves the
+    // VM, e.g. to native code, starts a run of its own
+    std::size_t entry = frames.size();
+    const ast *tree = code->tree;
+    const instruction *begin = code->code.data(), *ip = begin;
+    std::size_t base = stack.size();
+    stack.resize(base + code->slots);
+    frames.push_back({fn, code, ip, base, 0, nullptr});
+    leave_flag flag = l_none;
+    value ret;
+    // whether the frame is left, and whether native code finished it,
+    // which validates how it returned
+    bool left = false, finished = false;
+    // the args of a builtin method or function, which take objects
+    object *objs[3];
+
+    for (;;) {
+        while (!left) {
+            const instruction &in = *ip++;
+            switch (in.op) {
+                case op_num: {
+                    stack.push_back(value::num(code->numbers[in.a]));
+                    break;
+                }
+                case op_str: {
+                    object *tmp = new object(o_str);
+                    tmp->set(symbol::str(in.a));
+                    stack.push_back(value::of(tmp));
+                    break;
+                }
+                case op_none: {
+                    stack.push_back(value());
+                    break;
+                }
+                // every operand is on the stack, which makes the end of a
+                // statement, a jump, the end of a loop pass and a call
+                // safe points to collect at
+                case op_pop: {
+                    stack.pop_back();
+                    gc::poll();
+                    break;
+                }
+                case op_jump: {
+                    gc::poll();
+                    // a loop that gets hot moves over to native code
+                    if (in.a <= ip - 1 - begin && jit::hot(fn)) {
+                        ret = value::of(jit::resume(fn, in.a, stack.data() + base));
+                        left = finished = true;
+                        break;
+                    }
+                    ip = begin + in.a;
+                    break;
+                }
+                case op_jump_false: {
+                    value cond = stack.back();
+                    stack.pop_back();
+                    if (!runtime::truth(cond))
+                        ip = begin + in.a;
+                    break;
+                }
+                case op_error: {
+                    if (in.b == bytecode::no_line)
+                        err(code->messages[in.a]);
+                    err(code->messages[in.a], tree->line(in.b));
+                    break;
+                }
+                case op_arity: {
+                    std::cout << (*tree)[in.b].count << std::endl;
+                    err("incorrect number of children for operation \"" + symbol::str((*tree)[in.b].val) + "\"",
+                        tree->line(in.b));
+                    break;
+                }
+                case op_declare: {
+                    // a type keyword without an identifier, e.g. `none`, is
+                    // passed alone and rejected by the declaration
+                    std::uint32_t count = (*tree)[in.b].count;
+                    token decl[2] = {tree->val(in.b), count ? tree->val(in.b + 1) : token()};
+                    bool defined = count && memory::find((*tree)[in.b + 1].slot);
+                    object *obj = interpreter::declare_obj(token_span(decl, nullptr, count ? 2 : 1), defined);
+                    memory::local((*tree)[in.b + 1].slot) = obj;
+                    break;
+                }
+                case op_symbol: {
+                    const ast::node &n = (*tree)[in.b];
+                    if (object *obj = memory::find(n.slot)) {
+                        if (obj->type != o_fn) {
+                            stack.push_back(value::of(obj));
+                            ip = begin + in.a;
+                        } else if (obj->def->params.size() != n.count)
+                            // the tree walker reports the node type as the line
+                            err("incorrect number of children for function \"" + symbol::str(n.val) + "\"", n.type);
+                    } else if ((n.val == s_floor || n.val == s_ceil) && n.count != 1)
+                        err(symbol::str(n.val) + " requires 1 argument", tree->line(in.b));
+                    else if (n.val == s_round && n.count != 2)
+                        err("round requires 2 arguments", tree->line(in.b));
+                    else if (n.val == s_rand && n.count != 0)
+                        err("rand takes no arguments", tree->line(in.b));
+                    else if (!token::is_method(n.val))
+                        err("symbol \"" + symbol::str(n.val) + "\" is undefined", tree->line(in.b));
+                    break;
+                }
+                case op_tail_call: {
+                    // the callee runs in place of the function, which
+                    // then returns what the callee returns, unless it
+                    // returns another type
+                    gc::poll();
+                    const ast::node &n = (*tree)[in.b];
+                    object *callee = memory::find(n.slot);
+                    if (callee && callee->def->returns == fn->def->returns && fn->def->returns != o_none) {
+                        // the args may be locals of the frame, so they are
+                        // copied before the frame is cleared
+                        std::size_t args = stack.size() - n.count;
+                        for (int i = 0; i < callee->def->params.size(); ++i) {
+                            object *param = memory::acquire();
+                            stack[args + i].assign(param);
+                            if (param->type != callee->def->params[i].type)
+                                err("parameter types don't match", tree->line(tree->child(in.b, i)));
+                            stack[args + i] = value::of(param);
+                        }
+                        memory::reuse(callee->body()->frame, callee->def->params.size());
+                        for (int i = 0; i < callee->def->params.size(); ++i)
+                            memory::local(i) = stack[args + i].obj();
+                        fn = callee;
+                        code = fn->code();
+                        stack.resize(base);
+                        if (jit::hot(fn) || !code->compiled) {
+                            ret = code->compiled ? value::of(jit::run(fn)) : executor(fn->body(), fn).init();
+                            left = finished = true;
+                            break;
+                        }
+                        tree = code->tree;
+                        begin = ip = code->code.data();
+                        stack.resize(base + code->slots);
+                        frames.back() = {fn, code, ip, base, frames.back().memory, frames.back().table};
+                        break;
+                    }
+                }
+                [[fallthrough]];
+                case op_call: {
+                    gc::poll();
+                    const ast::node &n = (*tree)[in.b];
+                    std::size_t args = stack.size() - n.count;
+                    object *callee = memory::find(n.slot);
+                    if (!callee) {
+                        for (std::uint32_t i = 0; i < n.count; ++i)
+                            objs[i] = stack[args + i].box();
+                        object *res = runtime::library(n.val, objs);
+                        stack.resize(args);
+                        stack.push_back(value::of(res));
+                        break;
+                    }
+                    std::string key;
+                    if (callee->def->table)
+                        if (object *res = callee->def->table->find(stack.data() + args, n.count, key)) {
+                            stack.resize(args);
+                            stack.push_back(value::of(res));
+                            break;
+                        }
+                    // the frames, the operand stack and the locals are
+                    // bounded by the stack limit
+                    if (frames.size() * sizeof(frame) + stack.size() * sizeof(value) +
+                        memory::frames.size() * sizeof(object *) >
+                        (std::size_t) options::stack_limit << 20)
+                        err("stack overflow", tree->line(in.b));
+                    // the parameters take the first slots of the frame
+                    std::size_t prev = memory::push(callee->body()->frame, callee->def->params.size());
+                    for (int i = 0; i < callee->def->params.size(); ++i) {
+                        object *param = memory::acquire();
+                        stack[args + i].assign(param);
+                        if (param->type != callee->def->params[i].type)
+                            err("parameter types don't match", tree->line(tree->child(in.b, i)));
+                        memory::local(i) = param;
+                    }
+                    stack.resize(args);
+                    bytecode *body = callee->code();
+                    if (jit::hot(callee) || !body->compiled) {
+                        value res = body->compiled ? value::of(jit::run(callee)) : executor(callee->body(), callee).init();
+                        memory::pop(prev, fn->def->params.size(), res.is_obj() ? res.obj() : nullptr);
+                        if (callee->def->table)
+                            callee->def->table->store(std::move(key), res.box());
+                        stack.push_back(res);
+                        break;
+                    }
+                    if (callee->def->table)
+                        keys.push_back(std::move(key));
+                    // the callee runs on a frame of its own, and the
+                    // caller resumes after the call once it returns
+                    frames.back().ip = ip;
+                    fn = callee;
+                    code = body;
+                    tree = code->tree;
+                    begin = ip = code->code.data();
+                    base = stack.size();
+                    stack.resize(base + code->slots);
+                    frames.push_back({fn, code, ip, base, prev, callee->def->table});
+                    break;
+                }
+                case op_method: {
+                    std::size_t args = 0;
+                    if (in.a == s_push || in.a == s_find || in.a == s_at)
+                        args = 1;
+                    else if (in.a == s_fill)
+                        args = 3;
+                    else if (in.a == s_sub)
+                        args = (*tree)[in.b].count;
+                    std::size_t top = stack.size() - args;
+                    for (std::size_t i = 0; i < args; ++i)
+                        objs[i] = stack[top + i].box();
+                    object *res = runtime::method(in.a, stack[top - 1].box(), objs, args);
+                    stack.resize(top - 1);
+                    stack.push_back(value::of(res));
+                    break;
+                }
+                case op_binary:
+                case op_num_binary: {
+                    value rhs = stack.back();
+                    stack.pop_back();
+                    stack.back() = runtime::apply(in.a, stack.back(), rhs);
+                    break;
+                }
+                case op_not: {
+                    stack.back() = value::boolean(!runtime::truth(stack.back()));
+                    break;
+                }
+                case op_out: {
+                    std::cout << stack.back().str();
+                    stack.back() = value();
+                    break;
+                }
+                case op_outl: {
+                    std::cout << stack.back().str() << std::endl;
+                    stack.back() = value();
+                    break;
+                }
+                case op_in: {
+                    runtime::read(stack.back().box(), tree->line(in.b));
+                    stack.back() = value();
+                    break;
+                }
+                case op_return: {
+                    ret = stack.back().own();
+                    stack.pop_back();
+                    flag = l_return;
+                    left = true;
+                    break;
+                }
+                case op_leave: {
+                    flag = (leave_flag) in.a;
+                    if (flag == l_none) {
+                        ret = stack.back();
+                        stack.pop_back();
+                    } else
+                        ret = value();
+                    left = true;
+                    break;
+                }
+                case op_check_int: {
+                    value arg = stack.back();
+                    if (!(arg.is_obj() ? arg.obj()->is_int() : arg.is_num() && arg.number() == (int) arg.number()))
+                        err("range arg must be integers", tree->line(in.b));
+                    break;
+                }
+                case op_for_enter: {
+                    std::uint32_t var = in.b + 2;
+                    if (memory::find((*tree)[var].slot))
+                        err("for loop variable already defined", tree->line(var));
+                    // the loop variable is put back on the free list once
+                    // the loop exits; the end and the step are nums
+                    object *it = memory::acquire();
+                    it->type = o_num;
+                    it->store = 0.0;
+                    // add the loop variable, e.g. `i` to the memory
+                    memory::local((*tree)[var].slot) = it;
+                    stack[base + in.a] = value::of(it);
+                    stack[base + in.a + 1] = value::num(0);
+                    stack[base + in.a + 2] = value::num(1);
+                    break;
+                }
+                case op_for_init: {
+                    std::uint32_t count = (*tree)[in.b].count;
+                    std::size_t top = stack.size() - count;
+                    object *it = stack[base + in.a].obj();
+                    double start = 0;
+                    if (count == 1)
+                        stack[base + in.a + 1] = value::num(stack[top].number());
+                    else {
+                        start = stack[top].number();
+                        stack[base + in.a + 1] = value::num(stack[top + 1].number());
+                        if (count == 3)
+                            stack[base + in.a + 2] = value::num(stack[top + 2].number());
+                    }
+                    stack.resize(top);
+                    // the range args may have assigned another type to
+                    // the loop variable
+                    it->type = o_num;
+                    it->store = start;
+                    break;
+                }
+                case op_for_test: {
+                    // the end is a num, and so is the loop variable
+                    // unless the body assigned another type to it
+                    object *it = stack[base + in.b].obj();
+                    if (it->type != o_num || !(std::get<double>(it->store) < stack[base + in.b + 1].number()))
+                        ip = begin + in.a;
+                    break;
+                }
+                case op_for_step: {
+                    gc::poll();
+                    object *it = stack[base + in.b].obj();
+                    if (it->type == o_num)
+                        std::get<double>(it->store) += stack[base + in.b + 2].number();
+                    else
+                        it->add_equal(stack[base + in.b + 2].box());
+                    if (jit::hot(fn)) {
+                        ret = value::of(jit::resume(fn, in.a, stack.data() + base));
+                        left = finished = true;
+                        break;
+                    }
+                    ip = begin + in.a;
+                    break;
+                }
+                case op_for_exit: {
+                    memory::local((*tree)[in.b + 2].slot) = nullptr;
+                    memory::recycle(stack[base + in.a].obj());
+                    break;
+                }
+            }
+        }
+        // the frame returns to its caller
+        stack.resize(base);
+        value res = finished ? ret : executor::leave(fn, flag, ret);
+        std::size_t prev = frames.back().memory;
+        if (memo *table = frames.back().table) {
+            table->store(std::move(keys.back()), res.box());
+            keys.pop_back();
+        }
+        frames.pop_back();
+        if (frames.size() == entry)
+            return res;
+        const frame &caller = frames.back();
+        memory::pop(prev, caller.fn->def->params.size(), res.is_obj() ? res.obj() : nullptr);
+        fn = caller.fn;
+        code = caller.code;
+        tree = code->tree;
+        begin = code->code.data();
+        ip = caller.ip;
+        base = caller.base;
+        stack.push_back(res);
+        ret = value();
+        flag = l_none;
+        left = finished = false;
+    }
+}
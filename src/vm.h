@@ -0,0 +1,64 @@
+/*
+ * vm.h contains:
+ *   - Declarations for the bytecode VM
+ */
+
+#ifndef QI_INTERPRETER_VM_H
+#define QI_INTERPRETER_VM_H
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "bytecode.h"
+#include "executor.h"
+#include "gc.h"
+#include "interpreter.h"
+#include "jit.h"
+#include "memo.h"
+#include "memory.h"
+#include "object.h"
+#include "runtime.h"
+#include "token.h"
+#include "util.h"
+#include "value.h"
+
+/// the stack VM runs the compiled bodies of functions on one dispatch
+/// loop. A call from one compiled body to another pushes a frame on an
+/// explicit frame stack on the heap instead of recursing on the native
+/// stack, so recursion is only bounded by `--stack-limit`. Every frame
+/// runs on one shared operand stack of values, as the tree walker
+/// evaluates to, so that nums, bools and none are never objects on it;
+/// the bottom part of the stack in each frame holds the slots of its
+/// for loops
+class vm {
+private:
+    friend class gc;
+
+    /// a call running on the VM: the function, its compiled body, the
+    /// instruction it resumes at once its callee returns, the bottom of
+    /// its part of the operand stack, the memory frame of its caller,
+    /// and the memo table its value is kept in, if any
+    struct frame {
+        object *fn;
+        bytecode *code;
+        const instruction *ip;
+        std::size_t base;
+        std::size_t memory;
+        memo *table;
+    };
+
+    static std::vector<value> stack;
+    static std::vector<frame> frames;
+    // the keys of the running memoized calls, in the order of their
+    // frames
+    static std::vector<std::string> keys;
+
+    static value run(bytecode *code, object *fn);
+
+public:
+    static value call(object *fn);
+};
+
+#endif //QI_INTERPRETER_VM_H
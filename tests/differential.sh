@@ -0,0 +1,359 @@
+#!/usr/bin/bash
+
+
+RED="\033[0;31m"
+BLUE="\033[0;34m"
+NC="\033[0m"
+QI="./build/qi"
+PROGRAMS=$(ls -1 examples/*.qi tests/*/code.qi)
+failed_tests=0
+
+# compares the output and exit code of two runs of the same program
+# \param $1: label for the comparison
+# \param $2: program file
+# \param $3, $4: args of the reference run and the tested run
+# \param $5: input of both runs, empty by default
+# runs are cut off after a few seconds, as some examples never finish
+compare() {
+    input=${5:-/dev/null}
+    expected=$(timeout 5 $QI $3 "$2" < "$input" 2>&1; echo "exit: $?")
+    actual=$(timeout 5 $QI $4 "$2" < "$input" 2>&1; echo "exit: $?")
+    if [[ "$expected" != "$actual" ]]; then
+        echo -e "$RED[error]$NC $1: $2 differs"
+        diff <(echo "$expected") <(echo "$actual") | head -n 10
+        failed_tests=$(( $failed_tests + 1 ))
+    fi
+}
+
+# lexer: the table-driven lexer must produce the regex lexer's tokens
+echo -e "$BLUE[info]$NC comparing token streams of the dfa and regex lexers"
+for program in $PROGRAMS
+do
+    compare "lexer" "$program" "--tokens --lexer=regex" "--tokens --lexer=dfa"
+done
+
+# parser: the precedence-climbing parser must build the syntax trees of
+# the reference parser, which splits at the lowest-precedence operator
+echo -e "$BLUE[info]$NC comparing syntax trees of the pratt and scan parsers"
+for program in $PROGRAMS
+do
+    compare "parser" "$program" "--ast --parser=scan" "--ast --parser=pratt"
+done
+
+# lazy parsing: programs must run the same whether function bodies
+# are parsed at startup or on their first call
+echo -e "$BLUE[info]$NC comparing eager and lazy runs"
+for folder_name in tests/*/
+do
+    for input in "$folder_name"[0-9]*-in
+    do
+        compare "lazy" "${folder_name}code.qi" "" "--lazy" "$input"
+    done
+done
+
+# program cache: programs must run the same when started from a cache,
+# both on the run that writes it and on the run that loads it
+echo -e "$BLUE[info]$NC comparing runs with and without the program cache"
+CACHE=$(mktemp -d)
+for folder_name in tests/*/
+do
+    for input in "$folder_name"[0-9]*-in
+    do
+        compare "cold cache" "${folder_name}code.qi" "" "--cache=$CACHE" "$input"
+        compare "warm cache" "${folder_name}code.qi" "" "--cache=$CACHE" "$input"
+    done
+done
+for program in $PROGRAMS
+do
+    compare "cold cached tree" "$program" "--ast" "--ast --cache=$CACHE"
+    compare "warm cached tree" "$program" "--ast" "--ast --cache=$CACHE"
+done
+rm -rf "$CACHE"
+
+# engines: the bytecode VM must run every program as the tree walker
+# does; examples read a fixed list of numbers. The shell sort example
+# never ends for more than one number, so it is left out
+echo -e "$BLUE[info]$NC comparing runs on the tree walker and the bytecode VM"
+INPUT=$(mktemp)
+printf "5\n3\n1\n4\n1\n5\n9\n2\n6\n" > "$INPUT"
+for program in examples/*.qi
+do
+    [[ $program == */205_shell_sort.qi ]] && continue
+    compare "engine" "$program" "--engine=tree" "--engine=vm" "$INPUT"
+done
+rm -f "$INPUT"
+for folder_name in tests/*/
+do
+    for input in "$folder_name"[0-9]*-in
+    do
+        compare "engine" "${folder_name}code.qi" "--engine=tree" "--engine=vm" "$input"
+    done
+done
+
+# type checking: the num fast paths of checked bodies must compute what
+# the object methods do, on both engines; the examples have no type
+# errors, so the checker must not reject any of them
+echo -e "$BLUE[info]$NC comparing runs with dynamic and static types"
+INPUT=$(mktemp)
+printf "5\n3\n1\n4\n1\n5\n9\n2\n6\n" > "$INPUT"
+for ENGINE in tree vm
+do
+    for program in examples/*.qi
+    do
+        [[ $program == */205_shell_sort.qi ]] && continue
+        compare "types" "$program" "--engine=$ENGINE --types=dynamic" "--engine=$ENGINE --types=static" "$INPUT"
+    done
+    for folder_name in tests/*/
+    do
+        for input in "$folder_name"[0-9]*-in
+        do
+            compare "types" "${folder_name}code.qi" "--engine=$ENGINE --types=dynamic" \
+                "--engine=$ENGINE --types=static" "$input"
+        done
+    done
+done
+rm -f "$INPUT"
+
+# quickening: the tree walker must run the same with quickened nodes,
+# including nodes deoptimized when other operand types show up
+echo -e "$BLUE[info]$NC comparing runs with generic and quickened nodes"
+INPUT=$(mktemp)
+printf "5\n3\n1\n4\n1\n5\n9\n2\n6\n" > "$INPUT"
+for TYPES in dynamic static
+do
+    for program in examples/*.qi
+    do
+        [[ $program == */205_shell_sort.qi ]] && continue
+        compare "quickening" "$program" "--engine=tree --types=$TYPES --quicken=off" \
+            "--engine=tree --types=$TYPES --quicken=on" "$INPUT"
+    done
+    for folder_name in tests/*/
+    do
+        for input in "$folder_name"[0-9]*-in
+        do
+            compare "quickening" "${folder_name}code.qi" "--engine=tree --types=$TYPES --quicken=off" \
+                "--engine=tree --types=$TYPES --quicken=on" "$input"
+        done
+    done
+done
+rm -f "$INPUT"
+
+# jit: functions compiled to native code must run as the tree walker
+# runs them, whether they are compiled on their first call or once hot;
+# a low threshold moves VM frames over to native code in their loops
+echo -e "$BLUE[info]$NC comparing runs on the tree walker and the jit"
+INPUT=$(mktemp)
+printf "5\n3\n1\n4\n1\n5\n9\n2\n6\n" > "$INPUT"
+for JIT in "--jit=on --engine=tree" "--jit=on --engine=vm" "--jit=threshold --jit-threshold=2 --engine=tree" \
+    "--jit=threshold --jit-threshold=2 --engine=vm"
+do
+    for program in examples/*.qi
+    do
+        [[ $program == */205_shell_sort.qi ]] && continue
+        compare "jit" "$program" "--engine=tree" "$JIT" "$INPUT"
+    done
+    for folder_name in tests/*/
+    do
+        for input in "$folder_name"[0-9]*-in
+        do
+            compare "jit" "${folder_name}code.qi" "--engine=tree" "$JIT" "$input"
+        done
+    done
+done
+rm -f "$INPUT"
+
+# runs a program and samples its peak resident size from /proc while
+# it runs; a run is killed after 20 seconds
+# \param $1: program file
+# \param $2: input of the run
+# \param $3: file the output goes to
+# \param $4...: args of the run
+# prints the exit code and the peak resident size in KB
+peak_rss() {
+    local program=$1 input=$2 output=$3 pid peak=0 state rss polls=0
+    shift 3
+    $QI "$@" "$program" < "$input" > "$output" 2>&1 &
+    pid=$!
+    for (( ; ; ++polls ))
+    do
+        read -r state rss < <(awk '/^State/ { s = $2 } /^VmHWM/ { r = $2 } END { print s, r }' \
+            "/proc/$pid/status" 2>/dev/null)
+        [[ -z $state || $state == Z ]] && break
+        [[ -n $rss ]] && (( rss > peak )) && peak=$rss
+        (( polls == 400 )) && kill "$pid"
+        sleep 0.05
+    done
+    wait "$pid"
+    echo "$? $peak"
+}
+
+# tail calls: a tail-recursive loop runs in constant stack and frames,
+# so that 10^7 passes stay within a fixed resident size on the tree
+# walker and the VM, far below what a frame per pass takes. On native
+# code its passes create no objects, so that they fit in a fixed
+# address space
+echo -e "$BLUE[info]$NC running tail calls in bounded memory"
+OUTPUT=$(mktemp)
+for ENGINE in "--engine=tree" "--engine=vm"
+do
+    read -r code peak < <(peak_rss tests/tail_calls/code.qi tests/tail_calls/bounded-in "$OUTPUT" $ENGINE)
+    if [[ $code != 0 ]] || ! cmp -s tests/tail_calls/bounded-out "$OUTPUT" || (( peak > 131072 )); then
+        echo -e "$RED[error]$NC tail calls: tests/tail_calls/code.qi exceeds its memory bound $ENGINE"
+        echo "exit: $code, peak resident size: $peak KB"
+        failed_tests=$(( $failed_tests + 1 ))
+    fi
+    actual=$( (ulimit -v 65536; timeout 5 $QI --jit=on $ENGINE tests/tail_calls/code.qi \
+        < tests/tail_calls/bounded-in 2>&1); echo "exit: $?")
+    if [[ "$(cat tests/tail_calls/bounded-out; echo "exit: 0")" != "$actual" ]]; then
+        echo -e "$RED[error]$NC tail calls: tests/tail_calls/code.qi exceeds its memory bound --jit=on $ENGINE"
+        echo "$actual" | tail -n 5
+        failed_tests=$(( $failed_tests + 1 ))
+    fi
+done
+rm -f "$OUTPUT"
+
+# deep recursion: the VM keeps its calls on a frame stack on the heap,
+# so that 2 * 10^6 nested calls that are not tail calls run with a
+# stack limit of 128 MB, a native stack on which the tree walker only
+# gets about 130000 calls deep
+echo -e "$BLUE[info]$NC running deep recursion off the native stack"
+actual=$(timeout 20 $QI --engine=vm --stack-limit=128 tests/recursion/code.qi < tests/recursion/deep-in 2>&1; \
+    echo "exit: $?")
+if [[ "$(cat tests/recursion/deep-out; echo "exit: 0")" != "$actual" ]]; then
+    echo -e "$RED[error]$NC recursion: tests/recursion/code.qi does not recurse off the native stack --engine=vm"
+    echo "$actual" | tail -n 5
+    failed_tests=$(( $failed_tests + 1 ))
+fi
+
+# memoization: memoizing the pure functions of a program must not change
+# what it prints, even with a table that drops calls all the time; a
+# memoized function runs its exponential recursion in linear time
+echo -e "$BLUE[info]$NC comparing runs with and without memoization"
+INPUT=$(mktemp)
+printf "5\n3\n1\n4\n1\n5\n9\n2\n6\n" > "$INPUT"
+for ENGINE in tree vm
+do
+    for program in examples/*.qi
+    do
+        [[ $program == */205_shell_sort.qi ]] && continue
+        compare "memo" "$program" "--engine=$ENGINE" "--engine=$ENGINE --memo --memo-size=2" "$INPUT"
+    done
+    for folder_name in tests/*/
+    do
+        for input in "$folder_name"[0-9]*-in
+        do
+            compare "memo" "${folder_name}code.qi" "--engine=$ENGINE" "--engine=$ENGINE --memo --memo-size=2" "$input"
+        done
+    done
+    actual=$(timeout 5 $QI --engine=$ENGINE tests/memo/code.qi < tests/memo/big-in 2>&1; echo "exit: $?")
+    if [[ "$(cat tests/memo/big-out; echo "exit: 0")" != "$actual" ]]; then
+        echo -e "$RED[error]$NC memo: tests/memo/code.qi does not run in linear time --engine=$ENGINE"
+        echo "$actual" | tail -n 5
+        failed_tests=$(( $failed_tests + 1 ))
+    fi
+done
+rm -f "$INPUT"
+
+# garbage collection: collecting at every safe point must not change
+# what a program prints, on either engine or on native code; a loop
+# that creates about 10^7 temporaries runs in an address space that it
+# exceeds many times over without collections, native code included,
+# and with QI_LONG_TESTS set, one that creates about 10^8 does too
+echo -e "$BLUE[info]$NC comparing runs with and without a collection at every safe point"
+INPUT=$(mktemp)
+printf "5\n3\n1\n4\n1\n5\n9\n2\n6\n" > "$INPUT"
+for ENGINE in "--engine=tree" "--engine=vm" "--engine=vm --jit=threshold --jit-threshold=2" "--engine=vm --jit=on" \
+    "--engine=tree --jit=on"
+do
+    for program in examples/*.qi
+    do
+        [[ $program == */205_shell_sort.qi ]] && continue
+        compare "gc" "$program" "$ENGINE" "$ENGINE --gc-threshold=1" "$INPUT"
+    done
+    for folder_name in tests/*/
+    do
+        for input in "$folder_name"[0-9]*-in
+        do
+            compare "gc" "${folder_name}code.qi" "$ENGINE" "$ENGINE --gc-threshold=1" "$input"
+        done
+    done
+done
+rm -f "$INPUT"
+for ENGINE in "--engine=tree" "--engine=vm" "--engine=vm --jit=threshold" "--engine=vm --jit=on" \
+    "--engine=tree --jit=on"
+do
+    actual=$( (ulimit -v 262144; timeout 10 $QI $ENGINE tests/gc/code.qi < tests/gc/bounded-in 2>&1); echo "exit: $?")
+    if [[ "$(cat tests/gc/bounded-out; echo "exit: 0")" != "$actual" ]]; then
+        echo -e "$RED[error]$NC gc: tests/gc/code.qi exceeds its memory bound $ENGINE"
+        echo "$actual" | tail -n 5
+        failed_tests=$(( $failed_tests + 1 ))
+    fi
+done
+if [[ -n "$QI_LONG_TESTS" ]]; then
+    echo -e "$BLUE[info]$NC running about 10^8 temporaries in bounded memory"
+    for ENGINE in "--engine=tree" "--engine=vm" "--engine=vm --jit=threshold" "--engine=vm --jit=on" \
+        "--engine=tree --jit=on"
+    do
+        actual=$( (ulimit -v 262144; timeout 60 $QI $ENGINE tests/gc/code.qi < tests/gc/long-in 2>&1); echo "exit: $?")
+        if [[ "$(cat tests/gc/long-out; echo "exit: 0")" != "$actual" ]]; then
+            echo -e "$RED[error]$NC gc: tests/gc/code.qi exceeds its memory bound on long-in $ENGINE"
+            echo "$actual" | tail -n 5
+            failed_tests=$(( $failed_tests + 1 ))
+        fi
+    done
+fi
+
+# compiled programs: a program translated with --emit-cpp and linked
+# against the runtime library must print what the interpreter prints.
+# A program that cannot be translated must fail at translation with
+# the error the interpreter raises before running it
+echo -e "$BLUE[info]$NC comparing interpreted runs and runs compiled to C++"
+AOT=$(mktemp -d)
+# \param $1: program file
+# \param $2...: inputs of the runs
+compare_aot() {
+    local program=$1 binary="$AOT/program" expected actual
+    shift
+    if $QI --emit-cpp "$program" > "$AOT/program.cpp" 2>&1; then
+        if ! $CXX -std=c++17 -O1 -Isrc "$AOT/program.cpp" build/libqi_runtime.a -o "$binary"; then
+            echo -e "$RED[error]$NC aot: $program does not compile"
+            failed_tests=$(( $failed_tests + 1 ))
+            return
+        fi
+    else
+        binary=""
+    fi
+    for input in "$@"
+    do
+        expected=$(timeout 5 $QI "$program" < "$input" 2>&1; echo "exit: $?")
+        if [[ -n $binary ]]; then
+            actual=$(timeout 5 "$binary" < "$input" 2>&1; echo "exit: $?")
+        else
+            actual=$(cat "$AOT/program.cpp"; echo "exit: 1")
+        fi
+        if [[ "$expected" != "$actual" ]]; then
+            echo -e "$RED[error]$NC aot: $program differs"
+            diff <(echo "$expected") <(echo "$actual") | head -n 10
+            failed_tests=$(( $failed_tests + 1 ))
+        fi
+    done
+}
+CXX=${CXX:-g++}
+printf "5\n3\n1\n4\n1\n5\n9\n2\n6\n" > "$AOT/input"
+for program in examples/*.qi
+do
+    [[ $program == */205_shell_sort.qi ]] && continue
+    compare_aot "$program" "$AOT/input"
+done
+for folder_name in tests/*/
+do
+    compare_aot "${folder_name}code.qi" "$folder_name"[0-9]*-in
+done
+rm -rf "$AOT"
+
+echo -e "$BLUE[info]$NC ran all differential tests"
+if [[ $failed_tests == 0 ]]; then
+    exit 0
+else
+    exit 1
+fi
@@ -6,6 +6,8 @@ BLUE="\033[0;34m"
 NC="\033[0m"
 TEST_FOLDER_NAME="tests"
 QI="../../build/qi"
+# every test runs under the tree walker and the bytecode vm
+ENGINES="tree vm"
 
 cd "$TEST_FOLDER_NAME"
 FOLDER_NAMES=$(ls -1 -d */)
@@ -14,27 +16,31 @@ failed_tests=0
 for folder_name in $FOLDER_NAMES
 do
     cd "$folder_name" || exit 1
-    test_number=1
+    total_test_count=0
     passed_test_count=0
     echo -e "$BLUE[info]$NC running tests for $folder_name"
 
-    while [[ -f "$test_number-in" ]] && [[ -f "$test_number-out" ]] && [[ -f "code.qi" ]]
+    for engine in $ENGINES
     do
-        $QI "code.qi" < "$test_number-in" > "$test_number-test" || ""
-        if ! cmp -s "$test_number-out" "$test_number-test"; then
-            echo -e "$RED[error]$NC $folder_name: test $test_number failed"
-            echo "expected contents ($folder_name$test_number-out):"
-            cat "$test_number-out" || exit 0
-            echo "actual contents ($folder_name$test_number-test):"
-            cat "$test_number-test" || exit 0
-            passed_test_count=$(( $passed_test_count - 1 ))
-            failed_tests=$(( $failed_tests + 1 ))
-        fi
-        test_number=$((test_number + 1))
+        test_number=1
+        while [[ -f "$test_number-in" ]] && [[ -f "$test_number-out" ]] && [[ -f "code.qi" ]]
+        do
+            $QI --engine="$engine" "code.qi" < "$test_number-in" > "$test_number-test" || ""
+            total_test_count=$(( $total_test_count + 1 ))
+            if ! cmp -s "$test_number-out" "$test_number-test"; then
+                echo -e "$RED[error]$NC $folder_name: test $test_number failed under --engine=$engine"
+                echo "expected contents ($folder_name$test_number-out):"
+                cat "$test_number-out" || exit 0
+                echo "actual contents ($folder_name$test_number-test):"
+                cat "$test_number-test" || exit 0
+                failed_tests=$(( $failed_tests + 1 ))
+            else
+                passed_test_count=$(( $passed_test_count + 1 ))
+            fi
+            test_number=$((test_number + 1))
+        done
     done
 
-    total_test_count=$((test_number - 1))
-    passed_test_count=$(( $passed_test_count + $total_test_count ))
     echo -e "$BLUE[info]$NC $folder_name: $passed_test_count/$total_test_count tests passed"
 
     cd ".."